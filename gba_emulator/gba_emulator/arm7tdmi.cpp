@@ -1,7235 +1,2525 @@
 #pragma once
 
 
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 #include "arm7tdmi.hpp"
+#include "arm7tdmi_decode.hpp"
+#include "arm7tdmi_shift.hpp"
 
+#if GBA_MMAP_ROM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-//instruction bit[31:28]
-#define COND_EQ             (0x0)     //Z set                         equal
-#define COND_NE             (0x1)     //Z clear                     not equal
-#define COND_CS             (0x2)     //C set                       unsigned higher or same
-#define COND_CC             (0x3)     //C clear                     unsigned lower
-#define COND_MI             (0x4)     //N set                       negative
-#define COND_PL             (0x5)     //N clear                     positive or zero
-#define COND_VS             (0x6)     //V set                       overflow
-#define COND_VC             (0x7)     //V clear                     no overflow
-#define COND_HI             (0x8)     //C set and Z clear           unsigned higher
-#define COND_LS             (0x9)     //C clear or Z set            unsigned lower or same
-#define COND_GE             (0xA)     //N equals V                  greater or equal
-#define COND_LT             (0xB)     //N not equal to V            less than
-#define COND_GT             (0xC)     //Z clear AND (N equals V)    greater than
-#define COND_LE             (0xD)     //Z set OR (N not equal to V) less than or equal
-#define COND_AL             (0xE)     //(ignored)                   always
-
-//instruction bit[6:5]
-#define LSL     (0x0)     //logical left
-#define LSR     (0x1)     //logical right
-#define ASR     (0x2)     //arithmetic right
-#define ROR     (0x3)     //rotate right
-
-//instruction bit[4]
-#define SHIFT_SOURCE_AMOUNT   (0x0)
-#define SHIFT_SOURCE_REGSITER (0x1)
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if GBA_FASTMEM
+#include <atomic>
+#include <mutex>
+#include <signal.h>
+#include <ucontext.h>
+#endif
 
 
 //class GBA_EMUALTOR_ARM7TDMI;
 
 
-U32 GBA_EMUALTOR_ARM7TDMI::get_shifted_operand2(INSTRUCTION_FORMAT *instruction_ptr)
+//bit[NZCV] of condition_table[cond] is set when cond passes with those flags
+static constexpr U16 condition_entry(U32 cond)
 {
-    U32 source_operand2;
-    U32 shifted_operand2;
-    U16 shift_amount;
-    U8 new_carry;
-    
-    //get shift amount
-    if (instruction_ptr->data_proc.operand2.shift.register_or_amount == SHIFT_SOURCE_REGSITER)
-    {
-        //4.4.5 Using R15 as an operand
-        if (instruction_ptr->data_proc.operand2.shift.shift_reg == 15) 
+    U16 entry = 0;
+
+    for (U32 nzcv = 0; nzcv < 16; nzcv++)
+    {
+        bool N = (nzcv >> 3) & 0x1;
+        bool Z = (nzcv >> 2) & 0x1;
+        bool C = (nzcv >> 1) & 0x1;
+        bool V = nzcv & 0x1;
+        bool pass = false;
+
+        switch (cond)
         {
-            shift_amount = (this->R[instruction_ptr->data_proc.operand2.shift.shift_reg] + 12) & 0xFF;
+            case COND_EQ: pass = Z;                 break;
+            case COND_NE: pass = !Z;                break;
+            case COND_CS: pass = C;                 break;
+            case COND_CC: pass = !C;                break;
+            case COND_MI: pass = N;                 break;
+            case COND_PL: pass = !N;                break;
+            case COND_VS: pass = V;                 break;
+            case COND_VC: pass = !V;                break;
+            case COND_HI: pass = C && !Z;           break;
+            case COND_LS: pass = !C || Z;           break;
+            case COND_GE: pass = N == V;            break;
+            case COND_LT: pass = N != V;            break;
+            case COND_GT: pass = !Z && (N == V);    break;
+            case COND_LE: pass = Z || (N != V);     break;
+            case COND_AL: pass = true;              break;
+            default:      pass = false;             break;   //0xF : never
         }
-        else 
+
+        if (pass)
         {
-            shift_amount = this->R[instruction_ptr->data_proc.operand2.shift.shift_reg] & 0xFF;
+            entry |= 1 << nzcv;
         }
     }
-    else 
-    {
-        shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    }
+    return entry;
+}
 
+//16 conditions x 16 NZCV combinations, one load and one shift per check
+static constexpr U16 condition_table[16] =
+{
+    condition_entry(0x0), condition_entry(0x1), condition_entry(0x2), condition_entry(0x3),
+    condition_entry(0x4), condition_entry(0x5), condition_entry(0x6), condition_entry(0x7),
+    condition_entry(0x8), condition_entry(0x9), condition_entry(0xA), condition_entry(0xB),
+    condition_entry(0xC), condition_entry(0xD), condition_entry(0xE), condition_entry(0xF),
+};
 
-    //4.4.5 Using R15 as an operand
-    if(instruction_ptr->data_proc.operand2.Rm == 15)
-    {
-        source_operand2 = this->R[instruction_ptr->data_proc.operand2.Rm] + 8;
-    }
-    else 
-    {
-        source_operand2 = this->R[instruction_ptr->data_proc.operand2.Rm];
-    }
-    
-    
-    switch (instruction_ptr->data_proc.operand2.shift.shift_type)
-    {
-        case LSL:
-            shifted_operand2 = source_operand2 << shift_amount;
-            //only LSL #0 carry out is the old value of the CPSR C
-            if (shift_amount == 0) 
-            {
-            }
-            else if (shift_amount > 32) 
-            {
-                this->CPSR_usr.C = 0;
-            }
-            else //if (shift_amount != 0) 
-            {
-                this->CPSR_usr.C = (source_operand2 >> (32 - shift_amount)) & 0x1;
-            }
-            break;
-        case LSR:
-            shifted_operand2 = source_operand2 >> shift_amount;
+static_assert(condition_table[COND_AL] == 0xFFFF && condition_table[0xF] == 0x0000, "condition table");
+static_assert(condition_table[COND_EQ] == 0xF0F0 && condition_table[COND_GE] == 0xAA55, "condition table");
 
-            if (shift_amount == 0)
-            {
-                while (1);
-            }
-            else if (shift_amount > 32)
-            {
-                this->CPSR_usr.C = 0;
-            }
-            else //if (shift_amount != 0) 
-            {
-                this->CPSR_usr.C = (source_operand2 >> (shift_amount - 1)) & 0x1;
-            }
-            break;
-        case ASR:
-            if (shift_amount == 0) 
-            {
-                shift_amount = 32;
-            }
-            shifted_operand2 = (U32)(((S32)source_operand2) >> shift_amount);
-            this->CPSR_usr.C = (source_operand2 >> (shift_amount - 1)) & 0x1;
-            break;
-        case ROR:
-            if (shift_amount == 0) //actually RRX, rotate right extended
-            {
-                new_carry = source_operand2 & 0x1;
-                shifted_operand2 = source_operand2 >> 1;
-                shifted_operand2 |= ((this->CPSR_usr.C) << 31);
-                this->CPSR_usr.C = new_carry;
-            }
-            else if (shift_amount > 32) 
-            {
-                while (1);
-            }
-            else 
-            {
-                this->CPSR_usr.C = (source_operand2 >> (shift_amount - 1)) & 0x1;
-                shifted_operand2 = source_operand2 >> shift_amount;
-                shifted_operand2 |= source_operand2 << (32 - shift_amount);
-            }
-            break;
-        defalult:
-            while (1);
-            break;
-    }
-    return shifted_operand2;
-}
 
-U32 GBA_EMUALTOR_ARM7TDMI::get_rotated_operand2(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U8  rotate;
-    U32 operand2;
+//built at compile time, see arm7tdmi_decode.hpp
+constexpr GBA_EMUALTOR_ARM7TDMI::ARM_HANDLER_TABLE GBA_EMUALTOR_ARM7TDMI::arm_handler_table = ARM_DECODER::build_table();
 
-    rotate = instruction_ptr->data_proc.operand2.rotate;
-    operand2 = instruction_ptr->data_proc.operand2.imm;
-    operand2 = operand2 >> (rotate * 2);
-    operand2 |= instruction_ptr->data_proc.operand2.imm << (32 - (rotate * 2));
+static_assert(ARM_DECODER::verify_table(GBA_EMUALTOR_ARM7TDMI::arm_handler_table), "ARM handler table does not match the instruction set formats");
 
-    return operand2;
-}
+constexpr GBA_EMUALTOR_ARM7TDMI::THUMB_HANDLER_TABLE GBA_EMUALTOR_ARM7TDMI::thumb_handler_table = THUMB_DECODER::build_table();
 
+static_assert(THUMB_DECODER::verify_table(GBA_EMUALTOR_ARM7TDMI::thumb_handler_table), "THUMB handler table does not match the instruction set formats");
 
+//R, the flags, cycles and the block table share the first two cache lines
+static_assert(offsetof(GBA_EMUALTOR_ARM7TDMI, block_cache) + sizeof(GBA_EMUALTOR_ARM7TDMI::BLOCK_CACHE) <= 128, "hot CPU state does not fit two cache lines");
 
-void GBA_EMUALTOR_ARM7TDMI::AND(INSTRUCTION_FORMAT *instruction_ptr)
+
+GBA_EMUALTOR_ARM7TDMI::GBA_EMUALTOR_ARM7TDMI()
 {
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
+    for (U32 i = 0; i < NUM_OF_REGISTER; i++)
+    {
+        this->R[i] = 0;
+    }
 
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I) 
+    //reset : supervisor mode, IRQ and FIQ disabled, execution starts at the reset vector in BIOS
+    this->bank = BANK_SVC;
+    set_CPSR(SVC_MODE | BIT(7) | BIT(6));
+    for (U32 i = 0; i < BANK_COUNT; i++)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        this->banked_R13_R14[i][0] = 0;
+        this->banked_R13_R14[i][1] = 0;
+        this->SPSR_bank[i].val = 0;
     }
-    //operand2 is a rgister
-    else 
+    for (U32 i = 0; i < 5; i++)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        this->banked_R8_R12[i] = 0;
     }
+    this->cycles = 0;
 
-    this->R[Rd] = this->R[Rn] & operand2;
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
+    this->block_drop_hook = NULL;
+    this->block_drop_context = NULL;
+    this->block_cache.blocks = (BLOCK*)MEMORY::allocate(BLOCK_CACHE_SIZE * sizeof(BLOCK));
+    this->block_cache.blocks[0].pc = BLOCK_INVALID;
+    for (U32 i = 0; i < DIRTY_WORDS * 32; i++)
+    {
+        this->granule_blocks[i] = 0;
+    }
+    flush_block_cache();
+    this->block_cache.hits = 0;
+    this->block_cache.misses = 0;
+    this->block_cache.invalidations = 0;
+    this->block_cache.code_writes = 0;
+    this->memory.write_hook = memory_write_hook;
+    this->memory.write_hook_context = this;
+    this->rom_mapping = NULL;
+    this->rom_file = -1;
 }
 
-void GBA_EMUALTOR_ARM7TDMI::EOR(INSTRUCTION_FORMAT *instruction_ptr)
+GBA_EMUALTOR_ARM7TDMI::~GBA_EMUALTOR_ARM7TDMI()
 {
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
-
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+#if GBA_MMAP_ROM
+    if (this->rom_mapping)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        munmap(this->rom_mapping, CARTRIDGE_ROM_WAIT_STATE_0_SIZE);
     }
-    //operand2 is a rgister
-    else
+    if (this->rom_file >= 0)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        close(this->rom_file);
     }
-
-    this->R[Rd] = this->R[Rn] ^ operand2;
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
+#else
+    MEMORY::release(this->rom_mapping, CARTRIDGE_ROM_WAIT_STATE_0_SIZE);
+#endif
+    MEMORY::release((U8*)this->block_cache.blocks, BLOCK_CACHE_SIZE * sizeof(BLOCK));
 }
-void GBA_EMUALTOR_ARM7TDMI::SUB(INSTRUCTION_FORMAT *instruction_ptr)
+
+
+//the file is mapped MAP_PRIVATE over a read only anonymous reservation of the
+//whole game pak area, so nothing is copied, instances running the same ROM
+//share its page cache pages, and reads past the end of a short ROM see zeros
+//instead of SIGBUS
+bool GBA_EMUALTOR_ARM7TDMI::readROM(std::string filename)
 {
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
+#if GBA_MMAP_ROM
+    struct stat info;
+    void *area;
+    int fd = open(filename.c_str(), O_RDONLY);
 
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+    if (fd < 0)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        printf("can not open ROM : %s\n", filename.c_str());
+        return false;
     }
-    //operand2 is a rgister
-    else
+    if (fstat(fd, &info) != 0 || info.st_size == 0 || info.st_size > CARTRIDGE_ROM_WAIT_STATE_0_SIZE)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        printf("bad ROM size : %s\n", filename.c_str());
+        close(fd);
+        return false;
     }
 
-    this->R[Rd] = this->R[Rn] - operand2;
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
-}
-void GBA_EMUALTOR_ARM7TDMI::RSB(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
-
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+    area = mmap(NULL, CARTRIDGE_ROM_WAIT_STATE_0_SIZE, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        printf("can not reserve the game pak area\n");
+        close(fd);
+        return false;
     }
-    //operand2 is a rgister
-    else
+    if (mmap(area, info.st_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        printf("can not map ROM : %s\n", filename.c_str());
+        munmap(area, CARTRIDGE_ROM_WAIT_STATE_0_SIZE);
+        close(fd);
+        return false;
     }
 
-    this->R[Rd] = operand2 - this->R[Rn];
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
-}
-void GBA_EMUALTOR_ARM7TDMI::ADD(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
+    madvise(area, info.st_size, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+    madvise(area, info.st_size, MADV_HUGEPAGE);
+#endif
 
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+    if (this->rom_mapping)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        munmap(this->rom_mapping, CARTRIDGE_ROM_WAIT_STATE_0_SIZE);
+        close(this->rom_file);
     }
-    //operand2 is a rgister
-    else
+    this->rom_mapping = (U8*)area;
+    this->rom_file = fd;
+    this->memory.map_rom(this->rom_mapping, this->rom_file);
+#else
+    std::ifstream fin(filename.c_str(), std::ios::binary | std::ios::in | std::ios::ate);
+    std::streamoff size = fin.tellg();
+    U8 *rom;
+
+    if (!fin || size <= 0 || size > CARTRIDGE_ROM_WAIT_STATE_0_SIZE)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        printf("can not load ROM : %s\n", filename.c_str());
+        return false;
     }
 
-    this->R[Rd] = this->R[Rn] + operand2;
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
-}
-void GBA_EMUALTOR_ARM7TDMI::ADC(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
-
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+    //a fresh area per ROM reads zeros past its end, and only the pages the
+    //file fills become resident
+    rom = MEMORY::allocate(CARTRIDGE_ROM_WAIT_STATE_0_SIZE);
+    if (rom == NULL)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        return false;
     }
-    //operand2 is a rgister
-    else
+
+    fin.seekg(0);
+    fin.read((char*)rom, size);
+    if (!fin)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        printf("can not read ROM : %s\n", filename.c_str());
+        MEMORY::release(rom, CARTRIDGE_ROM_WAIT_STATE_0_SIZE);
+        return false;
     }
 
-    this->R[Rd] = this->R[Rn] + operand2 + this->CPSR_usr.C;
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
+    MEMORY::release(this->rom_mapping, CARTRIDGE_ROM_WAIT_STATE_0_SIZE);
+    this->rom_mapping = rom;
+    this->memory.map_rom(this->rom_mapping);
+#endif
+
+    //blocks cached from the previous ROM
+    flush_block_cache();
+    return true;
 }
-void GBA_EMUALTOR_ARM7TDMI::SBC(INSTRUCTION_FORMAT *instruction_ptr)
+
+
+#if GBA_FASTMEM
+//instances with fastmem on, searched by the fault handler
+static std::atomic<MEMORY*> fastmem_windows[FASTMEM_MAX_WINDOWS];
+static struct sigaction     fastmem_previous;
+static std::once_flag       fastmem_installed;
+
+//greg_t index of each x86-64 register number
+static const int fastmem_gregs[16] =
 {
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
+    REG_RAX, REG_RCX, REG_RDX, REG_RBX, REG_RSP, REG_RBP, REG_RSI, REG_RDI,
+    REG_R8,  REG_R9,  REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15,
+};
+
+//a faulting guest access, one of the loads read() compiles to or a store :
+//88/89/8A/8B mov, C6/C7 mov with an immediate, 0F B6/B7/BE/BF movzx/movsx,
+//with an optional 66 operand size prefix and REX
+typedef struct fastmem_access
+{
+    U32  size;          //bytes accessed
+    U32  width;         //bytes of the register a load writes
+    bool store;
+    bool sign;          //movsx
+    bool immediate;     //store of value instead of a register
+    bool high_byte;     //AH, CH, DH or BH
+    U32  reg;
+    U32  value;
+    U32  length;        //instruction bytes
+}FASTMEM_ACCESS;
+
+static bool fastmem_decode(const U8 *code, FASTMEM_ACCESS *access)
+{
+    const U8 *p = code;
+    U32 operand = 4;
+    U8  rex = 0;
+    U8  opcode, modrm, mod, sib;
 
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+    if (*p == 0x66)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        operand = 2;
+        p++;
     }
-    //operand2 is a rgister
-    else
+    if ((*p & 0xF0) == 0x40)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        rex = *p++;
+    }
+    if (rex & 0x8)
+    {
+        return false;   //REX.W, the accessors never move 64 bits
     }
 
-    this->R[Rd] = this->R[Rn] - operand2 + this->CPSR_usr.C - 1;
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
-}
-void GBA_EMUALTOR_ARM7TDMI::RSC(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
+    access->store = false;
+    access->sign = false;
+    access->immediate = false;
+    opcode = *p++;
+    switch (opcode)
+    {
+        case 0x88: access->store = true; access->size = 1;       break;
+        case 0x89: access->store = true; access->size = operand; break;
+        case 0x8A: access->size = 1;       access->width = 1;       break;
+        case 0x8B: access->size = operand; access->width = operand; break;
+        case 0xC6: access->store = true; access->immediate = true; access->size = 1;       break;
+        case 0xC7: access->store = true; access->immediate = true; access->size = operand; break;
+        case 0x0F:
+            opcode = *p++;
+            if ((opcode & 0xF6) != 0xB6)
+            {
+                return false;
+            }
+            access->size = (opcode & 0x1) ? 2 : 1;
+            access->width = operand;
+            access->sign = (opcode & 0x8) != 0;
+            break;
+        default:
+            return false;
+    }
 
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+    //ModRM, a memory operand with an optional SIB byte and displacement
+    modrm = *p++;
+    mod = modrm >> 6;
+    if (mod == 3)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        return false;
     }
-    //operand2 is a rgister
-    else
+    if ((modrm & 0x7) == 4)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        sib = *p++;
+        if (mod == 0 && (sib & 0x7) == 5)
+        {
+            p += 4;     //no base
+        }
     }
-
-    this->R[Rd] = operand2 - this->R[Rn] + this->CPSR_usr.C - 1;
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
-}
-void GBA_EMUALTOR_ARM7TDMI::TST(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
-    U32 Rd_value_tmp;
-
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+    else if (mod == 0 && (modrm & 0x7) == 5)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        p += 4;         //RIP relative
     }
-    //operand2 is a rgister
-    else
+    p += (mod == 1) ? 1 : (mod == 2) ? 4 : 0;
+
+    //without REX, byte registers 4-7 are AH, CH, DH, BH
+    access->reg = ((modrm >> 3) & 0x7) | ((rex & 0x4) ? 8 : 0);
+    access->high_byte = (opcode == 0x88 || opcode == 0x8A) && rex == 0 && access->reg >= 4;
+    if (access->high_byte)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        access->reg -= 4;
     }
 
-    Rd_value_tmp = this->R[Rn] & operand2;
-    update_CPSR_flags(instruction_ptr, Rd_value_tmp);
+    if (access->immediate)
+    {
+        access->value = (access->size == 1) ? p[0] : (access->size == 2) ? (U32)(p[0] | (p[1] << 8)) : *(const U32*)p;
+        p += access->size;
+    }
+    access->length = (U32)(p - code);
+    return true;
 }
-void GBA_EMUALTOR_ARM7TDMI::TEQ(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
-    U32 Rd_value_tmp;
 
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+//a fault outside of every window goes on to whatever handled SIGSEGV before
+static void fastmem_forward(int signal_number, siginfo_t *info, void *context)
+{
+    if (fastmem_previous.sa_flags & SA_SIGINFO)
+    {
+        fastmem_previous.sa_sigaction(signal_number, info, context);
+    }
+    else if (fastmem_previous.sa_handler != SIG_DFL && fastmem_previous.sa_handler != SIG_IGN)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        fastmem_previous.sa_handler(signal_number);
     }
-    //operand2 is a rgister
     else
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        //the instruction faults again and takes the default action
+        signal(SIGSEGV, SIG_DFL);
     }
-
-    Rd_value_tmp = this->R[Rn] ^ operand2;
-    update_CPSR_flags(instruction_ptr, Rd_value_tmp);
 }
-void GBA_EMUALTOR_ARM7TDMI::CMP(INSTRUCTION_FORMAT *instruction_ptr)
+
+//the fault is synchronous to a read() of the emulation thread, so
+//running the handlers from here is like calling them at that point. nothing
+//on this path may print, see MEMORY::fastmem_faulting
+static void fastmem_fault(int signal_number, siginfo_t *info, void *context)
 {
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
-    U32 Rd_value_tmp;
+    ucontext_t    *state = (ucontext_t*)context;
+    greg_t        *gregs = state->uc_mcontext.gregs;
+    U8            *address = (U8*)info->si_addr;
+    MEMORY        *memory = NULL;
+    FASTMEM_ACCESS access;
+    U32            idx;
 
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+    for (U32 i = 0; i < FASTMEM_MAX_WINDOWS && memory == NULL; i++)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        MEMORY *candidate = fastmem_windows[i].load(std::memory_order_acquire);
+
+        if (candidate && address >= candidate->fastmem && address < candidate->fastmem + FASTMEM_WINDOW_SIZE)
+        {
+            memory = candidate;
+        }
     }
-    //operand2 is a rgister
-    else
+    if (memory == NULL)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        fastmem_forward(signal_number, info, context);
+        return;
     }
+    if (!fastmem_decode((const U8*)gregs[REG_RIP], &access))
+    {
+        static const char message[] = "fastmem : can not emulate the access\n";
+        ssize_t written = write(STDERR_FILENO, message, sizeof(message) - 1);
 
-    Rd_value_tmp = this->R[Rn] - operand2;
-    update_CPSR_flags(instruction_ptr, Rd_value_tmp);
-}
-void GBA_EMUALTOR_ARM7TDMI::CMN(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
-    U32 Rd_value_tmp;
+        (void)written;
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
 
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+    idx = (U32)(address - memory->fastmem);
+    greg_t &reg = gregs[fastmem_gregs[access.reg]];
+    memory->fastmem_faulting = true;
+    if (access.store)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        U32 value = access.immediate ? access.value : (U32)((unsigned long long)reg >> (access.high_byte ? 8 : 0));
+
+        switch (access.size)
+        {
+            case 1:  memory->write_paged<U8>(idx, (U8)value);   break;
+            case 2:  memory->write_paged<U16>(idx, (U16)value); break;
+            default: memory->write_paged<U32>(idx, value);      break;
+        }
     }
-    //operand2 is a rgister
     else
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        U32 value;
+
+        switch (access.size)
+        {
+            case 1:  value = access.sign ? (U32)(S32)(S8)memory->read_paged<U8>(idx)   : memory->read_paged<U8>(idx);  break;
+            case 2:  value = access.sign ? (U32)(S32)(S16)memory->read_paged<U16>(idx) : memory->read_paged<U16>(idx); break;
+            default: value = memory->read_paged<U32>(idx); break;
+        }
+
+        //a 32 bit destination zero extends to 64 bits, narrower ones merge
+        switch (access.width)
+        {
+            case 1:
+                if (access.high_byte)
+                {
+                    reg = (reg & ~(greg_t)0xFF00) | (greg_t)((value & 0xFF) << 8);
+                }
+                else
+                {
+                    reg = (reg & ~(greg_t)0xFF) | (greg_t)(value & 0xFF);
+                }
+                break;
+            case 2:
+                reg = (reg & ~(greg_t)0xFFFF) | (greg_t)(value & 0xFFFF);
+                break;
+            default:
+                reg = (greg_t)value;
+                break;
+        }
     }
+    memory->fastmem_faulting = false;
+    gregs[REG_RIP] += access.length;
+}
+
+static bool page_is_zero(const U8 *page)
+{
+    const unsigned long long *words = (const unsigned long long*)page;
 
-    Rd_value_tmp = this->R[Rn] + operand2;
-    update_CPSR_flags(instruction_ptr, Rd_value_tmp);
+    for (U32 i = 0; i < MEMORY_PAGE_SIZE / 8; i++)
+    {
+        if (words[i])
+        {
+            return false;
+        }
+    }
+    return true;
 }
+#endif
 
+U8 MEMORY::empty_cartridge[CARTRIDGE_ROM_WAIT_STATE_0_SIZE];
 
-void GBA_EMUALTOR_ARM7TDMI::ORR(INSTRUCTION_FORMAT *instruction_ptr)
+//fresh anonymous pages on every host, their contents start out zero
+U8 *MEMORY::allocate(U32 size)
 {
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
+    void *data;
 
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+#if GBA_MMAP_ROM
+    data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        data = NULL;
     }
-    //operand2 is a rgister
-    else
+#elif defined(_WIN32)
+    data = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    data = calloc(1, size);
+#endif
+    if (data == NULL)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        printf("can not allocate %u bytes\n", size);
     }
-
-    this->R[Rd] = this->R[Rn] | operand2;
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
+    return (U8*)data;
 }
 
-
-void GBA_EMUALTOR_ARM7TDMI::MOV(INSTRUCTION_FORMAT *instruction_ptr)
+void MEMORY::release(U8 *data, U32 size)
 {
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
-
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+    if (data == NULL)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        return;
     }
-    //operand2 is a rgister
-    else
+#if GBA_MMAP_ROM
+    munmap(data, size);
+#elif defined(_WIN32)
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    free(data);
+#endif
+}
+
+//raw_data up to FASTMEM_SHARED_SIZE moves into a memfd mapped back over it,
+//so every pointer into raw_data stays valid, and the window maps the same
+//memfd pages at each guest address whose page points there
+bool MEMORY::enable_fastmem()
+{
+#if GBA_FASTMEM
+    U8 *window;
+    int file;
+
+    if (this->fastmem)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        return true;
     }
 
-    this->R[Rd] =  operand2;
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
-}
+    std::call_once(fastmem_installed, []
+    {
+        struct sigaction action;
 
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = fastmem_fault;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGSEGV, &action, &fastmem_previous);
+    });
 
-void GBA_EMUALTOR_ARM7TDMI::BIC(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
+    file = memfd_create("gba_memory", MFD_CLOEXEC);
+    if (file < 0 || ftruncate(file, FASTMEM_SHARED_SIZE) != 0)
+    {
+        printf("fastmem : can not create the memory file\n");
+        if (file >= 0)
+        {
+            close(file);
+        }
+        return false;
+    }
 
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+    //all zero pages stay holes in the file
+    for (U32 offset = 0; offset < FASTMEM_SHARED_SIZE; offset += MEMORY_PAGE_SIZE)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        if (!page_is_zero(&this->raw_data[offset]) && pwrite(file, &this->raw_data[offset], MEMORY_PAGE_SIZE, offset) != MEMORY_PAGE_SIZE)
+        {
+            printf("fastmem : can not fill the memory file\n");
+            close(file);
+            return false;
+        }
     }
-    //operand2 is a rgister
-    else
+    if (mmap(this->raw_data, FASTMEM_SHARED_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, file, 0) == MAP_FAILED)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        printf("fastmem : can not map the memory file\n");
+        close(file);
+        return false;
     }
 
-    this->R[Rd] = this->R[Rn] & (~operand2);
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
-}
+    window = (U8*)mmap(NULL, FASTMEM_WINDOW_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (window == MAP_FAILED)
+    {
+        printf("fastmem : can not reserve the window\n");
+        close(file);
+        return false;
+    }
+    this->fastmem = window;
+    this->fastmem_file = file;
+    fastmem_share_rom();
+    fastmem_map(0, MEMORY_PAGE_COUNT * MEMORY_PAGE_SIZE);
 
+    for (U32 i = 0; i < FASTMEM_MAX_WINDOWS; i++)
+    {
+        MEMORY *expected = NULL;
 
+        if (fastmem_windows[i].compare_exchange_strong(expected, this, std::memory_order_release))
+        {
+            return true;
+        }
+    }
+    printf("fastmem : more than %d windows\n", FASTMEM_MAX_WINDOWS);
+    disable_fastmem();
+    return false;
+#else
+    return false;
+#endif
+}
 
-void GBA_EMUALTOR_ARM7TDMI::MVN(INSTRUCTION_FORMAT *instruction_ptr)
+//raw_data keeps its memfd mapping, the pages behave like the private ones
+//until release() unmaps them
+void MEMORY::disable_fastmem()
 {
-    U8 Rn = instruction_ptr->data_proc.Rn;
-    U8 Rd = instruction_ptr->data_proc.Rd;
-    U32 operand2;
+#if GBA_FASTMEM
+    if (this->fastmem == NULL)
+    {
+        return;
+    }
 
-    //operand2 is an immediate value
-    if (instruction_ptr->data_proc.I)
+    for (U32 i = 0; i < FASTMEM_MAX_WINDOWS; i++)
     {
-        operand2 = get_rotated_operand2(instruction_ptr);
+        MEMORY *expected = this;
+
+        fastmem_windows[i].compare_exchange_strong(expected, NULL);
     }
-    //operand2 is a rgister
-    else
+    munmap(this->fastmem, FASTMEM_WINDOW_SIZE);
+    close(this->fastmem_file);
+    if (this->fastmem_rom_file >= 0)
     {
-        operand2 = get_shifted_operand2(instruction_ptr);
+        close(this->fastmem_rom_file);
     }
+    this->fastmem = NULL;
+    this->fastmem_file = -1;
+    this->fastmem_rom_file = -1;
+    this->fastmem_rom = NULL;
+#endif
+}
 
-    this->R[Rd] = ~operand2;
+//like raw_data, the copy moves into a memfd mapped back over it, so pointers
+//into it stay valid. a file mapping and empty_cartridge need no file, a
+//failure leaves the copy to the fault handler
+void MEMORY::fastmem_share_rom()
+{
+#if GBA_FASTMEM
+    int file;
 
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
+    if (this->rom == this->fastmem_rom)
+    {
+        return;
+    }
+    if (this->fastmem_rom_file >= 0)
+    {
+        close(this->fastmem_rom_file);
+        this->fastmem_rom_file = -1;
+        this->fastmem_rom = NULL;
+    }
+    if (this->rom_file >= 0 || this->rom == empty_cartridge)
+    {
+        return;
+    }
 
-    if (Rd == 15) 
+    file = memfd_create("gba_rom", MFD_CLOEXEC);
+    if (file < 0 || ftruncate(file, CARTRIDGE_ROM_WAIT_STATE_0_SIZE) != 0)
+    {
+        printf("fastmem : can not create the ROM file\n");
+        if (file >= 0)
+        {
+            close(file);
+        }
+        return;
+    }
+    for (U32 offset = 0; offset < CARTRIDGE_ROM_WAIT_STATE_0_SIZE; offset += MEMORY_PAGE_SIZE)
+    {
+        if (!page_is_zero(&this->rom[offset]) && pwrite(file, &this->rom[offset], MEMORY_PAGE_SIZE, offset) != MEMORY_PAGE_SIZE)
+        {
+            printf("fastmem : can not fill the ROM file\n");
+            close(file);
+            return;
+        }
+    }
+    if (mmap(this->rom, CARTRIDGE_ROM_WAIT_STATE_0_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, file, 0) == MAP_FAILED)
     {
-        //mode_change()
+        printf("fastmem : can not map the ROM file\n");
+        close(file);
+        return;
     }
+    this->fastmem_rom_file = file;
+    this->fastmem_rom = this->rom;
+#endif
 }
 
-
-void GBA_EMUALTOR_ARM7TDMI::update_CPSR_flags(INSTRUCTION_FORMAT *instruction_ptr, U32 Rd_value)
+//runs of pages with the same backing are mapped with one call. pages of
+//empty_cartridge or past the end of the ROM file, which readROM() leaves
+//zero, are read only zero pages. pages that are NULL, point anywhere but the
+//memfds and the ROM file, or hold the end of the ROM file, are PROT_NONE
+void MEMORY::fastmem_map(U32 base_log, U32 span)
 {
-    if(instruction_ptr->data_proc.S)
+#if GBA_FASTMEM
+    static const int zeros = -2;
+    struct stat info;
+    U8 *rom_end = this->rom;    //end of the ROM file's whole host pages
+    U32 page = base_log >> MEMORY_PAGE_SHIFT;
+    U32 end = page + (span >> MEMORY_PAGE_SHIFT);
+
+    if (this->rom_file >= 0 && fstat(this->rom_file, &info) == 0)
+    {
+        long host_page = sysconf(_SC_PAGESIZE);
+
+        rom_end = this->rom + ((info.st_size + host_page - 1) & ~(host_page - 1));
+    }
+
+    //a memfd, the ROM file, zeros or -1, and the offset into the file
+    auto backing = [&](U32 index, off_t *offset) -> int
+    {
+        U8 *host = this->read_page[index];
+
+        *offset = 0;
+        if (host >= this->raw_data && host < this->raw_data + FASTMEM_SHARED_SIZE)
+        {
+            *offset = host - this->raw_data;
+            return this->fastmem_file;
+        }
+        if (host >= empty_cartridge && host < empty_cartridge + CARTRIDGE_ROM_WAIT_STATE_0_SIZE)
+        {
+            return zeros;
+        }
+        if (host < this->rom || host >= this->rom + CARTRIDGE_ROM_WAIT_STATE_0_SIZE)
+        {
+            return -1;
+        }
+        if (this->rom_file >= 0)
+        {
+            //the page holding the end of the file is left to the handler
+            *offset = host - this->rom;
+            return (host + MEMORY_PAGE_SIZE <= rom_end) ? this->rom_file : (host >= rom_end) ? zeros : -1;
+        }
+        if (this->fastmem_rom_file >= 0 && this->rom == this->fastmem_rom)
+        {
+            *offset = host - this->rom;
+            return this->fastmem_rom_file;
+        }
+        return -1;
+    };
+
+    while (page < end)
     {
-        if (Rd_value == 0)
+        off_t offset, next_offset;
+        int file = backing(page, &offset);
+        bool writable = this->write_page[page] != NULL;
+        U32 count = 1;
+        void *result;
+
+        while (page + count < end && backing(page + count, &next_offset) == file && (this->write_page[page + count] != NULL) == writable &&
+               (file < 0 || next_offset == offset + (off_t)count * MEMORY_PAGE_SIZE))
+        {
+            count++;
+        }
+
+        if (file < 0)
+        {
+            result = mmap(&this->fastmem[page << MEMORY_PAGE_SHIFT], count << MEMORY_PAGE_SHIFT, (file == zeros) ? PROT_READ : PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+        }
+        else
         {
-            this->CPSR_usr.Z = 1;
+            result = mmap(&this->fastmem[page << MEMORY_PAGE_SHIFT], count << MEMORY_PAGE_SHIFT, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                          MAP_SHARED | MAP_FIXED, file, offset);
         }
-        if (Rd_value & BIT(31))
+        if (result == MAP_FAILED)
         {
-            this->CPSR_usr.N = 1;
+            printf("fastmem : can not map %08X\n", page << MEMORY_PAGE_SHIFT);
         }
-        //update C in get_shifted_operand2        
+        page += count;
     }
+#endif
 }
 
 
-//transfer PSR contents to a register
-void GBA_EMUALTOR_ARM7TDMI::MSR(INSTRUCTION_FORMAT *instruction_ptr)
-{    
-    U32 source_content;
-    //0b101000
-    if (instruction_ptr->psr_tsfr.rsv1 == 0x28)//transfer register contents or immdiate value to PSR flag bits only
+//R15 is advanced to the next instruction before the handler runs, so a handler
+//reading R15 sees instruction + 4 (add 4 more for the pipelined instruction + 8),
+//and a handler writing R15 simply branches
+//
+//instructions are executed from the block cache, a block is left early when a
+//handler moves R15 anywhere but the next instruction. the cycle budget is
+//checked between blocks, so a call may overrun it by up to one block. only
+//the last instruction of a block can enter THUMB state, the loop returns to
+//run() then
+void GBA_EMUALTOR_ARM7TDMI::run_loop(U32 cycle_budget)
+{
+    U32 target_cycles = this->cycles + cycle_budget;
+
+    while ((S32)(target_cycles - this->cycles) > 0 && !this->thumb)
+    {
+        execute_block(get_block(this->R[15] & ~0x3));
+    }
+}
+
+//run one cached block through the handlers
+void GBA_EMUALTOR_ARM7TDMI::execute_block(BLOCK *block)
+{
+    U32 next = block->pc;
+
+    //a store may invalidate the block while it runs, length drops to 0
+    for (U32 i = 0; i < block->length; i++)
     {
-        if (instruction_ptr->psr_tsfr.I)//immediate
+        BLOCK_INSTRUCTION *entry = &block->instructions[i];
+
+        next += 4;
+        this->R[15] = next;
+
+        //1S cycle, handlers add their N and I cycles
+        this->cycles += entry->cycles;
+
+        if (!check_condition(ARM_INSTRUCTION::cond(entry->instruction.val)))
         {
-            source_content = instruction_ptr->psr_tsfr.source_operand.imm;
-            source_content = source_content << (instruction_ptr->psr_tsfr.source_operand.rotate * 2);
+            continue;
         }
-        else//source is a register
+
+        (this->*entry->handler)(&entry->instruction);
+
+        if (this->R[15] != next)
         {
-            source_content = this->R[instruction_ptr->psr_tsfr.source_operand.Rm];
+            break;
         }
     }
-    else//0b101001
+}
+
+
+#if GBA_THREADED_DISPATCH
+//same as run_loop(), but every cached instruction jumps straight to the code
+//for the next one through its label, so each DISPATCH_* site has its own
+//indirect jump for the host branch predictor. only the last instruction of a
+//block can write R15 (see ends_block()), so there is no R15 check in between
+void GBA_EMUALTOR_ARM7TDMI::run_threaded(U32 cycle_budget)
+{
+    static void *const labels[] =
     {
-        source_content = this->R[instruction_ptr->psr_tsfr.source_operand.Rm];
-    }
+        &&dispatch_always,
+        &&dispatch_conditional,
+        &&dispatch_always_store,
+        &&dispatch_conditional_store,
+        &&dispatch_end,
+    };
+    U32 target_cycles = this->cycles + cycle_budget;
+    BLOCK *block;
+    BLOCK_INSTRUCTION *entry;
 
-    if (instruction_ptr->psr_tsfr.Ps) //SPSR
+    while ((S32)(target_cycles - this->cycles) > 0 && !this->thumb)
     {
-        switch (this->mode)
+        block = get_block(this->R[15] & ~0x3);
+        if (!block->threaded)
         {
-        case  USR_MODE:
-            //??
-            break;
-        case FIQ_MODE:
-            if (instruction_ptr->psr_tsfr.rsv1 == 0x28)//transfer register contents or immdiate value to PSR flag bits only
-            {
-                this->SPSR_fiq.val = source_content & 0x0000000F;
-            }
-            else
+            for (U32 i = 0; i <= block->length; i++)
             {
-                this->SPSR_fiq.val = source_content;
+                block->instructions[i].label = labels[block->instructions[i].dispatch];
             }
-            break;
-        case IRQ_MODE:
-            if (instruction_ptr->psr_tsfr.rsv1 == 0x28)//transfer register contents or immdiate value to PSR flag bits only
+            block->threaded = 1;
+        }
+
+        this->R[15] = block->pc;
+        entry = &block->instructions[0];
+        goto *entry->label;
+
+    dispatch_always:
+        this->R[15] += 4;
+        this->cycles += entry->cycles;
+        (this->*entry->handler)(&entry->instruction);
+        entry++;
+        goto *entry->label;
+
+    dispatch_conditional:
+        this->R[15] += 4;
+        this->cycles += entry->cycles;
+        if (check_condition(ARM_INSTRUCTION::cond(entry->instruction.val)))
+        {
+            (this->*entry->handler)(&entry->instruction);
+        }
+        entry++;
+        goto *entry->label;
+
+    dispatch_always_store:
+        this->R[15] += 4;
+        this->cycles += entry->cycles;
+        (this->*entry->handler)(&entry->instruction);
+        if (block->length == 0)
+        {
+            continue;
+        }
+        entry++;
+        goto *entry->label;
+
+    dispatch_conditional_store:
+        this->R[15] += 4;
+        this->cycles += entry->cycles;
+        if (check_condition(ARM_INSTRUCTION::cond(entry->instruction.val)))
+        {
+            (this->*entry->handler)(&entry->instruction);
+            if (block->length == 0)
             {
-                this->SPSR_irq.val = source_content & 0x0000000F;
+                continue;
             }
-            else
-            {
-                this->SPSR_irq.val = source_content;
-            }
-            break;
-        case SVC_MODE:
-            if (instruction_ptr->psr_tsfr.rsv1 == 0x28)//transfer register contents or immdiate value to PSR flag bits only
-            {
-                this->SPSR_svc.val = source_content & 0x0000000F;
-            }
-            else
-            {
-                this->SPSR_svc.val = source_content;
-            }
-            break;
-        case ABT_MODE:
-            if (instruction_ptr->psr_tsfr.rsv1 == 0x28)//transfer register contents or immdiate value to PSR flag bits only
-            {
-                this->SPSR_abt.val = source_content & 0x0000000F;
-            }
-            else
-            {
-                this->SPSR_abt.val = source_content;
-            }
-            break;
-        case UND_MODE:
-            if (instruction_ptr->psr_tsfr.rsv1 == 0x28)//transfer register contents or immdiate value to PSR flag bits only
-            {
-                this->SPSR_und.val = source_content & 0x0000000F;
-            }
-            else
-            {
-                this->SPSR_und.val = source_content;
-            }
-            break;
-        case SYS_MODE:
-            //?
-            break;
-        default:
-            while (1);
         }
+        entry++;
+        goto *entry->label;
+
+    dispatch_end:
+        ;
     }
-    else //CPSR
-    {
-        this->SPSR_und.val = source_content;
-    }    
 }
+#endif
 
 
-
-
-//transfer PSR contents to a register
-void GBA_EMUALTOR_ARM7TDMI::MRS(INSTRUCTION_FORMAT *instruction_ptr)
+//THUMB state : halfwords are fetched and dispatched one at a time, there is
+//no block cache for them, so a store into THUMB code needs no invalidation.
+//R15 holds the next halfword while a handler runs (add 2 for the pipelined
+//instruction + 4). a run ends at the first handler that moves R15 anywhere
+//but the next halfword, only then is the T bit looked at, BX and SWI are the
+//only ways out of THUMB state and both branch
+void GBA_EMUALTOR_ARM7TDMI::run_thumb(U32 cycle_budget)
 {
-    U8 Rd = instruction_ptr->psr_tsfr.Rd;
-    if (instruction_ptr->psr_tsfr.Ps == 0) 
-    {
-        this->R[Rd] = this->CPSR_usr.val;
-    }
-    else 
+    U32 target_cycles = this->cycles + cycle_budget;
+
+    while ((S32)(target_cycles - this->cycles) > 0 && this->thumb)
     {
-        switch (this->mode) 
+        U32 next = this->R[15];
+        U32 instruction;
+
+        do
         {
-            case FIQ_MODE:
-                this->R[Rd] = this->SPSR_fiq.val;
-                break;
-            case IRQ_MODE:
-                this->R[Rd] = this->SPSR_irq.val;
-                break;
-            case SVC_MODE:
+            instruction = this->memory.read<U16>(next);
+            next += 2;
+            this->R[15] = next;
 
-                this->R[Rd] = this->SPSR_und.val;
-                break;
-            case ABT_MODE:
+            //1S cycle, handlers add their N and I cycles
+            this->cycles += 1;
 
-                this->R[Rd] = this->SPSR_und.val;
-                break;
-            case UND_MODE:
-                this->R[Rd] = this->SPSR_und.val;
-                break;
-            case SYS_MODE:
-                //?
-                break;
-            default:
-                while (1);            
-        }
+            (this->*thumb_handler_table.handler[THUMB_DECODER::index_of(instruction)])(instruction);
+        } while (this->R[15] == next && (S32)(target_cycles - this->cycles) > 0);
     }
 }
 
 
-
-void GBA_EMUALTOR_ARM7TDMI::MUL(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U8 Rd = instruction_ptr->multply.Rd;
-    U8 Rm = instruction_ptr->multply.Rm;
-    U8 Rs = instruction_ptr->multply.Rs;
-
-    this->R[Rd] = this->R[Rm] * this->R[Rs];
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
-}
-
-void GBA_EMUALTOR_ARM7TDMI::MLA(INSTRUCTION_FORMAT *instruction_ptr)
+bool GBA_EMUALTOR_ARM7TDMI::check_condition(U32 cond)
 {
-    U8 Rd = instruction_ptr->multply.Rd;
-    U8 Rm = instruction_ptr->multply.Rm;
-    U8 Rs = instruction_ptr->multply.Rs;
-    U8 Rn = instruction_ptr->multply.Rn;
-
-    this->R[Rd] = this->R[Rm] * this->R[Rs] + this->R[Rn];
-    update_CPSR_flags(instruction_ptr, this->R[Rd]);
+    return (condition_table[cond] >> flag_NZCV()) & 0x1;
 }
 
 
-
-
-void GBA_EMUALTOR_ARM7TDMI::MULL(INSTRUCTION_FORMAT *instruction_ptr)
+U32 GBA_EMUALTOR_ARM7TDMI::get_CPSR()
 {
-    U64 result;
-    U8  RdHi = instruction_ptr->multply_long.RdHi;
-    U8  RdLo = instruction_ptr->multply_long.RdLo;
-    U8  Rm   = instruction_ptr->multply_long.Rm;
-    U8  Rs   = instruction_ptr->multply_long.Rs;
-
-    result = (U64)this->R[Rm] * (U64)this->R[Rs];
-    this->R[RdHi] = result >> 32;
-    this->R[RdLo] = result & 0xFFFFFFFF;
+    return (flag_NZCV() << 28) | (this->irq_disable << 7) | (this->fiq_disable << 6) | (this->thumb << 5) | this->mode;
 }
 
-void GBA_EMUALTOR_ARM7TDMI::MLAL(INSTRUCTION_FORMAT *instruction_ptr)
+void GBA_EMUALTOR_ARM7TDMI::set_CPSR(U32 value)
 {
-    U64 result;
-    U64 accumulate;
-    U8  RdHi = instruction_ptr->multply_long.RdHi;
-    U8  RdLo = instruction_ptr->multply_long.RdLo;
-    U8  Rm = instruction_ptr->multply_long.Rm;
-    U8  Rs = instruction_ptr->multply_long.Rs;
-
-    accumulate = ((U64)this->R[RdHi]) << 32 | ((U64)this->R[RdLo]);
-    result = (U64)this->R[Rm] * (U64)this->R[Rs] + accumulate;
-
-    this->R[RdHi] = result >> 32;
-    this->R[RdLo] = result & 0xFFFFFFFF;
+    this->flags.result   = value & BIT(31);
+    this->flags.zero     = !(value & BIT(30));
+    this->flags.carry    = (value >> 29) & 0x1;
+    this->flags.overflow = value << 3;
+    this->irq_disable    = (value >> 7) & 0x1;
+    this->fiq_disable    = (value >> 6) & 0x1;
+    this->thumb          = (value >> 5) & 0x1;
+    switch_mode(value & 0x1F);
 }
 
 
-void GBA_EMUALTOR_ARM7TDMI::LDR(INSTRUCTION_FORMAT *instruction_ptr)
+//branches, SWI, undefined instructions and anything that may write R15 end a block
+static bool ends_block(U32 instruction)
 {
-    U8 Rd = instruction_ptr->single_data_tsf.Rd;
-    U8 Rn = instruction_ptr->single_data_tsf.Rn;
-    U16 offset;
-    U32 base_addr;
-
-
-    base_addr = this->R[Rn];
-
-    if (instruction_ptr->single_data_tsf.I) 
-    {
-        offset = instruction_ptr->single_data_tsf.offset;
-    }
-    else 
+    //UND() branches to the vector, whatever the format
+    if (GBA_EMUALTOR_ARM7TDMI::arm_handler_table.handler[ARM_DECODER::index_of(instruction)] == &GBA_EMUALTOR_ARM7TDMI::UND)
     {
-        offset = get_shifted_operand2(instruction_ptr);
+        return true;
     }
 
-    if (instruction_ptr->single_data_tsf.P == 1) 
+    switch (ARM_INSTRUCTION::group(instruction))
     {
-        if (instruction_ptr->single_data_tsf.U == 1)
-        {
-            base_addr = base_addr + offset;
-        }
-        else 
-        {
-            base_addr = base_addr - offset;
-        }
+        case 0x0:   //data processing, BX, multiply, swap, halfword transfer
+        case 0x1:
+            return (ARM_DATA_PROC::Rd(instruction) == 15) || ((instruction & 0x0FFFFFF0) == 0x012FFF10);
+        case 0x2:   //single data transfer
+        case 0x3:
+            return (ARM_SINGLE_TRANSFER::Rd(instruction) == 15) || (ARM_SINGLE_TRANSFER::I(instruction) && (instruction & BIT(4)));
+        case 0x4:   //block data transfer
+            return ARM_BLOCK_TRANSFER::L(instruction) && (ARM_BLOCK_TRANSFER::register_list(instruction) & BIT(15));
+        default:    //branch, coprocessor, SWI
+            return true;
     }
+}
 
-    if (instruction_ptr->single_data_tsf.B == 1) 
-    {
-        this->R[Rn] = *((U8*)base_addr);
-    }
-    else 
-    {
-        this->R[Rn] = *((U32*)base_addr);
-    }
 
-    if (instruction_ptr->single_data_tsf.P == 0)
+//single data transfer with L clear, block data transfer with L clear, and the
+//multiply/swap/halfword transfer space, which holds SWP and STRH
+static bool may_store(U32 instruction)
+{
+    switch (ARM_INSTRUCTION::group(instruction))
     {
-        if (instruction_ptr->single_data_tsf.U == 1)
-        {
-            base_addr = base_addr + offset;
-        }
-        else
-        {
-            base_addr = base_addr - offset;
-        }
+        case 0x0:
+            return (instruction & BIT(7)) && (instruction & BIT(4));
+        case 0x2:
+        case 0x3:
+            return !ARM_SINGLE_TRANSFER::L(instruction);
+        case 0x4:
+            return !ARM_BLOCK_TRANSFER::L(instruction);
+        default:
+            return false;
     }
+}
 
-    if (instruction_ptr->single_data_tsf.W == 1)
+
+//direct mapped on bit[10:2] of the PC, a miss decodes the block over the old one
+GBA_EMUALTOR_ARM7TDMI::BLOCK *GBA_EMUALTOR_ARM7TDMI::get_block(U32 pc)
+{
+    BLOCK *block = &this->block_cache.blocks[(pc >> 2) & (BLOCK_CACHE_SIZE - 1)];
+
+    if (block->pc == pc)
     {
-        this->R[Rn] = base_addr;
+        this->block_cache.hits++;
+        return block;
     }
+
+    this->block_cache.misses++;
+    decode_block(block, pc);
+    return block;
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STR(INSTRUCTION_FORMAT *instruction_ptr)
+//a WRAM block ends at the end of its granule, so it has one code bit
+void GBA_EMUALTOR_ARM7TDMI::decode_block(BLOCK *block, U32 pc)
 {
-    U8 Rd = instruction_ptr->single_data_tsf.Rd;
-    U8 Rn = instruction_ptr->single_data_tsf.Rn;
-    U16 offset;
-    U32 base_addr;
+    U32 instruction;
+    bool wram = ((pc & 0x0F000000) == ON_BOARD_WRAM_BASE_LOG) || ((pc & 0x0F000000) == ON_CHIP_WRAM_BASE_LOG);
 
+    drop_block_code(block);
+    untrack_block(block);
+    block->pc = pc;
+    block->length = 0;
 
-    base_addr = this->R[Rn];
-
-    if (instruction_ptr->single_data_tsf.I)
-    {
-        offset = instruction_ptr->single_data_tsf.offset;
-    }
-    else
+    do
     {
-        offset = get_shifted_operand2(instruction_ptr);
-    }
+        BLOCK_INSTRUCTION *entry = &block->instructions[block->length];
 
-    if (instruction_ptr->single_data_tsf.P == 1)
-    {
-        if (instruction_ptr->single_data_tsf.U == 1)
-        {
-            base_addr = base_addr + offset;
-        }
-        else
+        instruction = this->memory.read<U32>(pc + block->length * 4);
+
+        //bit[27:20] and bit[7:4]
+        entry->handler = arm_handler_table.handler[ARM_DECODER::index_of(instruction)];
+        entry->instruction.val = instruction;
+        entry->cycles = 1;
+        entry->dispatch = (ARM_INSTRUCTION::cond(instruction) == COND_AL) ? DISPATCH_ALWAYS : DISPATCH_CONDITIONAL;
+        if (may_store(instruction))
         {
-            base_addr = base_addr - offset;
+            entry->dispatch |= DISPATCH_ALWAYS_STORE;
         }
-    }
+        block->length++;
+    } while (!ends_block(instruction) && block->length < BLOCK_MAX_INSTRUCTIONS &&
+             !(wram && ((pc + block->length * 4) & ((1 << DIRTY_SHIFT) - 1)) == 0));
+
+    block->instructions[block->length].dispatch = DISPATCH_END;
+    block->threaded = 0;
+    block->hotness = 0;
+    block->generation++;
 
-    if (instruction_ptr->single_data_tsf.B == 1)
+    if (wram)
     {
-        *((U8*)base_addr) = this->R[Rn];
+        track_block(block);
     }
-    else
+}
+
+//drop every cached block whose code overlaps [address, address + size), only
+//called for writes into a granule holding cached code. blocks are compared by
+//raw_data offset, so a write through another mirror hits them too, and the
+//mirrors are a multiple of the cache size apart, so they share its slots
+void GBA_EMUALTOR_ARM7TDMI::invalidate_blocks(U32 address, U32 size)
+{
+    S32 offset = this->memory.dirty_offset(address);
+    U32 first;
+
+    this->block_cache.code_writes++;
+    if (offset < 0)
     {
-        *((U32*)base_addr) = this->R[Rn];
+        return;
     }
 
-    if (instruction_ptr->single_data_tsf.P == 0)
+    //a block overlapping address starts at most BLOCK_MAX_INSTRUCTIONS - 1 words before it
+    first = (address & ~0x3) - (BLOCK_MAX_INSTRUCTIONS - 1) * 4;
+    for (U32 pc = first; pc < address + size; pc += 4)
     {
-        if (instruction_ptr->single_data_tsf.U == 1)
-        {
-            base_addr = base_addr + offset;
-        }
-        else
+        BLOCK *block = &this->block_cache.blocks[(pc >> 2) & (BLOCK_CACHE_SIZE - 1)];
+
+        if (block->code_offset != BLOCK_UNTRACKED && block->code_offset < (U32)offset + size && block->code_offset + block->length * 4 > (U32)offset)
         {
-            base_addr = base_addr - offset;
+            drop_block_code(block);
+            untrack_block(block);
+            block->pc = BLOCK_INVALID;
+            block->length = 0;
+            this->block_cache.invalidations++;
         }
     }
+}
 
-    if (instruction_ptr->single_data_tsf.W == 1)
+//slots never decoded into are skipped, so their pages are not touched
+void GBA_EMUALTOR_ARM7TDMI::flush_block_cache()
+{
+    for (U32 i = 0; i < BLOCK_CACHE_SIZE; i++)
     {
-        this->R[Rn] = base_addr;
+        if (this->block_cache.blocks[i].length == 0)
+        {
+            continue;
+        }
+        drop_block_code(&this->block_cache.blocks[i]);
+        untrack_block(&this->block_cache.blocks[i]);
+        this->block_cache.blocks[i].pc = BLOCK_INVALID;
+        this->block_cache.blocks[i].length = 0;
     }
 }
 
-
-
-
-
-
-
-
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::AND_lli(INSTRUCTION_FORMAT *instruction_ptr)
+//count the block in its granule, the first one sets the code bit
+void GBA_EMUALTOR_ARM7TDMI::track_block(BLOCK *block)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
+    U32 granule;
 
-    this->R[Rd] = this->R[Rn] & (((U32)this->R[Rm]) << shift_amount);
+    block->code_offset = (U32)this->memory.dirty_offset(block->pc);
+    granule = block->code_offset >> DIRTY_SHIFT;
+    if (this->granule_blocks[granule]++ == 0)
+    {
+        this->memory.mark_code(granule);
+    }
 }
 
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::AND_llr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::untrack_block(BLOCK *block)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
+    U32 granule;
 
-    this->R[Rd] = this->R[Rn] & (((U32)this->R[Rm]) << shift_amount);
-}
-
-//doc, p55 : The form of the shift field which might be expected to correspond to LSR #0 is used to
-//encode LSR #32, which has a zero result with bit 31 of Rm as the carry output.Logical
-//shift right zero is redundant as it is the same as logical shift left zero, so the assembler
-//will convert LSR #0 (and ASR #0 and ROR #0) into LSL #0, and allow LSR #32 to be
-//specified.
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::AND_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] & (((U32)this->R[Rm]) >> shift_amount);
+    if (block->code_offset == BLOCK_UNTRACKED)
+    {
+        return;
+    }
+    granule = block->code_offset >> DIRTY_SHIFT;
+    if (--this->granule_blocks[granule] == 0)
+    {
+        this->memory.unmark_code(granule);
+    }
+    block->code_offset = BLOCK_UNTRACKED;
 }
 
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::AND_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::drop_block_code(BLOCK *block)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] & (((U32)this->R[Rm]) >> shift_amount);
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::AND_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] & (((S32)this->R[Rm]) >> shift_amount);
+    if (block->code && this->block_drop_hook)
+    {
+        this->block_drop_hook(this->block_drop_context, block);
+    }
+    block->code = NULL;
 }
 
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::AND_arr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::memory_write_hook(void *context, U32 address, U32 size)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = this->R[Rn] & (((S32)this->R[Rm]) >> shift_amount);
+    ((GBA_EMUALTOR_ARM7TDMI*)context)->invalidate_blocks(address, size);
 }
 
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::AND_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    
-    this->R[Rd] = this->R[Rn] & ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-}
 
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::AND_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
+//transfer register contents to PSR
+void GBA_EMUALTOR_ARM7TDMI::MSR(INSTRUCTION_FORMAT *instruction_ptr)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = this->R[Rn] & ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
+    write_PSR(instruction_ptr->val, this->R[ARM_PSR_TRANSFER::Rm(instruction_ptr->val)]);
 }
 
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::ANDS_lli(INSTRUCTION_FORMAT *instruction_ptr)
+//MSR : bit[22] selects the SPSR, the field mask bit[19:16] the bytes written
+//(flags, status, extension, control). user mode can only write the flags of
+//CPSR, a write to the control byte of CPSR switches the register bank
+void GBA_EMUALTOR_ARM7TDMI::write_PSR(U32 instruction, U32 value)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     =  (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
+    U32 fields = ARM_PSR_TRANSFER::field_mask(instruction);
+    U32 mask = 0;
 
-    this->R[Rd] = this->R[Rn] & operand2;
+    mask |= (fields & BIT(3)) ? 0xFF000000 : 0;
+    mask |= (fields & BIT(2)) ? 0x00FF0000 : 0;
+    mask |= (fields & BIT(1)) ? 0x0000FF00 : 0;
+    mask |= (fields & BIT(0)) ? 0x000000FF : 0;
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
+    if (ARM_PSR_TRANSFER::P(instruction))
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
+        this->SPSR_bank[this->bank].val = (this->SPSR_bank[this->bank].val & ~mask) | (value & mask);
+        return;
     }
-    else
+
+    if (this->mode == USR_MODE)
     {
+        mask &= 0xFF000000;
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
+    set_CPSR((get_CPSR() & ~mask) | (value & mask));
 }
 
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::ANDS_llr(INSTRUCTION_FORMAT *instruction_ptr) 
+//CPSR = SPSR of the current mode, user and system mode have no SPSR
+void GBA_EMUALTOR_ARM7TDMI::restore_CPSR()
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     =  (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] & operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
+    if (this->bank == BANK_USR)
     {
+        return;
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
+    set_CPSR(this->SPSR_bank[this->bank].val);
 }
 
-//doc, p55 : The form of the shift field which might be expected to correspond to LSR #0 is used to
-//encode LSR #32, which has a zero result with bit 31 of Rm as the carry output.Logical
-//shift right zero is redundant as it is the same as logical shift left zero, so the assembler
-//will convert LSR #0 (and ASR #0 and ROR #0) into LSL #0, and allow LSR #32 to be
-//specified.
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::ANDS_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     =  (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
+//mode bit[3:0] -> BANK_*
+static constexpr U8 mode_bank[16] =
+{
+    BANK_USR, BANK_FIQ, BANK_IRQ, BANK_SVC, BANK_USR, BANK_USR, BANK_USR, BANK_ABT,
+    BANK_USR, BANK_USR, BANK_USR, BANK_UND, BANK_USR, BANK_USR, BANK_USR, BANK_USR,
+};
 
-    this->R[Rd] = this->R[Rn] & operand2;
+//R13/R14 move between R and the bank array when the bank changes, R8-R12
+//only when FIQ mode is entered or left
+void GBA_EMUALTOR_ARM7TDMI::switch_mode(U32 new_mode)
+{
+    U32 old_bank = this->bank;
+    U32 new_bank = mode_bank[new_mode & 0xF];
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
+    this->mode = (U8)new_mode;
+    if (new_bank == old_bank)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
+        return;
     }
-    else // shift_amount == 0
+
+    this->banked_R13_R14[old_bank][0] = this->R[13];
+    this->banked_R13_R14[old_bank][1] = this->R[14];
+    this->R[13] = this->banked_R13_R14[new_bank][0];
+    this->R[14] = this->banked_R13_R14[new_bank][1];
+    if ((old_bank == BANK_FIQ) != (new_bank == BANK_FIQ))
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
+        for (U32 i = 0; i < 5; i++)
+        {
+            U32 value = this->R[8 + i];
+
+            this->R[8 + i] = this->banked_R8_R12[i];
+            this->banked_R8_R12[i] = value;
+        }
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
+    this->bank = (U8)new_bank;
 }
 
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::ANDS_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     =  (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
 
-    this->R[Rd] = this->R[Rn] & operand2;
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
+//transfer PSR contents to a register
+void GBA_EMUALTOR_ARM7TDMI::MRS(INSTRUCTION_FORMAT *instruction_ptr)
+{
+    U32 Rd = ARM_PSR_TRANSFER::Rd(instruction_ptr->val);
+
+    if (ARM_PSR_TRANSFER::P(instruction_ptr->val))
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
+        this->R[Rd] = this->SPSR_bank[this->bank].val;
     }
-    else // shift_amount == 0
+    else
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
+        this->R[Rd] = get_CPSR();
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
 }
 
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ANDS_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     =  (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
 
-    this->R[Rd] = this->R[Rn] & operand2;
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
+void GBA_EMUALTOR_ARM7TDMI::MUL(INSTRUCTION_FORMAT *instruction_ptr)
+{
+    U32 Rd = ARM_MULTIPLY::Rd(instruction_ptr->val);
+    U32 Rm = ARM_MULTIPLY::Rm(instruction_ptr->val);
+    U32 Rs = ARM_MULTIPLY::Rs(instruction_ptr->val);
+
+    this->R[Rd] = this->R[Rm] * this->R[Rs];
+
+    //S : N and Z from the result, C is meaningless (left as is), V unaffected
+    if (ARM_MULTIPLY::S(instruction_ptr->val))
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
+        set_flags_logic(this->R[Rd], flag_C());
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
 }
 
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::ANDS_arr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::MLA(INSTRUCTION_FORMAT *instruction_ptr)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     =  (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] & operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
+    U32 Rd = ARM_MULTIPLY::Rd(instruction_ptr->val);
+    U32 Rm = ARM_MULTIPLY::Rm(instruction_ptr->val);
+    U32 Rs = ARM_MULTIPLY::Rs(instruction_ptr->val);
+    U32 Rn = ARM_MULTIPLY::Rn(instruction_ptr->val);
 
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ANDS_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     =  ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] & operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
+    this->R[Rd] = this->R[Rm] * this->R[Rs] + this->R[Rn];
 
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::ANDS_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     =  ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] & operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
+    //S : N and Z from the result, C is meaningless (left as is), V unaffected
+    if (ARM_MULTIPLY::S(instruction_ptr->val))
+    {
+        set_flags_logic(this->R[Rd], flag_C());
+    }
 }
 
 
-//exclusive OR
 
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::EOR_lli(INSTRUCTION_FORMAT *instruction_ptr)
+//UMULL, SMULL, U selects the signed multiply
+void GBA_EMUALTOR_ARM7TDMI::MULL(INSTRUCTION_FORMAT *instruction_ptr)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
+    U64 result;
+    U32 RdHi = ARM_MULTIPLY_LONG::RdHi(instruction_ptr->val);
+    U32 RdLo = ARM_MULTIPLY_LONG::RdLo(instruction_ptr->val);
+    U32 Rm   = ARM_MULTIPLY_LONG::Rm(instruction_ptr->val);
+    U32 Rs   = ARM_MULTIPLY_LONG::Rs(instruction_ptr->val);
+
+    if (ARM_MULTIPLY_LONG::U(instruction_ptr->val))
+    {
+        result = (U64)((S64)(S32)this->R[Rm] * (S64)(S32)this->R[Rs]);
+    }
+    else
+    {
+        result = (U64)this->R[Rm] * (U64)this->R[Rs];
+    }
+    this->R[RdHi] = result >> 32;
+    this->R[RdLo] = result & 0xFFFFFFFF;
 
-    this->R[Rd] = this->R[Rn] ^ (((U32)this->R[Rm]) << shift_amount);
+    //S : N from bit 63, Z from all 64 bits
+    if (ARM_MULTIPLY_LONG::S(instruction_ptr->val))
+    {
+        set_flags_logic(this->R[RdHi] | (this->R[RdLo] != 0), flag_C());
+        this->flags.result = this->R[RdHi];
+    }
 }
 
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::EOR_llr(INSTRUCTION_FORMAT *instruction_ptr) 
+//UMLAL, SMLAL, RdHi:RdLo is the accumulator
+void GBA_EMUALTOR_ARM7TDMI::MLAL(INSTRUCTION_FORMAT *instruction_ptr)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] ^ (((U32)this->R[Rm]) << shift_amount);
-}
+    U64 result;
+    U64 accumulate;
+    U32 RdHi = ARM_MULTIPLY_LONG::RdHi(instruction_ptr->val);
+    U32 RdLo = ARM_MULTIPLY_LONG::RdLo(instruction_ptr->val);
+    U32 Rm   = ARM_MULTIPLY_LONG::Rm(instruction_ptr->val);
+    U32 Rs   = ARM_MULTIPLY_LONG::Rs(instruction_ptr->val);
 
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::EOR_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
+    accumulate = ((U64)this->R[RdHi]) << 32 | ((U64)this->R[RdLo]);
+    if (ARM_MULTIPLY_LONG::U(instruction_ptr->val))
+    {
+        result = (U64)((S64)(S32)this->R[Rm] * (S64)(S32)this->R[Rs]) + accumulate;
+    }
+    else
+    {
+        result = (U64)this->R[Rm] * (U64)this->R[Rs] + accumulate;
+    }
+    this->R[RdHi] = result >> 32;
+    this->R[RdLo] = result & 0xFFFFFFFF;
 
-    this->R[Rd] = this->R[Rn] ^ (((U32)this->R[Rm]) >> shift_amount);
+    if (ARM_MULTIPLY_LONG::S(instruction_ptr->val))
+    {
+        set_flags_logic(this->R[RdHi] | (this->R[RdLo] != 0), flag_C());
+        this->flags.result = this->R[RdHi];
+    }
 }
 
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::EOR_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
+//SWP Rd, Rm, [Rn] : a locked read and write on the bus, a read followed by a
+//write here. Rm is read before Rd is written, the loaded word rotates like LDR
+void GBA_EMUALTOR_ARM7TDMI::SWP(INSTRUCTION_FORMAT *instruction_ptr)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
+    U32 address = this->R[ARM_SWAP::Rn(instruction_ptr->val)];
+    U32 source = this->R[ARM_SWAP::Rm(instruction_ptr->val)];
+    U32 rotate = (address & 0x3) * 8;
+    U32 value = this->memory.read<U32>(address);
 
-    this->R[Rd] = this->R[Rn] ^ (((U32)this->R[Rm]) >> shift_amount);
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::EOR_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
+    this->memory.write<U32>(address, source);
+    this->R[ARM_SWAP::Rd(instruction_ptr->val)] = (value >> rotate) | (value << ((32 - rotate) & 0x1F));
 
-    this->R[Rd] = this->R[Rn] ^ (((S32)this->R[Rm]) >> shift_amount);
+    //1S + 2N + 1I
+    this->cycles += 3 + 2 * this->memory.waits<U32>(address);
 }
 
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::EOR_arr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::SWPB(INSTRUCTION_FORMAT *instruction_ptr)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = this->R[Rn] ^ (((S32)this->R[Rm]) >> shift_amount);
-}
+    U32 address = this->R[ARM_SWAP::Rn(instruction_ptr->val)];
+    U32 source = this->R[ARM_SWAP::Rm(instruction_ptr->val)];
+    U32 value = this->memory.read<U8>(address);
 
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::EOR_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    
-    this->R[Rd] = this->R[Rn] ^ ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-}
+    this->memory.write<U8>(address, (U8)source);
+    this->R[ARM_SWAP::Rd(instruction_ptr->val)] = value;
 
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::EOR_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = this->R[Rn] ^ ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
+    //1S + 2N + 1I
+    this->cycles += 3 + 2 * this->memory.waits<U8>(address);
 }
 
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::EORS_lli(INSTRUCTION_FORMAT *instruction_ptr)
+
+//one instance per opcode, S bit and operand2 form, everything but the register
+//numbers and shift amounts is resolved at compile time
+template<U32 OPCODE, U32 S, U32 OPERAND2>
+void GBA_EMUALTOR_ARM7TDMI::data_proc(INSTRUCTION_FORMAT *instruction_ptr)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     =  (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
+    const bool test    = (OPCODE == OPC_TST) || (OPCODE == OPC_TEQ) || (OPCODE == OPC_CMP) || (OPCODE == OPC_CMN);
 
-    this->R[Rd] = this->R[Rn] ^ operand2;
+    U32 instruction = instruction_ptr->val;
+    U32 Rd = ARM_DATA_PROC::Rd(instruction);
+    U32 Rn = ARM_DATA_PROC::Rn(instruction);
+    U32 carry_in = flag_C();
+    U32 carry = carry_in;
+    U32 operand1;
+    U32 operand2;
+    U32 result;
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
+    //4.5.5 Using R15 as an operand : instruction + 8, or + 12 when the shift amount comes from a register
+    if constexpr (OPERAND2 == OPERAND2_IMM)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
+        operand1 = (Rn == 15) ? this->R[15] + 4 : this->R[Rn];
+        operand2 = ARM_DATA_PROC::rotated_imm(instruction);
+        if (ARM_DATA_PROC::rotate(instruction) != 0)
+        {
+            carry = operand2 >> 31;
+        }
     }
-    else
+    else if constexpr (OPERAND2 & SHIFT_SOURCE_REGSITER)
     {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
+        U32 Rm = ARM_DATA_PROC::Rm(instruction);
+        U32 Rs = ARM_DATA_PROC::Rs(instruction);
 
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::EORS_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] ^ operand2;
+        operand1 = (Rn == 15) ? this->R[15] + 8 : this->R[Rn];
+        operand2 = (Rm == 15) ? this->R[15] + 8 : this->R[Rm];
+        operand2 = shift_by_register<(OPERAND2 >> 1)>(operand2, this->R[Rs] & 0xFF, carry);
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
+        //1I
+        this->cycles += 1;
     }
     else
     {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::EORS_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
+        U32 Rm = ARM_DATA_PROC::Rm(instruction);
 
-    this->R[Rd] = this->R[Rn] ^ operand2;
+        operand1 = (Rn == 15) ? this->R[15] + 4 : this->R[Rn];
+        operand2 = (Rm == 15) ? this->R[15] + 4 : this->R[Rm];
+        operand2 = shift_by_immediate<(OPERAND2 >> 1)>(operand2, ARM_DATA_PROC::shift_amount(instruction), carry);
+    }
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
+    switch (OPCODE)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
+        case OPC_AND:
+        case OPC_TST:
+            result = operand1 & operand2;
+            break;
+        case OPC_EOR:
+        case OPC_TEQ:
+            result = operand1 ^ operand2;
+            break;
+        case OPC_SUB:
+        case OPC_CMP:
+            result = operand1 - operand2;
+            break;
+        case OPC_RSB:
+            result = operand2 - operand1;
+            break;
+        case OPC_ADD:
+        case OPC_CMN:
+            result = operand1 + operand2;
+            break;
+        case OPC_ADC:
+            result = operand1 + operand2 + carry_in;
+            break;
+        case OPC_SBC:
+            result = operand1 - operand2 - (carry_in ^ 1);
+            break;
+        case OPC_RSC:
+            result = operand2 - operand1 - (carry_in ^ 1);
+            break;
+        case OPC_ORR:
+            result = operand1 | operand2;
+            break;
+        case OPC_MOV:
+            result = operand2;
+            break;
+        case OPC_BIC:
+            result = operand1 & ~operand2;
+            break;
+        default: //OPC_MVN
+            result = ~operand2;
+            break;
     }
-    else // shift_amount == 0
+
+    if (!test)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
+        this->R[Rd] = result;
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::EORS_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] ^ operand2;
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
+    if constexpr (S)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
+        //MOVS PC, R14 and friends return from an exception, R15 is aligned
+        //for the state they return to
+        if (!test && Rd == 15)
+        {
+            restore_CPSR();
+            this->R[15] &= this->thumb ? ~0x1 : ~0x3;
+        }
+        else
+        {
+            //store the flag words, the NZCV bits are worked out when read
+            switch (OPCODE)
+            {
+                case OPC_SUB:
+                case OPC_CMP:
+                    set_flags_sub(operand1, operand2, 1, result);
+                    break;
+                case OPC_RSB:
+                    set_flags_sub(operand2, operand1, 1, result);
+                    break;
+                case OPC_ADD:
+                case OPC_CMN:
+                    set_flags_add(operand1, operand2, 0, result);
+                    break;
+                case OPC_ADC:
+                    set_flags_add(operand1, operand2, carry_in, result);
+                    break;
+                case OPC_SBC:
+                    set_flags_sub(operand1, operand2, carry_in, result);
+                    break;
+                case OPC_RSC:
+                    set_flags_sub(operand2, operand1, carry_in, result);
+                    break;
+                default:
+                    set_flags_logic(result, carry);
+                    break;
+            }
+        }
     }
-    else // shift_amount == 0
+
+    //writing R15 refills the pipeline, 1S + 1N
+    if (!test && Rd == 15)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
+        this->cycles += 2;
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
 }
 
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::EORS_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
 
-    this->R[Rd] = this->R[Rn] ^ (((S32)this->R[Rm]) >> shift_amount);
+//one instance per P/U/B/W/L combination and offset form. the shifter carry out
+//of a register offset is dropped, only data processing writes it to C
+template<U32 P, U32 U, U32 B, U32 W, U32 L, U32 OFFSET>
+void GBA_EMUALTOR_ARM7TDMI::single_data_tsf(INSTRUCTION_FORMAT *instruction_ptr)
+{
+    U32 instruction = instruction_ptr->val;
+    U32 Rd = ARM_SINGLE_TRANSFER::Rd(instruction);
+    U32 Rn = ARM_SINGLE_TRANSFER::Rn(instruction);
+    U32 base = (Rn == 15) ? this->R[15] + 4 : this->R[Rn];
+    U32 offset;
+    U32 address;
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
+    if constexpr (OFFSET == OPERAND2_IMM)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
+        offset = ARM_SINGLE_TRANSFER::offset(instruction);
     }
-    else // shift_amount == 0
+    else
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
+        U32 Rm = ARM_SINGLE_TRANSFER::Rm(instruction);
+        U32 carry = flag_C();
+
+        offset = shift_by_immediate<(OFFSET >> 1)>((Rm == 15) ? this->R[15] + 4 : this->R[Rm], ARM_SINGLE_TRANSFER::shift_amount(instruction), carry);
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
 
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::EORS_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] ^ operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
+    address = P ? (U ? base + offset : base - offset) : base;
 
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::EORS_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] ^ operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
+    if constexpr (L)
+    {
+        U32 value;
 
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::EORS_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] ^ operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::SUB_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] - (((U32)this->R[Rm]) << shift_amount);
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::SUB_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] - (((U32)this->R[Rm]) << shift_amount);
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::SUB_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] - (((U32)this->R[Rm]) >> shift_amount);
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::SUB_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] - (((U32)this->R[Rm]) >> shift_amount);
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::SUB_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] - (((S32)this->R[Rm]) >> shift_amount);
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::SUB_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = this->R[Rn] - (((S32)this->R[Rm]) >> shift_amount);
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::SUB_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    
-    this->R[Rd] = this->R[Rn] - ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::SUB_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = this->R[Rn] - ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-}
-
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::SUBS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
+        if constexpr (B)
+        {
+            value = this->memory.read<U8>(address);
+            this->cycles += this->memory.waits<U8>(address);
+        }
+        else
+        {
+            //unaligned LDR rotates the addressed byte into bit[7:0]
+            U32 rotate = (address & 0x3) * 8;
 
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::SUBS_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
+            value = this->memory.read<U32>(address);
+            this->cycles += this->memory.waits<U32>(address);
+            value = (value >> rotate) | (value << ((32 - rotate) & 0x1F));
+        }
 
-    this->R[Rd] = this->R[Rn] - operand2;
+        //post-indexed always writes back, W selects the user mode (T) variants,
+        //which are the same without an MMU. a loaded Rd overrides the written back Rn
+        if (!P || W)
+        {
+            this->R[Rn] = U ? base + offset : base - offset;
+        }
+        this->R[Rd] = value;
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
+        //1S + 1N + 1I, loading R15 adds 1S + 1N
+        this->cycles += 2;
+        if (Rd == 15)
+        {
+            this->R[15] &= ~0x3;
+            this->cycles += 2;
+        }
     }
     else
     {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::SUBS_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rd];
-
-    this->R[Rd] = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::SUBS_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::SUBS_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::SUBS_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::SUBS_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
+        //a stored R15 is the instruction + 12
+        U32 value = (Rd == 15) ? this->R[15] + 8 : this->R[Rd];
 
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::SUBS_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rd];
+        if constexpr (B)
+        {
+            this->memory.write<U8>(address, (U8)value);
+            this->cycles += this->memory.waits<U8>(address);
+        }
+        else
+        {
+            this->memory.write<U32>(address, value);
+            this->cycles += this->memory.waits<U32>(address);
+        }
 
-    this->R[Rd] = this->R[Rn] - operand2;
+        if (!P || W)
+        {
+            this->R[Rn] = U ? base + offset : base - offset;
+        }
 
-    //update CPSR C
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
+        //2N
+        this->cycles += 1;
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//Reverse Subtract without carry
-//operand2 - operand1
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::RSB_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = (((U32)this->R[Rm]) << shift_amount) - this->R[Rn];
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::RSB_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = (((U32)this->R[Rm]) << shift_amount) - this->R[Rn];
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::RSB_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = (((U32)this->R[Rm]) >> shift_amount) - this->R[Rn];
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::RSB_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = (((U32)this->R[Rm]) >> shift_amount) - this->R[Rn];
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::RSB_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = (((S32)this->R[Rm]) >> shift_amount) - this->R[Rn];
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::RSB_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = (((S32)this->R[Rm]) >> shift_amount) - this->R[Rn];
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::RSB_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    
-    this->R[Rd] = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount)))) - this->R[Rn];
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::RSB_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount)))) - this->R[Rn];
 }
 
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::RSBS_lli(INSTRUCTION_FORMAT *instruction_ptr)
+//one instance per P/U/I/W/L combination and SH form, L clear is STRH only.
+//I selects the split 8 bit immediate offset over Rm. an unaligned LDRH rotates
+//the halfword by 8 bits, an unaligned LDRSH loads the addressed byte sign
+//extended, as the THUMB forms do
+template<U32 P, U32 U, U32 I, U32 W, U32 L, U32 SH>
+void GBA_EMUALTOR_ARM7TDMI::halfword_data_tsf(INSTRUCTION_FORMAT *instruction_ptr)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
+    U32 instruction = instruction_ptr->val;
+    U32 Rd = ARM_HALFWORD_TRANSFER::Rd(instruction);
+    U32 Rn = ARM_HALFWORD_TRANSFER::Rn(instruction);
+    U32 base = (Rn == 15) ? this->R[15] + 4 : this->R[Rn];
+    U32 offset;
+    U32 address;
 
-    this->R[Rd] = operand2 - this->R[Rn];
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
+    if constexpr (I)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
+        offset = ARM_HALFWORD_TRANSFER::offset(instruction);
     }
     else
     {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
+        U32 Rm = ARM_HALFWORD_TRANSFER::Rm(instruction);
 
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::RSBS_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = operand2 - this->R[Rn];
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
+        offset = (Rm == 15) ? this->R[15] + 4 : this->R[Rm];
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::RSBS_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rd];
 
-    this->R[Rd] = operand2 - this->R[Rn];
+    address = P ? (U ? base + offset : base - offset) : base;
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
+    if constexpr (L)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
+        U32 value;
 
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
+        if constexpr (SH == 1)
+        {
+            U32 rotate = (address & 0x1) * 8;
 
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::RSBS_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
+            value = this->memory.read<U16>(address);
+            value = (value >> rotate) | (value << ((32 - rotate) & 0x1F));
+            this->cycles += this->memory.waits<U16>(address);
+        }
+        else if constexpr (SH == 2)
+        {
+            value = (U32)(S32)(S8)this->memory.read<U8>(address);
+            this->cycles += this->memory.waits<U8>(address);
+        }
+        else
+        {
+            if (address & 0x1)
+            {
+                value = (U32)(S32)(S8)this->memory.read<U8>(address);
+            }
+            else
+            {
+                value = (U32)(S32)(S16)this->memory.read<U16>(address);
+            }
+            this->cycles += this->memory.waits<U16>(address);
+        }
 
-    this->R[Rd] = operand2 - this->R[Rn];
+        //a loaded Rd overrides the written back Rn
+        if (!P || W)
+        {
+            this->R[Rn] = U ? base + offset : base - offset;
+        }
+        this->R[Rd] = value;
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
+        //1S + 1N + 1I, loading R15 adds 1S + 1N
+        this->cycles += 2;
+        if (Rd == 15)
+        {
+            this->R[15] &= ~0x3;
+            this->cycles += 2;
+        }
     }
-    else // shift_amount == 0
+    else
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
+        //a stored R15 is the instruction + 12
+        U32 value = (Rd == 15) ? this->R[15] + 8 : this->R[Rd];
 
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::RSBS_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
+        this->memory.write<U16>(address, (U16)value);
+        this->cycles += this->memory.waits<U16>(address);
 
-    this->R[Rd] = operand2 - this->R[Rn];
+        if (!P || W)
+        {
+            this->R[Rn] = U ? base + offset : base - offset;
+        }
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
+        //2N
+        this->cycles += 1;
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
 }
 
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::RSBS_arr(INSTRUCTION_FORMAT *instruction_ptr) 
+//one instance per P/U/S/W/L combination. the registers are transferred
+//lowest first to the lowest address. an empty list transfers R15 and moves
+//the base by 0x40. S on STM, and on LDM without R15 in the list, transfers
+//R8-R14 of the user bank instead of the current one, see user_register()
+template<U32 P, U32 U, U32 S, U32 W, U32 L>
+void GBA_EMUALTOR_ARM7TDMI::block_data_tsf(INSTRUCTION_FORMAT *instruction_ptr)
 {
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = operand2 - this->R[Rn];
+    U32 instruction = instruction_ptr->val;
+    U32 Rn = ARM_BLOCK_TRANSFER::Rn(instruction);
+    U32 list = ARM_BLOCK_TRANSFER::register_list(instruction);
+    U32 count = 0;
+    U32 base = this->R[Rn];
+    U32 address;
+    U32 written_back;
+    bool user_bank;
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
+    for (U32 i = 0; i < 16; i++)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
+        count += (list >> i) & 0x1;
     }
-    else // shift_amount == 0
+    if (list == 0)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
+        list = BIT(15);
+        count = 16;
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
+    user_bank = S && (!L || !(list & BIT(15)));
 
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::RSBS_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = operand2 - this->R[Rn];
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
+    //lowest address : IA Rn, IB Rn + 4, DA Rn - 4n + 4, DB Rn - 4n
+    if constexpr (U)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
+        address = P ? base + 4 : base;
+        written_back = base + count * 4;
     }
-    else // shift_amount == 0
+    else
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
+        address = P ? base - count * 4 : base - count * 4 + 4;
+        written_back = base - count * 4;
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
 
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::RSBS_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rd];
-
-    this->R[Rd] = operand2 - this->R[Rn];
-
-    //update CPSR C
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
+    if constexpr (L)
     {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::ADD_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] + (((U32)this->R[Rm]) << shift_amount);
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::ADD_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] + (((U32)this->R[Rm]) << shift_amount);
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::ADD_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] + (((U32)this->R[Rm]) >> shift_amount);
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::ADD_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] + (((U32)this->R[Rm]) >> shift_amount);
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ADD_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] + (((S32)this->R[Rm]) >> shift_amount);
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::ADD_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = this->R[Rn] + (((S32)this->R[Rm]) >> shift_amount);
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ADD_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    
-    this->R[Rd] = this->R[Rn] + ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::ADD_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = this->R[Rn] + ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-}
-
-
+        //LDM writes back before loading, so a loaded Rn wins
+        if constexpr (W)
+        {
+            this->R[Rn] = written_back;
+        }
 
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::ADDS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
+        for (U32 i = 0; i < 16; i++)
+        {
+            if ((list >> i) & 0x1)
+            {
+                (user_bank ? user_register(i) : this->R[i]) = this->memory.read<U32>(address);
+                this->cycles += this->memory.waits<U32>(address);
+                address += 4;
+            }
+        }
 
-    this->R[Rd] = this->R[Rn] + operand2;
+        //nS + 1N + 1I, loading R15 adds 1S + 1N
+        this->cycles += count + 1;
+        if (list & BIT(15))
+        {
+            this->cycles += 2;
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
+            //LDM with R15 and S returns from an exception, R15 is aligned
+            //for the state it returns to
+            if constexpr (S)
+            {
+                restore_CPSR();
+            }
+            this->R[15] &= this->thumb ? ~0x1 : ~0x3;
+        }
     }
     else
     {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::ADDS_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
+        bool first = true;
 
-    this->R[Rd] = this->R[Rn] + operand2;
+        for (U32 i = 0; i < 16; i++)
+        {
+            if ((list >> i) & 0x1)
+            {
+                //a stored R15 is the instruction + 12
+                this->memory.write<U32>(address, (i == 15) ? this->R[15] + 8 : user_bank ? user_register(i) : this->R[i]);
+                this->cycles += this->memory.waits<U32>(address);
+                address += 4;
+
+                //STM writes back after the first transfer, only the lowest
+                //register sees the old base
+                if (W && first)
+                {
+                    this->R[Rn] = written_back;
+                }
+                first = false;
+            }
+        }
 
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
+        //(n - 1)S + 2N
+        this->cycles += count;
     }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::ADDS_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rd];
-
-    this->R[Rd] = this->R[Rn] + operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::ADDS_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] + operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ADDS_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] + operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::ADDS_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] + operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ADDS_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] + operand2;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::ADDS_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rd];
-
-    this->R[Rd] = this->R[Rn] + operand2;
-
-    //update CPSR C
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::ADC_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] + (((U32)this->R[Rm]) << shift_amount) + this->CPSR_usr.C;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::ADC_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] + (((U32)this->R[Rm]) << shift_amount) + this->CPSR_usr.C;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::ADC_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] + (((U32)this->R[Rm]) >> shift_amount) + this->CPSR_usr.C;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::ADC_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] + (((U32)this->R[Rm]) >> shift_amount) + this->CPSR_usr.C;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ADC_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] + (((S32)this->R[Rm]) >> shift_amount) + this->CPSR_usr.C;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::ADC_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = this->R[Rn] + (((S32)this->R[Rm]) >> shift_amount) + this->CPSR_usr.C;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ADC_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    
-    this->R[Rd] = this->R[Rn] + ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount)))) + this->CPSR_usr.C;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::ADC_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = this->R[Rn] + ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount)))) + this->CPSR_usr.C;
-}
-
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::ADCS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] + operand2 + this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::ADCS_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] + operand2 + this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::ADCS_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rd];
-
-    this->R[Rd] = this->R[Rn] + operand2 + this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::ADCS_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] + operand2 + this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ADCS_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] + operand2 + this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::ADCS_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] + operand2 + this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ADCS_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] + operand2 + this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::ADCS_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rd];
-
-    this->R[Rd] = this->R[Rn] + operand2 + this->CPSR_usr.C;
-
-    //update CPSR C
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::SBC_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] - (((U32)this->R[Rm]) << shift_amount) - this->CPSR_usr.C;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::SBC_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] - (((U32)this->R[Rm]) << shift_amount) - this->CPSR_usr.C;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::SBC_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] - (((U32)this->R[Rm]) >> shift_amount) - this->CPSR_usr.C;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::SBC_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] - (((U32)this->R[Rm]) >> shift_amount) - this->CPSR_usr.C;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::SBC_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] - (((S32)this->R[Rm]) >> shift_amount) - this->CPSR_usr.C;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::SBC_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = this->R[Rn] - (((S32)this->R[Rm]) >> shift_amount) - this->CPSR_usr.C;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::SBC_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    
-    this->R[Rd] = this->R[Rn] - ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount)))) - this->CPSR_usr.C;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::SBC_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = this->R[Rn] - ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-}
-
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::SBCS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] - operand2 - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::SBCS_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] - operand2 - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::SBCS_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rd];
-
-    this->R[Rd] = this->R[Rn] - operand2 - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::SBCS_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] - operand2 - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::SBCS_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] - operand2 - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::SBCS_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] - operand2 - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::SBCS_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = this->R[Rn] - operand2 - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::SBCS_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rd];
-
-    this->R[Rd] = this->R[Rn] - operand2 - this->CPSR_usr.C;
-
-    //update CPSR C
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::RSC_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = (((U32)this->R[Rm]) << shift_amount) - this->R[Rn] - this->CPSR_usr.C;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::RSC_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = (((U32)this->R[Rm]) << shift_amount) - this->R[Rn] - this->CPSR_usr.C;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::RSC_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = (((U32)this->R[Rm]) >> shift_amount) - this->R[Rn] - this->CPSR_usr.C;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::RSC_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = (((U32)this->R[Rm]) >> shift_amount) - this->R[Rn] - this->CPSR_usr.C;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::RSC_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = (((S32)this->R[Rm]) >> shift_amount) - this->R[Rn] - this->CPSR_usr.C;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::RSC_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = (((S32)this->R[Rm]) >> shift_amount) - this->R[Rn] - this->CPSR_usr.C;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::RSC_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    
-    this->R[Rd] = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount)))) - this->R[Rn] - this->CPSR_usr.C;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::RSC_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    
-    this->R[Rd] = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount)))) - this->R[Rn] - this->CPSR_usr.C;
-}
-
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::RSCS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = operand2 - this->R[Rn] - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::RSCS_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = operand2 - this->R[Rn] - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::RSCS_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rd];
-
-    this->R[Rd] = operand2 - this->R[Rn] - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::RSCS_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = operand2 - this->R[Rn] - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::RSCS_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-
-    this->R[Rd] = operand2 - this->R[Rn] - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::RSCS_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = operand2 - this->R[Rn] - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::RSCS_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rn];
-    
-    this->R[Rd] = operand2 - this->R[Rn] - this->CPSR_usr.C;
-
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::RSCS_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rd];
-
-    this->R[Rd] = operand2 - this->R[Rn] - this->CPSR_usr.C;
-
-    //update CPSR C
-    //shift_amount : 0 ~ 31
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-    
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::TSTS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     =  (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-	U32 discarded_res= 0;
-
-    discarded_res = this->R[Rn] & operand2;
-
-    //update CPSR C
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !discarded_res;
-    
-    //update CPSR S
-    this->CPSR_usr.N = discarded_res >> 31;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::TSTS_llr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     =  (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-	U32 discarded_res= 0;
-
-    discarded_res = this->R[Rn] & operand2;
-
-    //update CPSR C
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !discarded_res;
-    
-    //update CPSR S
-    this->CPSR_usr.N = discarded_res >> 31;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::TSTS_lri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     =  (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-	U32 discarded_res= 0;
-
-    discarded_res = this->R[Rn] & operand2;
-
-    //update CPSR C
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !discarded_res;
-    
-    //update CPSR S
-    this->CPSR_usr.N = discarded_res >> 31;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::TSTS_lrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     =  (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-	U32 discarded_res= 0;
-
-    discarded_res = this->R[Rn] & operand2;
-
-    //update CPSR C
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !discarded_res;
-    
-    //update CPSR S
-    this->CPSR_usr.N = discarded_res >> 31;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::TSTS_ari(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     =  (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-	U32 discarded_res= 0;
-
-    discarded_res = this->R[Rn] & operand2;
-
-    //update CPSR C
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !discarded_res;
-    
-    //update CPSR S
-    this->CPSR_usr.N = discarded_res >> 31;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::TSTS_arr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     =  (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val  = this->R[Rn];
-	U32 discarded_res= 0;
-    
-    discarded_res = this->R[Rn] & operand2;
-
-    //update CPSR C
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !discarded_res;
-    
-    //update CPSR S
-    this->CPSR_usr.N = discarded_res >> 31;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::TSTS_rri(INSTRUCTION_FORMAT *instruction_ptr) 
-{    
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2     =  ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rn];
-	U32 discarded_res= 0;
-    
-    discarded_res = this->R[Rn] & operand2;
-
-    //update CPSR C
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !discarded_res;
-    
-    //update CPSR S
-    this->CPSR_usr.N = discarded_res >> 31;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::TSTS_rrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn           = instruction_ptr->data_proc.Rn;
-    U32 Rd           = instruction_ptr->data_proc.Rd;
-    U32 Rm           = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2     =  ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val  = this->R[Rn];
-	U32 discarded_res= 0;
-    
-    discarded_res = this->R[Rn] & operand2;
-
-    //update CPSR C
-    if(shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-    
-    //update CPSR Z
-    this->CPSR_usr.Z = !discarded_res;
-    
-    //update CPSR S
-    this->CPSR_usr.N = discarded_res >> 31;
-}
-
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::TEQS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] ^ operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !Rd_temp;
-
-    //update CPSR S
-    this->CPSR_usr.N = Rd_temp >> 31;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::TEQS_llr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] ^ operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !Rd_temp;
-
-    //update CPSR S
-    this->CPSR_usr.N = Rd_temp >> 31;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::TEQS_lri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] ^ operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !Rd_temp;
-
-    //update CPSR S
-    this->CPSR_usr.N = Rd_temp >> 31;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::TEQS_lrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] ^ operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !Rd_temp;
-
-    //update CPSR S
-    this->CPSR_usr.N = Rd_temp >> 31;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::TEQS_ari(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] ^ operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !Rd_temp;
-
-    //update CPSR S
-    this->CPSR_usr.N = Rd_temp >> 31;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::TEQS_arr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] ^ operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !Rd_temp;
-
-    //update CPSR S
-    this->CPSR_usr.N = Rd_temp >> 31;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::TEQS_rri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] ^ operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !Rd_temp;
-
-    //update CPSR S
-    this->CPSR_usr.N = Rd_temp >> 31;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::TEQS_rrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] ^ operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !Rd_temp;
-
-    //update CPSR S
-    this->CPSR_usr.N = Rd_temp >> 31;
-}
-
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::CMPS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::CMPS_llr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::CMPS_lri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rd];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::CMPS_lrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::CMPS_ari(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::CMPS_arr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::CMPS_rri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] - operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::CMPS_rrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rd];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] - operand2;
-
-    //update CPSR C
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val > this->R[Rd]) ? 1 : 0;
-}
-
-//CMN is like ADD – subtract of a negative number is the same as add.
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::CMNS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] + operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::CMNS_llr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] + operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::CMNS_lri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rd];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] + operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::CMNS_lrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] + operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::CMNS_ari(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] + operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::CMNS_arr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] + operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::CMNS_rri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rn];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] + operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::CMNS_rrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rd];
-    U32 Rd_temp = 0;
-
-    Rd_temp = this->R[Rn] + operand2;
-
-    //update CPSR C
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-
-    //update CPSR V
-    this->CPSR_usr.V = (Rd_prev_val < this->R[Rd]) ? 1 : 0;
-}
-
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::ORR_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] | (((U32)this->R[Rm]) << shift_amount);
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::ORR_llr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] | (((U32)this->R[Rm]) << shift_amount);
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::ORR_lri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] | (((U32)this->R[Rm]) >> shift_amount);
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::ORR_lrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] | (((U32)this->R[Rm]) >> shift_amount);
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ORR_ari(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] | (((S32)this->R[Rm]) >> shift_amount);
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::ORR_arr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] | (((S32)this->R[Rm]) >> shift_amount);
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ORR_rri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] | ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::ORR_rrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] | ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-}
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::ORRS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] | operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::ORRS_llr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] | operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::ORRS_lri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] | operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::ORRS_lrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] | operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ORRS_ari(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] | operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::ORRS_arr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] | operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::ORRS_rri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] | operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::ORRS_rrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] | operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::MOV_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = (((U32)this->R[Rm]) << shift_amount);
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::MOV_llr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = (((U32)this->R[Rm]) << shift_amount);
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::MOV_lri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = (((U32)this->R[Rm]) >> shift_amount);
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::MOV_lrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = (((U32)this->R[Rm]) >> shift_amount);
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::MOV_ari(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = (((S32)this->R[Rm]) >> shift_amount);
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::MOV_arr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = (((S32)this->R[Rm]) >> shift_amount);
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::MOV_rri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::MOV_rrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-}
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::MOVS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::MOVS_llr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::MOVS_lri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::MOVS_lrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::MOVS_ari(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::MOVS_arr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::MOVS_rri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::MOVS_rrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::BIC_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] & (~BIT((((U32)this->R[Rm]) << shift_amount)));
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::BIC_llr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] & (~BIT((((U32)this->R[Rm]) << shift_amount)));
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::BIC_lri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] & (~BIT((((U32)this->R[Rm]) >> shift_amount)));
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::BIC_lrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] & (~BIT((((U32)this->R[Rm]) >> shift_amount)));
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::BIC_ari(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] & (~BIT((((S32)this->R[Rm]) >> shift_amount)));
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::BIC_arr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] & (~BIT((((S32)this->R[Rm]) >> shift_amount)));
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::BIC_rri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = this->R[Rn] & (~BIT(((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))))));
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::BIC_rrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = this->R[Rn] & (~BIT(((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))))));
-}
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::BICS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] & (~BIT(operand2));
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::BICS_llr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] & (~BIT(operand2));
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::BICS_lri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] & (~BIT(operand2));
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::BICS_lrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] & (~BIT(operand2));
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::BICS_ari(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] & (~BIT(operand2));
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::BICS_arr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] & (~BIT(operand2));
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::BICS_rri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] & (~BIT(operand2));
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::BICS_rrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = this->R[Rn] & (~BIT(operand2));
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::MVN_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = ~(((U32)this->R[Rm]) << shift_amount);
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::MVN_llr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = ~(((U32)this->R[Rm]) << shift_amount);
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::MVN_lri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = ~(((U32)this->R[Rm]) >> shift_amount);
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::MVN_lrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = ~(((U32)this->R[Rm]) >> shift_amount);
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::MVN_ari(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = ~(((S32)this->R[Rm]) >> shift_amount);
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::MVN_arr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = ~(((S32)this->R[Rm]) >> shift_amount);
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::MVN_rri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-
-    this->R[Rd] = ~((((U32)this->R[Rm]) << (32 - shift_amount)));
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::MVN_rrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-
-    this->R[Rd] = ~(((U32)this->R[Rm]) << (32 - shift_amount));
-}
-
-//logical left immediate
-void GBA_EMUALTOR_ARM7TDMI::MVNS_lli(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = ~operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical left register
-void GBA_EMUALTOR_ARM7TDMI::MVNS_llr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) << shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = ~operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31 - shift_amount + 1);
-    }
-    else
-    {
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical right immediate
-void GBA_EMUALTOR_ARM7TDMI::MVNS_lri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = ~operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//logical right register
-void GBA_EMUALTOR_ARM7TDMI::MVNS_lrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((U32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = ~operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//arithmetic right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::MVNS_ari(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = ~operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//arithmetic right shift register
-void GBA_EMUALTOR_ARM7TDMI::MVNS_arr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = (((S32)this->R[Rm]) >> shift_amount);
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = ~operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//rotate right shift immediate
-void GBA_EMUALTOR_ARM7TDMI::MVNS_rri(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_amount;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = ~operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//rotate right shift register
-void GBA_EMUALTOR_ARM7TDMI::MVNS_rrr(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  shift_amount = instruction_ptr->data_proc.operand2.shift.shift_reg;
-    U32 operand2 = ((((U32)this->R[Rm]) >> shift_amount) | ((((U32)this->R[Rm]) << (32 - shift_amount))));
-    U32 Rd_prev_val = this->R[Rn];
-
-    this->R[Rd] = ~operand2;
-
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-//https://alisdair.mcdiarmid.org/arm-immediate-value-encoding/
-void GBA_EMUALTOR_ARM7TDMI::AND_imm(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  rotate_amount = instruction_ptr->data_proc.operand2.rotate;     //rotate right
-    U32 operand2 = 0;
-    U32 rotate_remain_part = 0;
-    U32 Rd_prev_val = this->R[Rn];
-    U8 shift_amount;
-
-    operand2 = ((U32)instruction_ptr->data_proc.operand2.imm) >> rotate_amount * 2;
-    operand2 |= ((U32)instruction_ptr->data_proc.operand2.imm) << (32 - rotate_amount * 2);
-
-    this->R[Rd] = this->R[Rn] & operand2;
-}
-
-void GBA_EMUALTOR_ARM7TDMI::ANDS_imm(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  rotate_amount = instruction_ptr->data_proc.operand2.rotate;     //rotate right
-    U32 operand2           = 0;
-    U32 rotate_remain_part = 0;
-    U32 Rd_prev_val        = this->R[Rn];
-    U8 shift_amount;
-   
-    operand2  = ((U32)instruction_ptr->data_proc.operand2.imm) >> rotate_amount * 2;
-    operand2 |= ((U32)instruction_ptr->data_proc.operand2.imm) << (32 - rotate_amount * 2);
-
-    this->R[Rd] = this->R[Rn] + operand2 ;
-
-    //TODO : ?
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-   
-void GBA_EMUALTOR_ARM7TDMI::EOR_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::EORS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  rotate_amount = instruction_ptr->data_proc.operand2.rotate;     //rotate right
-    U32 operand2 = 0;
-    U32 rotate_remain_part = 0;
-    U32 Rd_prev_val = this->R[Rn];
-    U8 shift_amount;
-
-    operand2 = ((U32)instruction_ptr->data_proc.operand2.imm) >> rotate_amount * 2;
-    operand2 |= ((U32)instruction_ptr->data_proc.operand2.imm) << (32 - rotate_amount * 2);
-
-    this->R[Rd] = this->R[Rn] ^ operand2;
-
-    //TODO : ?
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-void GBA_EMUALTOR_ARM7TDMI::SUB_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::SUBS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  rotate_amount = instruction_ptr->data_proc.operand2.rotate;     //rotate right
-    U32 operand2 = 0;
-    U32 rotate_remain_part = 0;
-    U32 Rd_prev_val = this->R[Rn];
-    U8 shift_amount;
-
-    operand2 = ((U32)instruction_ptr->data_proc.operand2.imm) >> rotate_amount * 2;
-    operand2 |= ((U32)instruction_ptr->data_proc.operand2.imm) << (32 - rotate_amount * 2);
-
-    this->R[Rd] = this->R[Rn] - operand2;
-
-    //TODO : ?
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-void GBA_EMUALTOR_ARM7TDMI::RSB_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::RSBS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  rotate_amount = instruction_ptr->data_proc.operand2.rotate;     //rotate right
-    U32 operand2 = 0;
-    U32 rotate_remain_part = 0;
-    U32 Rd_prev_val = this->R[Rn];
-    U8 shift_amount;
-
-    operand2 = ((U32)instruction_ptr->data_proc.operand2.imm) >> rotate_amount * 2;
-    operand2 |= ((U32)instruction_ptr->data_proc.operand2.imm) << (32 - rotate_amount * 2);
-
-    this->R[Rd] = operand2 - this->R[Rn];
-
-    //TODO : ?
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-void GBA_EMUALTOR_ARM7TDMI::ADD_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::ADDS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  rotate_amount = instruction_ptr->data_proc.operand2.rotate;     //rotate right
-    U32 operand2 = 0;
-    U32 rotate_remain_part = 0;
-    U32 Rd_prev_val = this->R[Rn];
-    U8 shift_amount;
-
-    operand2 = ((U32)instruction_ptr->data_proc.operand2.imm) >> rotate_amount * 2;
-    operand2 |= ((U32)instruction_ptr->data_proc.operand2.imm) << (32 - rotate_amount * 2);
-
-    this->R[Rd] =  this->R[Rn] + operand2;
-
-    //TODO : ?
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-void GBA_EMUALTOR_ARM7TDMI::ADC_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::ADCS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  rotate_amount = instruction_ptr->data_proc.operand2.rotate;     //rotate right
-    U32 operand2 = 0;
-    U32 rotate_remain_part = 0;
-    U32 Rd_prev_val = this->R[Rn];
-    U8 shift_amount;
-
-    operand2 = ((U32)instruction_ptr->data_proc.operand2.imm) >> rotate_amount * 2;
-    operand2 |= ((U32)instruction_ptr->data_proc.operand2.imm) << (32 - rotate_amount * 2);
-
-    this->R[Rd] = this->R[Rn] + operand2 + this->CPSR_usr.C;
-
-    //TODO : ?
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-void GBA_EMUALTOR_ARM7TDMI::SBC_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::SBCS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  rotate_amount = instruction_ptr->data_proc.operand2.rotate;     //rotate right
-    U32 operand2 = 0;
-    U32 rotate_remain_part = 0;
-    U32 Rd_prev_val = this->R[Rn];
-    U8 shift_amount;
-
-    operand2 = ((U32)instruction_ptr->data_proc.operand2.imm) >> rotate_amount * 2;
-    operand2 |= ((U32)instruction_ptr->data_proc.operand2.imm) << (32 - rotate_amount * 2);
-
-    this->R[Rd] = this->R[Rn] - operand2 + this->CPSR_usr.C;
-
-    //TODO : ?
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-void GBA_EMUALTOR_ARM7TDMI::RSC_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::RSCS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  rotate_amount = instruction_ptr->data_proc.operand2.rotate;     //rotate right
-    U32 operand2 = 0;
-    U32 rotate_remain_part = 0;
-    U32 Rd_prev_val = this->R[Rn];
-    U8 shift_amount;
-
-    operand2 = ((U32)instruction_ptr->data_proc.operand2.imm) >> rotate_amount * 2;
-    operand2 |= ((U32)instruction_ptr->data_proc.operand2.imm) << (32 - rotate_amount * 2);
-
-    this->R[Rd] = operand2 - this->R[Rn] - 1 + this->CPSR_usr.C;
-
-    //TODO : ?
-    //shift_amount : 0 ~ 31
-    if (shift_amount != 0)
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(shift_amount - 1);
-    }
-    else // shift_amount == 0
-    {
-        this->CPSR_usr.C = this->R[Rm] & BIT(31);
-    }
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !this->R[Rd];
-
-    //update CPSR S
-    this->CPSR_usr.N = this->R[Rd] >> 31;
-}
-
-void GBA_EMUALTOR_ARM7TDMI::TSTS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 Rn = instruction_ptr->data_proc.Rn;
-    U32 Rd = instruction_ptr->data_proc.Rd;
-    U32 Rm = instruction_ptr->data_proc.operand2.Rm;
-    U8  rotate_amount = instruction_ptr->data_proc.operand2.rotate;     //rotate right
-    U32 operand2 = 0;
-    U32 rotate_remain_part = 0;
-    U32 Rd_prev_val = this->R[Rn];
-    U8 shift_amount;
-    U32 discarded_Rd;
-
-    operand2 = ((U32)instruction_ptr->data_proc.operand2.imm) >> rotate_amount * 2;
-    operand2 |= ((U32)instruction_ptr->data_proc.operand2.imm) << (32 - rotate_amount * 2);
-
-    discarded_Rd = this->R[Rn] & operand2;
-
-    //update CPSR Z
-    this->CPSR_usr.Z = !discarded_Rd;
-
-    //update CPSR S
-    this->CPSR_usr.N = discarded_Rd >> 31;
-}
-
-//transfer register contents to PSR
-void GBA_EMUALTOR_ARM7TDMI::MSR_ic(INSTRUCTION_FORMAT *instruction_ptr)
-{
-    U32 source_content;
-
-    //0b101000
-    if (instruction_ptr->psr_tsfr.rsv1 == 0x28)//transfer register contents or immdiate value to PSR flag bits only
-    {
-        if (instruction_ptr->psr_tsfr.I)//immediate
-        {
-            source_content = instruction_ptr->psr_tsfr.source_operand.imm;
-            source_content = source_content << (instruction_ptr->psr_tsfr.source_operand.rotate * 2);
-        }
-        else
-        {
-            source_content = this->R[instruction_ptr->psr_tsfr.source_operand.Rm];
-        }
-    }
-    else 
-    {
-        source_content = this->R[instruction_ptr->psr_tsfr.source_operand.Rm];
-    }
-   
-    if (instruction_ptr->psr_tsfr.Ps) //SPSR
-    {
-        switch (this->mode) 
-        {
-        case  USR_MODE:
-            //??
-            break;
-        case FIQ_MODE:
-            if (instruction_ptr->psr_tsfr.rsv1 == 0x28)//transfer register contents or immdiate value to PSR flag bits only
-            {
-                this->SPSR_fiq.val = source_content & 0x0000000F;
-            }
-            else 
-            {
-                this->SPSR_fiq.val = source_content;
-            }
-            break;
-        case IRQ_MODE:
-            if (instruction_ptr->psr_tsfr.rsv1 == 0x28)//transfer register contents or immdiate value to PSR flag bits only
-            {
-                this->SPSR_irq.val = source_content & 0x0000000F;
-            }
-            else
-            {
-                this->SPSR_irq.val = source_content;
-            }
-            break;
-        case SVC_MODE:
-            if (instruction_ptr->psr_tsfr.rsv1 == 0x28)//transfer register contents or immdiate value to PSR flag bits only
-            {
-                this->SPSR_svc.val = source_content & 0x0000000F;
-            }
-            else
-            {
-                this->SPSR_svc.val = source_content;
-            }
-            break;
-        case ABT_MODE:
-            if (instruction_ptr->psr_tsfr.rsv1 == 0x28)//transfer register contents or immdiate value to PSR flag bits only
-            {
-                this->SPSR_abt.val = source_content & 0x0000000F;
-            }
-            else
-            {
-                this->SPSR_abt.val = source_content;
-            }
-            break;
-        case UND_MODE:
-            if (instruction_ptr->psr_tsfr.rsv1 == 0x28)//transfer register contents or immdiate value to PSR flag bits only
-            {
-                this->SPSR_und.val = source_content & 0x0000000F;
-            }
-            else
-            {
-                this->SPSR_und.val = source_content;
-            }
-            break;
-        case SYS_MODE:
-            //?
-            break;
-        default:
-            while (1);
-        }
-    }
-    else //CPSR
-    {
-        this->SPSR_und.val = source_content;
-    }
-
-}
-
-void GBA_EMUALTOR_ARM7TDMI::TEQS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::CMPS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::MSR_is(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::CMNS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::ORR_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::ORRS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::MOV_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::MOVS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::BIC_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::BICS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::MVN_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::MVNS_imm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ptim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ptim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRT_ptim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRT_ptim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ptim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ptim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRBT_ptim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRBT_ptim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ptip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ptip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRT_ptip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRT_ptip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ptip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ptip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRBT_ptip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRBT_ptip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ofim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ofim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_prim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_prim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ofim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ofim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_prim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_prim(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ofip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ofip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_prip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_prip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ofip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ofip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_prip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_prip(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
-
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ptrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ptrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ptrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ptrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ptrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ptrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ptrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ptrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::STRT_ptrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRT_ptrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRT_ptrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRT_ptrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::LDRT_ptrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRT_ptrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRT_ptrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRT_ptrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ptrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ptrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ptrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ptrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ptrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ptrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ptrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ptrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::STRBT_ptrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRBT_ptrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRBT_ptrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRBT_ptrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-          
-void GBA_EMUALTOR_ARM7TDMI::LDRBT_ptrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRBT_ptrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRBT_ptrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRBT_ptrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ptrpll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ptrplr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ptrpar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ptrprr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ptrpll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ptrplr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ptrpar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ptrprr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::STRT_ptrpll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRT_ptrplr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRT_ptrpar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRT_ptrprr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-         
-void GBA_EMUALTOR_ARM7TDMI::LDRT_ptrpll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRT_ptrplr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRT_ptrpar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRT_ptrprr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ptrpll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ptrplr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ptrpar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ptrprr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-         
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ptrpll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ptrplr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ptrpar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ptrprr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::STRBT_ptrpll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRBT_ptrplr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRBT_ptrpar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRBT_ptrprr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-          
-void GBA_EMUALTOR_ARM7TDMI::LDRBT_ptrpll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRBT_ptrplr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRBT_ptrpar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRBT_ptrprr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ofrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ofrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ofrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ofrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ofrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ofrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ofrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_ofrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::STR_prrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_prrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_prrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_prrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_prrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_prrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_prrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDR_prrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ofrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ofrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ofrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_ofrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-         
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ofrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ofrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ofrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ofrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-         
-void GBA_EMUALTOR_ARM7TDMI::STRB_prrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_prrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_prrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STRB_prrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-         
-void GBA_EMUALTOR_ARM7TDMI::LDRB_prrmll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_prrmlr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_prrmar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::LDRB_prrmrr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ofrpll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ofrplr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-void GBA_EMUALTOR_ARM7TDMI::STR_ofrpar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STR_ofrprr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
-
-
 
-void GBA_EMUALTOR_ARM7TDMI::LDR_ofrpll(INSTRUCTION_FORMAT *instruction_ptr) 
+//transfer an immediate to PSR, the 8 bit value rotated right by twice bit[11:8]
+void GBA_EMUALTOR_ARM7TDMI::MSR_ic(INSTRUCTION_FORMAT *instruction_ptr)
 {
+    write_PSR(instruction_ptr->val, ARM_PSR_TRANSFER::rotated_imm(instruction_ptr->val));
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDR_ofrplr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::MSR_is(INSTRUCTION_FORMAT *instruction_ptr)
 {
+    MSR_ic(instruction_ptr);
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDR_ofrpar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
 
+//offset is shifted left two bits and sign extended, relative to instruction + 8
+void GBA_EMUALTOR_ARM7TDMI::B(INSTRUCTION_FORMAT *instruction_ptr)
+{
+    S32 offset = ARM_BRANCH::offset(instruction_ptr->val);
 
+    this->R[15] = this->R[15] + 4 + offset;
 
-void GBA_EMUALTOR_ARM7TDMI::STR_prrpll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
+    //2S + 1N
+    this->cycles += 2;
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STR_prrplr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::BL(INSTRUCTION_FORMAT *instruction_ptr)
 {
-}
+    S32 offset = ARM_BRANCH::offset(instruction_ptr->val);
 
-void GBA_EMUALTOR_ARM7TDMI::STR_prrpar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
-}
+    //R15 already holds the address of the next instruction
+    this->R[14] = this->R[15];
+    this->R[15] = this->R[15] + 4 + offset;
 
-void GBA_EMUALTOR_ARM7TDMI::STR_prrprr(INSTRUCTION_FORMAT *instruction_ptr) 
-{
+    //2S + 1N
+    this->cycles += 2;
 }
 
+//bit 0 of Rn selects THUMB state
+void GBA_EMUALTOR_ARM7TDMI::BX(INSTRUCTION_FORMAT *instruction_ptr)
+{
+    U32 Rn = ARM_BRANCH_EXCHANGE::Rn(instruction_ptr->val);
+    U32 target = (Rn == 15) ? this->R[15] + 4 : this->R[Rn];
 
+    this->thumb = target & 0x1;
+    this->R[15] = target & ~0x1;
 
-void GBA_EMUALTOR_ARM7TDMI::LDR_prrpll(INSTRUCTION_FORMAT *instruction_ptr) 
-{
+    //2S + 1N
+    this->cycles += 2;
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDR_prrplr(INSTRUCTION_FORMAT *instruction_ptr) 
+//software interrupt : enter supervisor mode at vector 0x08, the comment field is ignored
+void GBA_EMUALTOR_ARM7TDMI::SWI(INSTRUCTION_FORMAT *instruction_ptr)
 {
-}
+    this->SPSR_bank[BANK_SVC].val = get_CPSR();
+    switch_mode(SVC_MODE);
+    this->thumb = 0;
+    this->irq_disable = 1;
+    this->R[14] = this->R[15];
+    this->R[15] = 0x00000008;
 
-void GBA_EMUALTOR_ARM7TDMI::LDR_prrpar(INSTRUCTION_FORMAT *instruction_ptr) 
-{
+    //2S + 1N
+    this->cycles += 2;
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDR_prrprr(INSTRUCTION_FORMAT *instruction_ptr) 
+//undefined instruction space and formats without a handler yet : enter
+//undefined mode at vector 0x04, R14 is the instruction + 4
+void GBA_EMUALTOR_ARM7TDMI::UND(INSTRUCTION_FORMAT *)
 {
-}
+    this->SPSR_bank[BANK_UND].val = get_CPSR();
+    switch_mode(UND_MODE);
+    this->thumb = 0;
+    this->irq_disable = 1;
+    this->R[14] = this->R[15];
+    this->R[15] = 0x00000004;
 
+    //2S + 1N + 1I
+    this->cycles += 3;
+}
 
 
-void GBA_EMUALTOR_ARM7TDMI::STRB_ofrpll(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::STC_ofm(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STRB_ofrplr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::LDC_ofm(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STRB_ofrpar(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::STC_prm(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STRB_ofrprr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::LDC_prm(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
 
-         
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ofrpll(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::STC_ofp(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ofrplr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::LDC_ofp(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ofrpar(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::STC_prp(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDRB_ofrprr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::LDC_prp(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
 
-         
-void GBA_EMUALTOR_ARM7TDMI::STRB_prrpll(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::STC_unm(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STRB_prrplr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::LDC_unm(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STRB_prrpar(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::STC_ptm(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STRB_prrprr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::LDC_ptm(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
 
-         
-void GBA_EMUALTOR_ARM7TDMI::LDRB_prrpll(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::STC_unp(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDRB_prrplr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::LDC_unp(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDRB_prrpar(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::STC_ptp(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDRB_prrprr(INSTRUCTION_FORMAT *instruction_ptr) 
+void GBA_EMUALTOR_ARM7TDMI::LDC_ptp(INSTRUCTION_FORMAT *instruction_ptr)
 {
 }
 
 
 
-void GBA_EMUALTOR_ARM7TDMI::STMDA(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+//-----------------------------------------------------------------------------
+//THUMB state, see run_thumb(). every format is the ARM instruction it expands
+//to, flags and cycles are the same
+//-----------------------------------------------------------------------------
 
-void GBA_EMUALTOR_ARM7TDMI::LDMDA(INSTRUCTION_FORMAT *instruction_ptr)
+//LSL/LSR/ASR Rd, Rs, #offset : MOVS Rd, Rs, <shift> #offset, #0 of LSR and ASR is #32
+template<U32 OP>
+void GBA_EMUALTOR_ARM7TDMI::thumb_move_shifted(U32 instruction)
 {
-}
+    U32 carry = flag_C();
+    U32 result = shift_by_immediate<OP>(this->R[THUMB_MOVE_SHIFTED::Rs(instruction)], THUMB_MOVE_SHIFTED::offset(instruction), carry);
 
-void GBA_EMUALTOR_ARM7TDMI::STMDA_w(INSTRUCTION_FORMAT *instruction_ptr)
-{
+    this->R[THUMB_MOVE_SHIFTED::Rd(instruction)] = result;
+    set_flags_logic(result, carry);
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDMDA_w(INSTRUCTION_FORMAT *instruction_ptr)
+//ADD/SUB Rd, Rs, Rn or #imm3, flags always set
+template<U32 I, U32 SUB>
+void GBA_EMUALTOR_ARM7TDMI::thumb_add_subtract(U32 instruction)
 {
-}
+    U32 operand1 = this->R[THUMB_ADD_SUBTRACT::Rs(instruction)];
+    U32 operand2 = I ? THUMB_ADD_SUBTRACT::Rn(instruction) : this->R[THUMB_ADD_SUBTRACT::Rn(instruction)];
+    U32 result;
 
-void GBA_EMUALTOR_ARM7TDMI::STMDA_u(INSTRUCTION_FORMAT *instruction_ptr)
-{
+    if constexpr (SUB)
+    {
+        result = operand1 - operand2;
+        set_flags_sub(operand1, operand2, 1, result);
+    }
+    else
+    {
+        result = operand1 + operand2;
+        set_flags_add(operand1, operand2, 0, result);
+    }
+    this->R[THUMB_ADD_SUBTRACT::Rd(instruction)] = result;
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDMDA_u(INSTRUCTION_FORMAT *instruction_ptr)
+//MOV/CMP/ADD/SUB Rd, #offset8, flags always set
+template<U32 OP>
+void GBA_EMUALTOR_ARM7TDMI::thumb_immediate(U32 instruction)
 {
-}
+    U32 Rd = THUMB_IMMEDIATE::Rd(instruction);
+    U32 operand1 = this->R[Rd];
+    U32 operand2 = THUMB_IMMEDIATE::offset(instruction);
+    U32 result;
 
-void GBA_EMUALTOR_ARM7TDMI::STMDA_uw(INSTRUCTION_FORMAT *instruction_ptr)
-{
+    switch (OP)
+    {
+        case THUMB_IMM_MOV:
+            this->R[Rd] = operand2;
+            set_flags_logic(operand2, flag_C());
+            break;
+        case THUMB_IMM_CMP:
+            set_flags_sub(operand1, operand2, 1, operand1 - operand2);
+            break;
+        case THUMB_IMM_ADD:
+            result = operand1 + operand2;
+            set_flags_add(operand1, operand2, 0, result);
+            this->R[Rd] = result;
+            break;
+        default: //THUMB_IMM_SUB
+            result = operand1 - operand2;
+            set_flags_sub(operand1, operand2, 1, result);
+            this->R[Rd] = result;
+            break;
+    }
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDMDA_uw(INSTRUCTION_FORMAT *instruction_ptr)
+//<op> Rd, Rs, flags always set. the shifts take the amount from the bottom
+//byte of Rs like a register shifted operand2
+template<U32 OP>
+void GBA_EMUALTOR_ARM7TDMI::thumb_alu(U32 instruction)
 {
-}
+    const bool test = (OP == THUMB_ALU_TST) || (OP == THUMB_ALU_CMP) || (OP == THUMB_ALU_CMN);
+    const U32 shift = (OP == THUMB_ALU_LSL) ? LSL : (OP == THUMB_ALU_LSR) ? LSR : (OP == THUMB_ALU_ASR) ? ASR : ROR;
 
-void GBA_EMUALTOR_ARM7TDMI::STMIA(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+    U32 Rd = THUMB_ALU::Rd(instruction);
+    U32 operand1 = this->R[Rd];
+    U32 operand2 = this->R[THUMB_ALU::Rs(instruction)];
+    U32 carry_in = flag_C();
+    U32 carry = carry_in;
+    U32 result;
 
-void GBA_EMUALTOR_ARM7TDMI::LDMIA(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+    switch (OP)
+    {
+        case THUMB_ALU_AND:
+        case THUMB_ALU_TST:
+            result = operand1 & operand2;
+            set_flags_logic(result, carry);
+            break;
+        case THUMB_ALU_EOR:
+            result = operand1 ^ operand2;
+            set_flags_logic(result, carry);
+            break;
+        case THUMB_ALU_LSL:
+        case THUMB_ALU_LSR:
+        case THUMB_ALU_ASR:
+        case THUMB_ALU_ROR:
+            result = shift_by_register<shift>(operand1, operand2 & 0xFF, carry);
+            set_flags_logic(result, carry);
+
+            //1I
+            this->cycles += 1;
+            break;
+        case THUMB_ALU_ADC:
+            result = operand1 + operand2 + carry_in;
+            set_flags_add(operand1, operand2, carry_in, result);
+            break;
+        case THUMB_ALU_SBC:
+            result = operand1 - operand2 - (carry_in ^ 1);
+            set_flags_sub(operand1, operand2, carry_in, result);
+            break;
+        case THUMB_ALU_NEG:
+            result = 0 - operand2;
+            set_flags_sub(0, operand2, 1, result);
+            break;
+        case THUMB_ALU_CMP:
+            result = operand1 - operand2;
+            set_flags_sub(operand1, operand2, 1, result);
+            break;
+        case THUMB_ALU_CMN:
+            result = operand1 + operand2;
+            set_flags_add(operand1, operand2, 0, result);
+            break;
+        case THUMB_ALU_ORR:
+            result = operand1 | operand2;
+            set_flags_logic(result, carry);
+            break;
+        case THUMB_ALU_MUL:
+            //C is meaningless (left as is), like MULS
+            result = operand1 * operand2;
+            set_flags_logic(result, carry);
+            break;
+        case THUMB_ALU_BIC:
+            result = operand1 & ~operand2;
+            set_flags_logic(result, carry);
+            break;
+        default: //THUMB_ALU_MVN
+            result = ~operand2;
+            set_flags_logic(result, carry);
+            break;
+    }
 
-void GBA_EMUALTOR_ARM7TDMI::STMIA_w(INSTRUCTION_FORMAT *instruction_ptr)
-{
+    if (!test)
+    {
+        this->R[Rd] = result;
+    }
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDMIA_w(INSTRUCTION_FORMAT *instruction_ptr)
+//ADD/CMP/MOV/BX with R8-R15, only CMP sets the flags. R15 reads as the
+//instruction + 4, a written R15 branches, BX with bit 0 of Rs clear enters ARM state
+template<U32 OP, U32 H1, U32 H2>
+void GBA_EMUALTOR_ARM7TDMI::thumb_hi_register(U32 instruction)
 {
-}
+    U32 Rd = THUMB_HI_REGISTER::Rd(instruction) + H1 * 8;
+    U32 Rs = THUMB_HI_REGISTER::Rs(instruction) + H2 * 8;
+    U32 operand1 = (H1 && Rd == 15) ? this->R[15] + 2 : this->R[Rd];
+    U32 operand2 = (H2 && Rs == 15) ? this->R[15] + 2 : this->R[Rs];
 
-void GBA_EMUALTOR_ARM7TDMI::STMIA_u(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+    switch (OP)
+    {
+        case THUMB_HI_ADD:
+            this->R[Rd] = operand1 + operand2;
+            break;
+        case THUMB_HI_CMP:
+            set_flags_sub(operand1, operand2, 1, operand1 - operand2);
+            return;
+        case THUMB_HI_MOV:
+            this->R[Rd] = operand2;
+            break;
+        default: //THUMB_HI_BX
+            this->thumb = operand2 & 0x1;
+            this->R[15] = operand2 & ~0x1;
 
-void GBA_EMUALTOR_ARM7TDMI::LDMIA_u(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+            //2S + 1N
+            this->cycles += 2;
+            return;
+    }
 
-void GBA_EMUALTOR_ARM7TDMI::STMIA_uw(INSTRUCTION_FORMAT *instruction_ptr)
-{
+    //writing R15 refills the pipeline, 1S + 1N
+    if (H1 && Rd == 15)
+    {
+        this->R[15] &= ~0x1;
+        this->cycles += 2;
+    }
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDMIA_uw(INSTRUCTION_FORMAT *instruction_ptr)
+//LDR Rd, [PC, #word8 * 4], PC is the instruction + 4 with bit 1 cleared
+void GBA_EMUALTOR_ARM7TDMI::thumb_pc_load(U32 instruction)
 {
-}
+    U32 address = ((this->R[15] + 2) & ~0x3) + THUMB_RELATIVE::word(instruction) * 4;
 
-void GBA_EMUALTOR_ARM7TDMI::STMDB(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+    this->R[THUMB_RELATIVE::Rd(instruction)] = this->memory.read<U32>(address);
 
-void GBA_EMUALTOR_ARM7TDMI::LDMDB(INSTRUCTION_FORMAT *instruction_ptr)
-{
+    //1S + 1N + 1I
+    this->cycles += 2 + this->memory.waits<U32>(address);
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STMDB_w(INSTRUCTION_FORMAT *instruction_ptr)
+//STR/STRB/LDR/LDRB Rd, [Rb, Ro]
+template<U32 L, U32 B>
+void GBA_EMUALTOR_ARM7TDMI::thumb_register_offset(U32 instruction)
 {
-}
+    U32 Rd = THUMB_REGISTER_OFFSET::Rd(instruction);
+    U32 address = this->R[THUMB_REGISTER_OFFSET::Rb(instruction)] + this->R[THUMB_REGISTER_OFFSET::Ro(instruction)];
 
-void GBA_EMUALTOR_ARM7TDMI::LDMDB_w(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+    if constexpr (L)
+    {
+        if constexpr (B)
+        {
+            this->R[Rd] = this->memory.read<U8>(address);
+            this->cycles += this->memory.waits<U8>(address);
+        }
+        else
+        {
+            //unaligned LDR rotates the addressed byte into bit[7:0]
+            U32 rotate = (address & 0x3) * 8;
+            U32 value = this->memory.read<U32>(address);
 
-void GBA_EMUALTOR_ARM7TDMI::STMDB_u(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+            this->R[Rd] = (value >> rotate) | (value << ((32 - rotate) & 0x1F));
+            this->cycles += this->memory.waits<U32>(address);
+        }
 
-void GBA_EMUALTOR_ARM7TDMI::LDMDB_u(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+        //1S + 1N + 1I
+        this->cycles += 2;
+    }
+    else
+    {
+        if constexpr (B)
+        {
+            this->memory.write<U8>(address, (U8)this->R[Rd]);
+            this->cycles += this->memory.waits<U8>(address);
+        }
+        else
+        {
+            this->memory.write<U32>(address, this->R[Rd]);
+            this->cycles += this->memory.waits<U32>(address);
+        }
 
-void GBA_EMUALTOR_ARM7TDMI::STMDB_uw(INSTRUCTION_FORMAT *instruction_ptr)
-{
+        //2N
+        this->cycles += 1;
+    }
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDMDB_uw(INSTRUCTION_FORMAT *instruction_ptr)
+//STRH/LDRH/LDSB/LDSH Rd, [Rb, Ro], [H:S] 0 STRH, 1 LDSB, 2 LDRH, 3 LDSH.
+//an unaligned LDRH rotates the halfword by 8 bits, an unaligned LDSH loads the
+//addressed byte sign extended
+template<U32 H, U32 S>
+void GBA_EMUALTOR_ARM7TDMI::thumb_sign_extended(U32 instruction)
 {
-}
+    U32 Rd = THUMB_REGISTER_OFFSET::Rd(instruction);
+    U32 address = this->R[THUMB_REGISTER_OFFSET::Rb(instruction)] + this->R[THUMB_REGISTER_OFFSET::Ro(instruction)];
 
-void GBA_EMUALTOR_ARM7TDMI::STMIB(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+    if constexpr (!H && !S)
+    {
+        this->memory.write<U16>(address, (U16)this->R[Rd]);
 
-void GBA_EMUALTOR_ARM7TDMI::LDMIB(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+        //2N
+        this->cycles += 1 + this->memory.waits<U16>(address);
+        return;
+    }
+    else if constexpr (!H)
+    {
+        this->R[Rd] = (U32)(S32)(S8)this->memory.read<U8>(address);
+    }
+    else if constexpr (!S)
+    {
+        U32 value = this->memory.read<U16>(address);
+        U32 rotate = (address & 0x1) * 8;
 
-void GBA_EMUALTOR_ARM7TDMI::STMIB_w(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+        this->R[Rd] = (value >> rotate) | (value << ((32 - rotate) & 0x1F));
+    }
+    else
+    {
+        if (address & 0x1)
+        {
+            this->R[Rd] = (U32)(S32)(S8)this->memory.read<U8>(address);
+        }
+        else
+        {
+            this->R[Rd] = (U32)(S32)(S16)this->memory.read<U16>(address);
+        }
+    }
 
-void GBA_EMUALTOR_ARM7TDMI::LDMIB_w(INSTRUCTION_FORMAT *instruction_ptr)
-{
+    //1S + 1N + 1I
+    this->cycles += 2 + this->memory.waits<U16>(address);
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STMIB_u(INSTRUCTION_FORMAT *instruction_ptr)
+//STR/LDR Rd, [Rb, #offset5 * 4], STRB/LDRB Rd, [Rb, #offset5]
+template<U32 B, U32 L>
+void GBA_EMUALTOR_ARM7TDMI::thumb_immediate_offset(U32 instruction)
 {
-}
+    U32 Rd = THUMB_IMMEDIATE_OFFSET::Rd(instruction);
+    U32 address = this->R[THUMB_IMMEDIATE_OFFSET::Rb(instruction)] + (THUMB_IMMEDIATE_OFFSET::offset(instruction) << (B ? 0 : 2));
 
-void GBA_EMUALTOR_ARM7TDMI::LDMIB_u(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+    if constexpr (L)
+    {
+        if constexpr (B)
+        {
+            this->R[Rd] = this->memory.read<U8>(address);
+            this->cycles += this->memory.waits<U8>(address);
+        }
+        else
+        {
+            U32 rotate = (address & 0x3) * 8;
+            U32 value = this->memory.read<U32>(address);
 
-void GBA_EMUALTOR_ARM7TDMI::STMIB_uw(INSTRUCTION_FORMAT *instruction_ptr)
-{
+            this->R[Rd] = (value >> rotate) | (value << ((32 - rotate) & 0x1F));
+            this->cycles += this->memory.waits<U32>(address);
+        }
+
+        //1S + 1N + 1I
+        this->cycles += 2;
+    }
+    else
+    {
+        if constexpr (B)
+        {
+            this->memory.write<U8>(address, (U8)this->R[Rd]);
+            this->cycles += this->memory.waits<U8>(address);
+        }
+        else
+        {
+            this->memory.write<U32>(address, this->R[Rd]);
+            this->cycles += this->memory.waits<U32>(address);
+        }
+
+        //2N
+        this->cycles += 1;
+    }
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDMIB_uw(INSTRUCTION_FORMAT *instruction_ptr)
+//STRH/LDRH Rd, [Rb, #offset5 * 2]
+template<U32 L>
+void GBA_EMUALTOR_ARM7TDMI::thumb_halfword(U32 instruction)
 {
-}
+    U32 Rd = THUMB_IMMEDIATE_OFFSET::Rd(instruction);
+    U32 address = this->R[THUMB_IMMEDIATE_OFFSET::Rb(instruction)] + THUMB_IMMEDIATE_OFFSET::offset(instruction) * 2;
 
+    if constexpr (L)
+    {
+        U32 value = this->memory.read<U16>(address);
+        U32 rotate = (address & 0x1) * 8;
 
-void GBA_EMUALTOR_ARM7TDMI::B(INSTRUCTION_FORMAT *instruction_ptr)
-{
+        this->R[Rd] = (value >> rotate) | (value << ((32 - rotate) & 0x1F));
+
+        //1S + 1N + 1I
+        this->cycles += 2 + this->memory.waits<U16>(address);
+    }
+    else
+    {
+        this->memory.write<U16>(address, (U16)this->R[Rd]);
+
+        //2N
+        this->cycles += 1 + this->memory.waits<U16>(address);
+    }
 }
 
-void GBA_EMUALTOR_ARM7TDMI::BL(INSTRUCTION_FORMAT *instruction_ptr)
+//STR/LDR Rd, [SP, #word8 * 4]
+template<U32 L>
+void GBA_EMUALTOR_ARM7TDMI::thumb_sp_relative(U32 instruction)
 {
-}
+    U32 Rd = THUMB_RELATIVE::Rd(instruction);
+    U32 address = this->R[13] + THUMB_RELATIVE::word(instruction) * 4;
 
+    if constexpr (L)
+    {
+        U32 rotate = (address & 0x3) * 8;
+        U32 value = this->memory.read<U32>(address);
 
-void GBA_EMUALTOR_ARM7TDMI::STC_ofm(INSTRUCTION_FORMAT *instruction_ptr)
-{
+        this->R[Rd] = (value >> rotate) | (value << ((32 - rotate) & 0x1F));
+
+        //1S + 1N + 1I
+        this->cycles += 2 + this->memory.waits<U32>(address);
+    }
+    else
+    {
+        this->memory.write<U32>(address, this->R[Rd]);
+
+        //2N
+        this->cycles += 1 + this->memory.waits<U32>(address);
+    }
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDC_ofm(INSTRUCTION_FORMAT *instruction_ptr)
+//ADD Rd, PC/SP, #word8 * 4, PC is the instruction + 4 with bit 1 cleared
+template<U32 SP>
+void GBA_EMUALTOR_ARM7TDMI::thumb_load_address(U32 instruction)
 {
+    U32 base = SP ? this->R[13] : (this->R[15] + 2) & ~0x3;
+
+    this->R[THUMB_RELATIVE::Rd(instruction)] = base + THUMB_RELATIVE::word(instruction) * 4;
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STC_prm(INSTRUCTION_FORMAT *instruction_ptr)
+//ADD SP, #+/-word7 * 4
+template<U32 S>
+void GBA_EMUALTOR_ARM7TDMI::thumb_add_sp(U32 instruction)
 {
+    U32 offset = THUMB_ADD_SP::word(instruction) * 4;
+
+    this->R[13] = S ? this->R[13] - offset : this->R[13] + offset;
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDC_prm(INSTRUCTION_FORMAT *instruction_ptr)
+//PUSH {Rlist, LR} : STMDB SP!, POP {Rlist, PC} : LDMIA SP!. a popped PC
+//stays in THUMB state, bit 0 is ignored
+template<U32 L, U32 R>
+void GBA_EMUALTOR_ARM7TDMI::thumb_push_pop(U32 instruction)
 {
-}
+    U32 list = THUMB_MULTIPLE::register_list(instruction);
+    U32 count = R;
+    U32 address;
 
+    for (U32 i = 0; i < 8; i++)
+    {
+        count += (list >> i) & 0x1;
+    }
 
-void GBA_EMUALTOR_ARM7TDMI::STC_ofp(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+    if constexpr (L)
+    {
+        address = this->R[13];
+        for (U32 i = 0; i < 8; i++)
+        {
+            if ((list >> i) & 0x1)
+            {
+                this->R[i] = this->memory.read<U32>(address);
+                this->cycles += this->memory.waits<U32>(address);
+                address += 4;
+            }
+        }
+        if constexpr (R)
+        {
+            this->R[15] = this->memory.read<U32>(address) & ~0x1;
+            this->cycles += this->memory.waits<U32>(address) + 2;
+            address += 4;
+        }
+        this->R[13] = address;
 
-void GBA_EMUALTOR_ARM7TDMI::LDC_ofp(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+        //nS + 1N + 1I, loading R15 adds 1S + 1N
+        this->cycles += count + 1;
+    }
+    else
+    {
+        address = this->R[13] - count * 4;
+        this->R[13] = address;
+        for (U32 i = 0; i < 8; i++)
+        {
+            if ((list >> i) & 0x1)
+            {
+                this->memory.write<U32>(address, this->R[i]);
+                this->cycles += this->memory.waits<U32>(address);
+                address += 4;
+            }
+        }
+        if constexpr (R)
+        {
+            this->memory.write<U32>(address, this->R[14]);
+            this->cycles += this->memory.waits<U32>(address);
+        }
 
-void GBA_EMUALTOR_ARM7TDMI::STC_prp(INSTRUCTION_FORMAT *instruction_ptr)
-{
+        //(n - 1)S + 2N
+        this->cycles += count;
+    }
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDC_prp(INSTRUCTION_FORMAT *instruction_ptr)
+//STMIA/LDMIA Rb!, {Rlist}. a loaded Rb wins over the written back one, a
+//stored Rb is the old base only when it is the lowest register, as in ARM state
+template<U32 L>
+void GBA_EMUALTOR_ARM7TDMI::thumb_multiple(U32 instruction)
 {
-}
+    U32 Rb = THUMB_MULTIPLE::Rb(instruction);
+    U32 list = THUMB_MULTIPLE::register_list(instruction);
+    U32 address = this->R[Rb];
+    U32 count = 0;
+    U32 written_back;
 
+    for (U32 i = 0; i < 8; i++)
+    {
+        count += (list >> i) & 0x1;
+    }
+    written_back = address + count * 4;
 
-void GBA_EMUALTOR_ARM7TDMI::STC_unm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+    if constexpr (L)
+    {
+        this->R[Rb] = written_back;
+        for (U32 i = 0; i < 8; i++)
+        {
+            if ((list >> i) & 0x1)
+            {
+                this->R[i] = this->memory.read<U32>(address);
+                this->cycles += this->memory.waits<U32>(address);
+                address += 4;
+            }
+        }
 
-void GBA_EMUALTOR_ARM7TDMI::LDC_unm(INSTRUCTION_FORMAT *instruction_ptr)
-{
-}
+        //nS + 1N + 1I
+        this->cycles += count + 1;
+    }
+    else
+    {
+        bool first = true;
 
-void GBA_EMUALTOR_ARM7TDMI::STC_ptm(INSTRUCTION_FORMAT *instruction_ptr)
-{
+        for (U32 i = 0; i < 8; i++)
+        {
+            if ((list >> i) & 0x1)
+            {
+                this->memory.write<U32>(address, this->R[i]);
+                this->cycles += this->memory.waits<U32>(address);
+                address += 4;
+                if (first)
+                {
+                    this->R[Rb] = written_back;
+                }
+                first = false;
+            }
+        }
+
+        //(n - 1)S + 2N
+        this->cycles += count;
+    }
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDC_ptm(INSTRUCTION_FORMAT *instruction_ptr)
+//B<cond> label, the offset is relative to the instruction + 4
+template<U32 COND>
+void GBA_EMUALTOR_ARM7TDMI::thumb_conditional_branch(U32 instruction)
 {
-}
+    if (!check_condition(COND))
+    {
+        return;
+    }
+    this->R[15] = this->R[15] + 2 + THUMB_CONDITIONAL_BRANCH::offset(instruction);
 
+    //2S + 1N
+    this->cycles += 2;
+}
 
-void GBA_EMUALTOR_ARM7TDMI::STC_unp(INSTRUCTION_FORMAT *instruction_ptr)
+//SWI in ARM state, R14 is the next halfword and the SPSR keeps T set, so
+//MOVS PC, R14 returns to THUMB state
+void GBA_EMUALTOR_ARM7TDMI::thumb_SWI(U32 instruction)
 {
+    INSTRUCTION_FORMAT format;
+
+    format.val = instruction;
+    SWI(&format);
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDC_unp(INSTRUCTION_FORMAT *instruction_ptr)
+//B label, the offset is relative to the instruction + 4
+void GBA_EMUALTOR_ARM7TDMI::thumb_B(U32 instruction)
 {
+    this->R[15] = this->R[15] + 2 + THUMB_BRANCH::offset(instruction);
+
+    //2S + 1N
+    this->cycles += 2;
 }
 
-void GBA_EMUALTOR_ARM7TDMI::STC_ptp(INSTRUCTION_FORMAT *instruction_ptr)
+//BL label is two halfwords : H = 0 puts the instruction + 4 plus the high part
+//of the offset in LR, H = 1 adds the low part, branches and leaves the return
+//address with bit 0 set in LR
+template<U32 H>
+void GBA_EMUALTOR_ARM7TDMI::thumb_BL(U32 instruction)
 {
+    if constexpr (!H)
+    {
+        this->R[14] = this->R[15] + 2 + THUMB_LONG_BRANCH::high_offset(instruction);
+    }
+    else
+    {
+        U32 next = this->R[15];
+
+        this->R[15] = this->R[14] + THUMB_LONG_BRANCH::offset(instruction) * 2;
+        this->R[14] = next | 0x1;
+
+        //2S + 1N
+        this->cycles += 2;
+    }
 }
 
-void GBA_EMUALTOR_ARM7TDMI::LDC_ptp(INSTRUCTION_FORMAT *instruction_ptr)
+//undefined in ARM state, R14 is the next halfword like thumb_SWI
+void GBA_EMUALTOR_ARM7TDMI::thumb_UND(U32 instruction)
 {
+    INSTRUCTION_FORMAT format;
+
+    format.val = instruction;
+    UND(&format);
 }
 
 
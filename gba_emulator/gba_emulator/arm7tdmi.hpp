@@ -7,11 +7,11 @@
 typedef unsigned char  U8;
 typedef unsigned short U16;
 typedef unsigned int   U32;
-typedef unsigned long  U64;
+typedef unsigned long long U64;
 typedef          char  S8;
 typedef          short S16;
 typedef          int   S32;
-typedef          long  S64;
+typedef          long long S64;
 
 
 #define BIT(n)         (1 << n)
@@ -62,20 +62,32 @@ typedef          long  S64;
 #define OBJ_ATTR_RAM_SIZE                        (0x00000400)
 //external memory(game pak)
 #define CARTRIDGE_ROM_WAIT_STATE_0_BASE_LOG      (0x08000000)
-#define CARTRIDGE_ROM_WAIT_STATE_0_SIZE          (0x01000000)
-
-
+#define CARTRIDGE_ROM_WAIT_STATE_0_SIZE          (0x02000000)
+#define CARTRIDGE_ROM_WAIT_STATE_1_BASE_LOG      (0x0A000000)   //same ROM as wait state 0, other timing
+#define CARTRIDGE_ROM_WAIT_STATE_2_BASE_LOG      (0x0C000000)
+
+//I/O registers, offsets from IO_REGISTER_BASE_LOG
+#define IO_DISPSTAT                              (0x004)        //bit[2:0] status, read only
+#define IO_VCOUNT                                (0x006)        //read only
+#define IO_KEYINPUT                              (0x130)        //read only, a set bit is a released key
+#define IO_IE                                    (0x200)
+#define IO_IF                                    (0x202)        //writing 1 acknowledges
+#define IO_IME                                   (0x208)
+
+
+//offsets into MEMORY::raw_data, each region sized to its own contents. the
+//regions mapped by 16KB pages start on a page and the three small regions
+//share the last one. the game pak ROM is mapped separately, see map_rom()
 #define BIOS_BASE_PHY                            (0x00000000)
 #define ON_BOARD_WRAM_BASE_PHY                   (BIOS_BASE_PHY          + BIOS_SIZE)
 #define ON_CHIP_WRAM_BASE_PHY                    (ON_BOARD_WRAM_BASE_PHY + ON_BOARD_WRAM_SIZE)
-#define IO_REGISTER_BASE_PHY                     (ON_CHIP_WRAM_BASE_PHY  + ON_CHIP_WRAM_SIZE)
+#define VIDEO_RAM_BASE_PHY                       (ON_CHIP_WRAM_BASE_PHY  + ON_CHIP_WRAM_SIZE)
+#define IO_REGISTER_BASE_PHY                     (VIDEO_RAM_BASE_PHY     + VIDEO_RAM_SIZE)
 #define PALETTE_RAM_BASE_PHY                     (IO_REGISTER_BASE_PHY   + IO_REGISTER_SIZE)
-#define VIDEO_RAM_BASE_PHY                       (PALETTE_RAM_BASE_PHY   + PALETTE_RAM_SIZE)
-#define OBJ_ATTR_RAM_BASE_PHY                    (VIDEO_RAM_BASE_PHY     + VIDEO_RAM_SIZE)
-#define CARTRIDGE_ROM_WAIT_STATE_0_BASE_PHY      (OBJ_ATTR_RAM_BASE_PHY  + OBJ_ATTR_RAM_SIZE)
+#define OBJ_ATTR_RAM_BASE_PHY                    (PALETTE_RAM_BASE_PHY   + PALETTE_RAM_SIZE)
 
 
-#define ALLOCATED_MEMORY_SIZE                (BIOS_SIZE + ON_BOARD_WRAM_SIZE + ON_CHIP_WRAM_SIZE + IO_REGISTER_SIZE + PALETTE_RAM_SIZE + VIDEO_RAM_SIZE + OBJ_ATTR_RAM_SIZE + CARTRIDGE_ROM_WAIT_STATE_0_SIZE)
+#define ALLOCATED_MEMORY_SIZE                (IO_REGISTER_BASE_PHY + 0x00004000)
 
 #define NUM_OF_REGISTER     (16)
 #define USR_MODE            (0x10)    // 10000b
@@ -86,285 +98,446 @@ typedef          long  S64;
 #define UND_MODE            (0x1B)    // 11011b
 #define SYS_MODE            (0x1F)    // 11111b
 
+//register banks, the compact index of a mode. system mode shares the user
+//bank, an undefined mode bit pattern falls back to it
+#define BANK_USR            (0)
+#define BANK_FIQ            (1)
+#define BANK_IRQ            (2)
+#define BANK_SVC            (3)
+#define BANK_ABT            (4)
+#define BANK_UND            (5)
+#define BANK_COUNT          (6)
+
+
+//data processing opcode, instruction bit[24:21]
+#define OPC_AND             (0x0)
+#define OPC_EOR             (0x1)
+#define OPC_SUB             (0x2)
+#define OPC_RSB             (0x3)
+#define OPC_ADD             (0x4)
+#define OPC_ADC             (0x5)
+#define OPC_SBC             (0x6)
+#define OPC_RSC             (0x7)
+#define OPC_TST             (0x8)
+#define OPC_TEQ             (0x9)
+#define OPC_CMP             (0xA)
+#define OPC_CMN             (0xB)
+#define OPC_ORR             (0xC)
+#define OPC_MOV             (0xD)
+#define OPC_BIC             (0xE)
+#define OPC_MVN             (0xF)
+
+//instruction bit[31:28]
+#define COND_EQ             (0x0)     //Z set                         equal
+#define COND_NE             (0x1)     //Z clear                     not equal
+#define COND_CS             (0x2)     //C set                       unsigned higher or same
+#define COND_CC             (0x3)     //C clear                     unsigned lower
+#define COND_MI             (0x4)     //N set                       negative
+#define COND_PL             (0x5)     //N clear                     positive or zero
+#define COND_VS             (0x6)     //V set                       overflow
+#define COND_VC             (0x7)     //V clear                     no overflow
+#define COND_HI             (0x8)     //C set and Z clear           unsigned higher
+#define COND_LS             (0x9)     //C clear or Z set            unsigned lower or same
+#define COND_GE             (0xA)     //N equals V                  greater or equal
+#define COND_LT             (0xB)     //N not equal to V            less than
+#define COND_GT             (0xC)     //Z clear AND (N equals V)    greater than
+#define COND_LE             (0xD)     //Z set OR (N not equal to V) less than or equal
+#define COND_AL             (0xE)     //(ignored)                   always
+
+//instruction bit[6:5]
+#define LSL     (0x0)     //logical left
+#define LSR     (0x1)     //logical right
+#define ASR     (0x2)     //arithmetic right
+#define ROR     (0x3)     //rotate right
+
+//instruction bit[4]
+#define SHIFT_SOURCE_AMOUNT   (0x0)
+#define SHIFT_SOURCE_REGSITER (0x1)
+
+//data processing operand2 form, instruction bit[6:4] when operand2 is a register
+#define OPERAND2_LLI        (0x0)     //logical left by immediate
+#define OPERAND2_LLR        (0x1)     //logical left by register
+#define OPERAND2_LRI        (0x2)     //logical right by immediate
+#define OPERAND2_LRR        (0x3)     //logical right by register
+#define OPERAND2_ARI        (0x4)     //arithmetic right by immediate
+#define OPERAND2_ARR        (0x5)     //arithmetic right by register
+#define OPERAND2_RRI        (0x6)     //rotate right by immediate
+#define OPERAND2_RRR        (0x7)     //rotate right by register
+#define OPERAND2_IMM        (0x8)     //rotated 8 bit immediate
+
+//THUMB move/compare/add/subtract immediate opcode, instruction bit[12:11]
+#define THUMB_IMM_MOV       (0x0)
+#define THUMB_IMM_CMP       (0x1)
+#define THUMB_IMM_ADD       (0x2)
+#define THUMB_IMM_SUB       (0x3)
+
+//THUMB ALU operation, instruction bit[9:6]
+#define THUMB_ALU_AND       (0x0)
+#define THUMB_ALU_EOR       (0x1)
+#define THUMB_ALU_LSL       (0x2)
+#define THUMB_ALU_LSR       (0x3)
+#define THUMB_ALU_ASR       (0x4)
+#define THUMB_ALU_ADC       (0x5)
+#define THUMB_ALU_SBC       (0x6)
+#define THUMB_ALU_ROR       (0x7)
+#define THUMB_ALU_TST       (0x8)
+#define THUMB_ALU_NEG       (0x9)
+#define THUMB_ALU_CMP       (0xA)
+#define THUMB_ALU_CMN       (0xB)
+#define THUMB_ALU_ORR       (0xC)
+#define THUMB_ALU_MUL       (0xD)
+#define THUMB_ALU_BIC       (0xE)
+#define THUMB_ALU_MVN       (0xF)
+
+//THUMB hi register operation, instruction bit[9:8]
+#define THUMB_HI_ADD        (0x0)
+#define THUMB_HI_CMP        (0x1)
+#define THUMB_HI_MOV        (0x2)
+#define THUMB_HI_BX         (0x3)
+
+//block cache
+#define BLOCK_CACHE_SIZE        (512)           //blocks, direct mapped on the guest PC
+#define BLOCK_MAX_INSTRUCTIONS  (32)
+#define BLOCK_INVALID           (0x00000001)    //never the PC of an ARM instruction
+#define BLOCK_UNTRACKED         (0x00000000)    //code_offset of a block outside of WRAM, BIOS_BASE_PHY is never tracked
+
+//what run_threaded() does around a cached instruction's handler
+#define DISPATCH_ALWAYS             (0x0)       //cond AL
+#define DISPATCH_CONDITIONAL        (0x1)       //check cond first
+#define DISPATCH_ALWAYS_STORE       (0x2)       //cond AL, may write memory and invalidate its own block
+#define DISPATCH_CONDITIONAL_STORE  (0x3)
+#define DISPATCH_END                (0x4)       //one past the last instruction of a block
+
+//direct threaded dispatch needs labels as values (GCC, Clang), other compilers
+//and builds defining GBA_NO_THREADED_DISPATCH get the plain loop
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(GBA_NO_THREADED_DISPATCH)
+#define GBA_THREADED_DISPATCH   (1)
+#else
+#define GBA_THREADED_DISPATCH   (0)
+#endif
+
+
+
+
+
+//the instruction word a handler gets, its fields are decoded with the
+//extractors below
+typedef struct instruction_format
+{
+    U32 val;
+}INSTRUCTION_FORMAT;
 
 
+//instruction fields : a shift and a mask of the instruction word, constexpr,
+//so a field of a constant word or of a handler specialized on it folds into
+//an immediate. one struct per instruction format, named after the format,
+//bit positions as in the data sheet, chapter 4
+#define INSTRUCTION_FIELD(NAME, SHIFT, WIDTH)                                           \
+    static constexpr U32 NAME(U32 instruction)                                          \
+    {                                                                                   \
+        return (instruction >> (SHIFT)) & ((1u << (WIDTH)) - 1);                        \
+    }
 
-#pragma pack(1)
+//fields every format has
+struct ARM_INSTRUCTION
+{
+    INSTRUCTION_FIELD(group,         25, 3)     //bit[27:25], the first split of the instruction space
+    INSTRUCTION_FIELD(cond,          28, 4)     //COND_*
+};
 
+//Data Processing/PSR Transfer
+struct ARM_DATA_PROC : ARM_INSTRUCTION
+{
+    INSTRUCTION_FIELD(Rm,             0, 4)
+    INSTRUCTION_FIELD(shift_source,   4, 1)     //SHIFT_SOURCE_*
+    INSTRUCTION_FIELD(shift_type,     5, 2)     //LSL, LSR, ASR, ROR
+    INSTRUCTION_FIELD(shift_amount,   7, 5)     //shift_source = SHIFT_SOURCE_AMOUNT
+    INSTRUCTION_FIELD(Rs,             8, 4)     //shift_source = SHIFT_SOURCE_REGSITER
+    INSTRUCTION_FIELD(imm,            0, 8)     //I = 1
+    INSTRUCTION_FIELD(rotate,         8, 4)     //I = 1, the immediate is rotated right by twice this
+    INSTRUCTION_FIELD(Rd,            12, 4)
+    INSTRUCTION_FIELD(Rn,            16, 4)
+    INSTRUCTION_FIELD(S,             20, 1)
+    INSTRUCTION_FIELD(opcode,        21, 4)     //OPC_*
+    INSTRUCTION_FIELD(I,             25, 1)
+
+    //the 8 bit immediate rotated right by twice rotate
+    static constexpr U32 rotated_imm(U32 instruction)
+    {
+        return (imm(instruction) >> (rotate(instruction) * 2)) | (imm(instruction) << ((32 - rotate(instruction) * 2) & 0x1F));
+    }
+};
 
+//PSR Transfer, MRS and MSR
+struct ARM_PSR_TRANSFER : ARM_DATA_PROC
+{
+    INSTRUCTION_FIELD(field_mask,    16, 4)     //MSR : bit 3 flags, 2 status, 1 extension, 0 control byte
+    INSTRUCTION_FIELD(P,             22, 1)     //0 : CPSR, 1 : SPSR of the current mode
+};
 
-typedef struct instruction_format
+//Multiply
+struct ARM_MULTIPLY : ARM_INSTRUCTION
 {
-    //Data Processing/PSR Transfer
-    union
-    {
-		struct
-		{
-            //operand2 is a register
-			union 
-			{
-				U32 Rm : 4;
-
-                struct // : 8         //apply to Rm
-                {
-                    union
-                    {
-                        U32 register_or_amount : 1;         // = 0
-                        U32 shift_type : 2;
-                        U32 shift_amount : 5;  //5 bit unsigned integer
-                    };
-                    union
-                    {
-                        U32 register_or_amount : 1;          // = 1
-                        U32 shift_type : 2;
-                        U32 rsv1 : 1;
-                        U32 shift_reg : 4;     //shift amount specified in botom byte of Rs
-                    };
-                }shift;							
-			};
-
-            //operand2 is an immediate value
-			union 
-			{
-				U32 imm : 8;
-				U32 rotate : 4;				
-			};
-		}operand2;
-		
-        U32 Rd : 4;
-        U32 Rn : 4;
-        U32 S : 1;
-        U32 opc : 4;
-        U32 I : 1;
-        U32 rsv : 2;
-        U32 cond : 4;
-    }data_proc;
-
-    //Multiply
-    union
-    {
-        U32 Rm : 4;
-        U32 rsv0 : 4;
-        U32 Rs : 4;
-        U32 Rn : 4;
-        U32 Rd : 4;
-        U32 S : 1;
-        U32 A : 1;
-        U32 rsv1 : 6;
-        U32 cond : 4;
-    }multply;
-
-    //Multiply Long
-    union
-    {
-        U32 Rm : 4;
-        U32 rsv0 : 4;
-        U32 Rs : 4;
-        U32 RdLo : 4;
-        U32 RdHi : 4;
-        U32 S : 1;
-        U32 A : 1;
-        U32 U : 1;
-        U32 rsv1 : 5;
-        U32 cond : 4;
-    }multply_long;
-
-    //Single Data Swap
-    union
-    {
-        U32 Rm : 4;
-        U32 rsv1 : 8;
-        U32 Rd : 4;
-        U32 Rn : 4;
-        U32 rsv2 : 2;
-        U32 B : 1;
-        U32 rsv : 5;
-        U32 cond : 4;
-    }single_data_swap;
-
-    //Branch and Exchange
-    union
-    {
-        U32 Rn : 4;
-        U32 rsv : 24;
-        U32 cond : 4;
-    }branch_exchange;
+    INSTRUCTION_FIELD(Rm,             0, 4)
+    INSTRUCTION_FIELD(Rs,             8, 4)
+    INSTRUCTION_FIELD(Rn,            12, 4)
+    INSTRUCTION_FIELD(Rd,            16, 4)
+    INSTRUCTION_FIELD(S,             20, 1)
+    INSTRUCTION_FIELD(A,             21, 1)
+};
 
-    //Halfword Data Transfer : register offset
-    union
-    {
-        U32 Rm : 4;
-        U32 rsv1 : 1;
-        U32 H : 1;
-        U32 S : 1;
-        U32 rsv2 : 5;
-        U32 Rd : 4;
-        U32 Rn : 4;
-        U32 L : 1;
-        U32 W : 1;
-        U32 rsv3 : 1;
-        U32 U : 1;
-        U32 P : 1;
-        U32 rsv4 : 3;
-        U32 cond : 4;
-    }hlf_data_tsf_reg_ofst;
-
-    //Halfword Data Transfer : immediate offset
-    union
-    {
-        U32 offset0 : 4;
-        U32 rsv1 : 1;
-        U32 H : 1;
-        U32 S : 1;
-        U32 rsv2 : 1;
-        U32 offset1 : 4;
-        U32 Rd : 4;
-        U32 Rn : 4;
-        U32 L : 1;
-        U32 W : 1;
-        U32 rsv3 : 1;
-        U32 U : 1;
-        U32 P : 1;
-        U32 rsv4 : 3;
-        U32 cond : 4;
-    }hlf_data_tsf_imm_ofst;
-
-    //Single Data Transfer
-    union
-    {
-        U32 offset : 12;
-        U32 Rd : 4;
-        U32 Rn : 4;
-        U32 L : 1;
-        U32 W : 1;
-        U32 B : 1;
-        U32 U : 1;
-        U32 P : 1;
-        U32 I : 1;
-        U32 rsv : 2;
-        U32 cond : 4;
-    }single_data_tsf;
-
-    //Undefined
-    union
-    {
-        U32 rsv1 : 28;
-        U32 cond : 4;
-    }undefined;
+//Multiply Long
+struct ARM_MULTIPLY_LONG : ARM_INSTRUCTION
+{
+    INSTRUCTION_FIELD(Rm,             0, 4)
+    INSTRUCTION_FIELD(Rs,             8, 4)
+    INSTRUCTION_FIELD(RdLo,          12, 4)
+    INSTRUCTION_FIELD(RdHi,          16, 4)
+    INSTRUCTION_FIELD(S,             20, 1)
+    INSTRUCTION_FIELD(A,             21, 1)
+    INSTRUCTION_FIELD(U,             22, 1)     //1 : signed
+};
 
-    //Block Data Transfer
-    union
-    {
-        U32 reg_list : 16;
-        U32 Rn : 4;
-        U32 L : 1;
-        U32 W : 1;
-        U32 B : 1;
-        U32 U : 1;
-        U32 P : 1;
-        U32 rsv : 3;
-        U32 cond : 4;
-    }blk_data_tsf;
-
-    //Branch
-    union
-    {
-        U32 offset : 24;
-        U32 L : 1;
-        U32 rsv : 3;
-        U32 cond : 4;
-    }branch;
+//Single Data Swap
+struct ARM_SWAP : ARM_INSTRUCTION
+{
+    INSTRUCTION_FIELD(Rm,             0, 4)
+    INSTRUCTION_FIELD(Rd,            12, 4)
+    INSTRUCTION_FIELD(Rn,            16, 4)
+    INSTRUCTION_FIELD(B,             22, 1)
+};
 
-    //Coprocessor Data Transfer
-    union
+//Branch and Exchange
+struct ARM_BRANCH_EXCHANGE : ARM_INSTRUCTION
+{
+    INSTRUCTION_FIELD(Rn,             0, 4)
+};
+
+//Halfword Data Transfer, register (I = 0) and immediate (I = 1) offset
+struct ARM_HALFWORD_TRANSFER : ARM_INSTRUCTION
+{
+    INSTRUCTION_FIELD(Rm,             0, 4)
+    INSTRUCTION_FIELD(offset_low,     0, 4)
+    INSTRUCTION_FIELD(H,              5, 1)
+    INSTRUCTION_FIELD(S,              6, 1)
+    INSTRUCTION_FIELD(offset_high,    8, 4)
+    INSTRUCTION_FIELD(Rd,            12, 4)
+    INSTRUCTION_FIELD(Rn,            16, 4)
+    INSTRUCTION_FIELD(L,             20, 1)
+    INSTRUCTION_FIELD(W,             21, 1)
+    INSTRUCTION_FIELD(I,             22, 1)
+    INSTRUCTION_FIELD(U,             23, 1)
+    INSTRUCTION_FIELD(P,             24, 1)
+
+    static constexpr U32 offset(U32 instruction)
     {
-        U32 offset : 8;
-        U32 CPn : 4;
-        U32 CRd : 4;
-        U32 Rn : 4;
-        U32 L : 1;
-        U32 W : 1;
-        U32 N : 1;
-        U32 U : 1;
-        U32 P : 1;
-        U32 rsv : 3;
-        U32 cond : 4;
-    }cop_data_tfr;
-
-    //Coprocessor Data Operation
-    union
+        return (offset_high(instruction) << 4) | offset_low(instruction);
+    }
+};
+
+//Single Data Transfer
+struct ARM_SINGLE_TRANSFER : ARM_INSTRUCTION
+{
+    INSTRUCTION_FIELD(offset,         0, 12)    //I = 0
+    INSTRUCTION_FIELD(Rm,             0, 4)     //I = 1, shifted by an immediate like operand2
+    INSTRUCTION_FIELD(shift_type,     5, 2)
+    INSTRUCTION_FIELD(shift_amount,   7, 5)
+    INSTRUCTION_FIELD(Rd,            12, 4)
+    INSTRUCTION_FIELD(Rn,            16, 4)
+    INSTRUCTION_FIELD(L,             20, 1)
+    INSTRUCTION_FIELD(W,             21, 1)
+    INSTRUCTION_FIELD(B,             22, 1)
+    INSTRUCTION_FIELD(U,             23, 1)
+    INSTRUCTION_FIELD(P,             24, 1)
+    INSTRUCTION_FIELD(I,             25, 1)
+};
+
+//Block Data Transfer
+struct ARM_BLOCK_TRANSFER : ARM_INSTRUCTION
+{
+    INSTRUCTION_FIELD(register_list,  0, 16)
+    INSTRUCTION_FIELD(Rn,            16, 4)
+    INSTRUCTION_FIELD(L,             20, 1)
+    INSTRUCTION_FIELD(W,             21, 1)
+    INSTRUCTION_FIELD(S,             22, 1)
+    INSTRUCTION_FIELD(U,             23, 1)
+    INSTRUCTION_FIELD(P,             24, 1)
+};
+
+//Branch
+struct ARM_BRANCH : ARM_INSTRUCTION
+{
+    INSTRUCTION_FIELD(L,             24, 1)
+
+    //the 24 bit word offset, sign extended and shifted into bytes
+    static constexpr S32 offset(U32 instruction)
     {
-        U32 CRm : 4;
-        U32 rsv0 : 1;
-        U32 CP : 3;
-        U32 CPn : 4;
-        U32 CPd : 4;
-        U32 CRn : 4;
-        U32 CP_opc : 4;
-        U32 rsv1 : 4;
-        U32 cond : 4;
-
-    }cop_data_op;
-
-    //Coprocessor Register Transfer
-    union
+        return ((S32)(instruction << 8)) >> 6;
+    }
+};
+
+//Coprocessor Data Transfer
+struct ARM_COPROCESSOR_TRANSFER : ARM_INSTRUCTION
+{
+    INSTRUCTION_FIELD(offset,         0, 8)
+    INSTRUCTION_FIELD(CPn,            8, 4)
+    INSTRUCTION_FIELD(CRd,           12, 4)
+    INSTRUCTION_FIELD(Rn,            16, 4)
+    INSTRUCTION_FIELD(L,             20, 1)
+    INSTRUCTION_FIELD(W,             21, 1)
+    INSTRUCTION_FIELD(N,             22, 1)
+    INSTRUCTION_FIELD(U,             23, 1)
+    INSTRUCTION_FIELD(P,             24, 1)
+};
+
+//Coprocessor Data Operation (bit 4 = 0) and Register Transfer (bit 4 = 1)
+struct ARM_COPROCESSOR_OPERATION : ARM_INSTRUCTION
+{
+    INSTRUCTION_FIELD(CRm,            0, 4)
+    INSTRUCTION_FIELD(CP,             5, 3)
+    INSTRUCTION_FIELD(CPn,            8, 4)
+    INSTRUCTION_FIELD(CRd,           12, 4)     //Rd of a register transfer
+    INSTRUCTION_FIELD(CRn,           16, 4)
+    INSTRUCTION_FIELD(L,             20, 1)     //register transfer
+    INSTRUCTION_FIELD(CP_opc,        20, 4)     //data operation, bit[23:21] for a register transfer
+};
+
+//Software Interrupt
+struct ARM_SWI : ARM_INSTRUCTION
+{
+    INSTRUCTION_FIELD(comment,        0, 24)
+};
+
+
+//THUMB instruction fields, the halfword in bit[15:0], data sheet chapter 5.
+//registers are 3 bit R0-R7 unless noted
+//Move Shifted Register
+struct THUMB_MOVE_SHIFTED
+{
+    INSTRUCTION_FIELD(Rd,             0, 3)
+    INSTRUCTION_FIELD(Rs,             3, 3)
+    INSTRUCTION_FIELD(offset,         6, 5)
+    INSTRUCTION_FIELD(op,            11, 2)     //LSL, LSR, ASR
+};
+
+//Add/Subtract
+struct THUMB_ADD_SUBTRACT
+{
+    INSTRUCTION_FIELD(Rd,             0, 3)
+    INSTRUCTION_FIELD(Rs,             3, 3)
+    INSTRUCTION_FIELD(Rn,             6, 3)     //I = 1 : a 3 bit immediate
+    INSTRUCTION_FIELD(op,             9, 1)     //1 : SUB
+    INSTRUCTION_FIELD(I,             10, 1)
+};
+
+//Move/Compare/Add/Subtract Immediate
+struct THUMB_IMMEDIATE
+{
+    INSTRUCTION_FIELD(offset,         0, 8)
+    INSTRUCTION_FIELD(Rd,             8, 3)
+    INSTRUCTION_FIELD(op,            11, 2)     //THUMB_IMM_*
+};
+
+//ALU Operations
+struct THUMB_ALU
+{
+    INSTRUCTION_FIELD(Rd,             0, 3)
+    INSTRUCTION_FIELD(Rs,             3, 3)
+    INSTRUCTION_FIELD(op,             6, 4)     //THUMB_ALU_*
+};
+
+//Hi Register Operations/Branch Exchange, H1 and H2 add 8 to Rd and Rs
+struct THUMB_HI_REGISTER
+{
+    INSTRUCTION_FIELD(Rd,             0, 3)
+    INSTRUCTION_FIELD(Rs,             3, 3)
+    INSTRUCTION_FIELD(H2,             6, 1)
+    INSTRUCTION_FIELD(H1,             7, 1)
+    INSTRUCTION_FIELD(op,             8, 2)     //THUMB_HI_*
+};
+
+//Load/Store with Register Offset, Load/Store Sign-Extended Byte/Halfword
+struct THUMB_REGISTER_OFFSET
+{
+    INSTRUCTION_FIELD(Rd,             0, 3)
+    INSTRUCTION_FIELD(Rb,             3, 3)
+    INSTRUCTION_FIELD(Ro,             6, 3)
+};
+
+//Load/Store with Immediate Offset, Load/Store Halfword, the offset is
+//scaled by the transfer size
+struct THUMB_IMMEDIATE_OFFSET
+{
+    INSTRUCTION_FIELD(Rd,             0, 3)
+    INSTRUCTION_FIELD(Rb,             3, 3)
+    INSTRUCTION_FIELD(offset,         6, 5)
+};
+
+//PC-Relative Load, SP-Relative Load/Store, Load Address, the offset is in words
+struct THUMB_RELATIVE
+{
+    INSTRUCTION_FIELD(word,           0, 8)
+    INSTRUCTION_FIELD(Rd,             8, 3)
+};
+
+//Add Offset to Stack Pointer
+struct THUMB_ADD_SP
+{
+    INSTRUCTION_FIELD(word,           0, 7)
+    INSTRUCTION_FIELD(S,              7, 1)     //1 : subtract
+};
+
+//Push/Pop Registers, Multiple Load/Store
+struct THUMB_MULTIPLE
+{
+    INSTRUCTION_FIELD(register_list,  0, 8)
+    INSTRUCTION_FIELD(Rb,             8, 3)
+};
+
+//Conditional Branch
+struct THUMB_CONDITIONAL_BRANCH
+{
+    INSTRUCTION_FIELD(cond,           8, 4)     //COND_*, 0xE is undefined and 0xF SWI
+
+    //the 8 bit halfword offset, sign extended and shifted into bytes
+    static constexpr S32 offset(U32 instruction)
     {
-        U32 CRm : 4;
-        U32 rsv0 : 1;
-        U32 CP : 3;
-        U32 CPn : 4;
-        U32 CPd : 4;
-        U32 CRn : 4;
-        U32 rsv1 : 1;
-        U32 CP_opc : 3;
-        U32 rsv2 : 4;
-        U32 cond : 4;
-    }cop_reg_tfr;
-
-    //PSR Transfer
-    union
+        return ((S32)(instruction << 24)) >> 23;
+    }
+};
+
+//Software Interrupt
+struct THUMB_SWI
+{
+    INSTRUCTION_FIELD(comment,        0, 8)
+};
+
+//Unconditional Branch
+struct THUMB_BRANCH
+{
+    //the 11 bit halfword offset, sign extended and shifted into bytes
+    static constexpr S32 offset(U32 instruction)
     {
-        union 
-        {
-            struct 
-            {
-                union 
-                {
-                    struct
-                    {
-                        U32 Rm : 4;    //source register
-                        U32 rsv0 : 8;
-                    };
-                    struct
-                    {
-                        U32 imm : 8;
-                        U32 rotate : 4; //chaper 4.5.3
-                    };
-                };
-            }source_operand;
-        };
-        
-        U32 Rd : 4;
-        U32 rsv1 : 6;
-        union 
-        {
-            U32 Ps : 1;    //source PSR
-            U32 Pd : 1;    //destination PSR
-        };
-        U32 rsv2 : 2;
-        U32 I : 1;
-        U32 cond : 4;
-    }psr_tsfr;
+        return ((S32)(instruction << 21)) >> 20;
+    }
+};
 
-    //Software Interrupt
-    union
+//Long Branch with Link, a pair of halfwords
+struct THUMB_LONG_BRANCH
+{
+    INSTRUCTION_FIELD(offset,         0, 11)
+    INSTRUCTION_FIELD(H,             11, 1)     //0 : the high half of the offset, 1 : the low half and the branch
+
+    //H = 0, bit[22:12] of the offset, sign extended
+    static constexpr S32 high_offset(U32 instruction)
     {
-        U32 rsv : 28;
-        U32 cond : 4;
-    }sw_int;
+        return ((S32)(instruction << 21)) >> 9;
+    }
+};
 
 
-}INSTRUCTION_FORMAT;
+
+#pragma pack(1)
 
 
 
@@ -391,6 +564,7 @@ typedef struct cartridge_rom_header
     U32 joybus_entry_point;
 }ROM_HEADER;
 
+//the packed layout, the CPU keeps it only for the SPSRs
 typedef struct program_status_register 
 {
     union
@@ -411,46 +585,750 @@ typedef struct program_status_register
     };
 }CPSR, SPSR;
 
+//NZCV kept as plain words : flag setting instructions store their result and
+//carry without touching the CPSR bitfield, the bits are worked out when a
+//condition is checked and packed into the CPSR only when the whole register
+//is read (MRS, exception entry), see GBA_EMUALTOR_ARM7TDMI::get_CPSR()
+typedef struct lazy_flags
+{
+    U32 result;       //N is bit 31
+    U32 zero;         //Z is set when zero == 0
+    U32 carry;        //C, 0 or 1
+    U32 overflow;     //V is bit 31
+}LAZY_FLAGS;
+
 #pragma pack()
 
 
 
+//the 28 bit bus is split into 16KB pages, each page of the read and the write
+//table points at the host bytes backing it. RAM pages, mirrors included, map
+//straight into raw_data and ROM pages into the game pak area, pages whose
+//contents are smaller than a page (I/O, palette, OAM) or unmapped are NULL and
+//go to the handlers
+#define MEMORY_PAGE_SHIFT       (14)
+#define MEMORY_PAGE_SIZE        (1 << MEMORY_PAGE_SHIFT)
+#define MEMORY_PAGE_COUNT       (1 << (28 - MEMORY_PAGE_SHIFT))
+
+//ROM files are mmap'd on POSIX hosts, other builds read them into an
+//allocated game pak area
+#if defined(__linux__) || defined(__APPLE__)
+#define GBA_MMAP_ROM    (1)
+#else
+#define GBA_MMAP_ROM    (0)
+#endif
+
+//fastmem : a 4GB host window with RAM, VRAM and ROM mapped at their guest
+//addresses, mirrors included, so a bus read is one host load at
+//fastmem + idx. the pages the page tables leave to the handlers (I/O,
+//palette, OAM, unmapped) are PROT_NONE, the SIGSEGV handler runs such an
+//access through the page tables and resumes after it. in the game pak
+//windows only the page holding the end of a ROM file faults : empty_cartridge
+//and the area past that page are read only zero pages, and a ROM copy moves
+//into a memfd like raw_data. it decodes the x86-64 mov forms the accessors
+//compile to, so fastmem is limited to that host. only loads use it : read<T>()
+//with a run time region, from the interpreter and the JIT's load helpers, which
+//still test fastmem on every access. writes stay on the page tables, the dirty
+//bitmap needs the raw_data address anyway. optional, see
+//MEMORY::enable_fastmem()
+#if defined(__x86_64__) && defined(__linux__) && !defined(GBA_NO_FASTMEM)
+#define GBA_FASTMEM     (1)
+#else
+#define GBA_FASTMEM     (0)
+#endif
+
+#define FASTMEM_WINDOW_SIZE     (0x100000000ULL)
+#define FASTMEM_SHARED_SIZE     (ALLOCATED_MEMORY_SIZE) //raw_data bytes moved into the memfd
+#define FASTMEM_MAX_WINDOWS     (16)                    //MEMORY instances with fastmem on at the same time
+
+//per I/O register access counters, in debug builds or with GBA_IO_STATISTICS defined
+#if defined(_DEBUG) || defined(GBA_IO_STATISTICS)
+#define GBA_IO_COUNTERS     (1)
+#else
+#define GBA_IO_COUNTERS     (0)
+#endif
+
+#define IO_HALFWORDS            (IO_REGISTER_SIZE / 2)
+
+//dirty bitmap : one bit per 256 bytes of raw_data, set by every write to WRAM, VRAM, palette and OAM. a mirror sets the bit
+//of the bytes it aliases
+#define DIRTY_SHIFT             (8)
+#define DIRTY_WORDS             (ALLOCATED_MEMORY_SIZE >> DIRTY_SHIFT >> 5)
+
+//REGION argument of MEMORY::read/write when the region is only known at run time
+#define REGION_ANY              (0xFFFFFFFF)
+
 class MEMORY 
 {
 public:
-    U8 raw_data[ALLOCATED_MEMORY_SIZE];
+    //ALLOCATED_MEMORY_SIZE bytes from allocate(), page aligned, so fastmem
+    //can map its memfd over it
+    U8 *raw_data;
+
+    //MEMORY_PAGE_COUNT entries each, one allocate() block. only the pages
+    //holding mapped entries become resident
+    U8 **read_page;
+    U8 **write_page;
+
+    //game pak ROM, empty_cartridge until the CPU maps a ROM file or its copy
+    U8 *rom;
+    int rom_file;           //descriptor of the file rom maps, -1 when it is not a file mapping
+
+    //zeros behind the game pak windows of every instance without a ROM
+    static U8 empty_cartridge[CARTRIDGE_ROM_WAIT_STATE_0_SIZE];
+
+#if GBA_FASTMEM
+    U8 *fastmem;            //the 4GB window, NULL while fastmem is off
+    int fastmem_file;       //memfd behind the first FASTMEM_SHARED_SIZE bytes of raw_data
+    int fastmem_rom_file;   //memfd behind a ROM that is not a file mapping, -1 otherwise
+    U8 *fastmem_rom;        //the ROM fastmem_rom_file holds
+
+    //set while the fault handler runs an access through the page tables.
+    //default_read records an unknown idx then instead of printing it, printf is
+    //not async-signal-safe. report_unknown() prints it from the emulation thread
+    bool         fastmem_faulting;
+    volatile U32 fastmem_unknown;       //unknown reads recorded since the last report
+    volatile U32 fastmem_unknown_idx;   //the latest of them
+#endif
+
+    //bit (offset >> DIRTY_SHIFT) of the raw_data offset written. consumers
+    //(save states, tile caches, ...) query and clear it, see dirty_offset()
+    U32 dirty[DIRTY_WORDS];
+
+    //the granules holding cached code, same layout as dirty. a write there
+    //calls write_hook, the CPU sets and clears the bits with mark_code() and
+    //unmark_code()
+    U32 code[DIRTY_WORDS];
+
+    //the granules a store has to look at, ~dirty | code. the only bitmap
+    //written() reads, so the dirty bit costs nothing once a granule is dirty
+    U32 watched[DIRTY_WORDS];
+
+    //extra cycles of a non sequential access per 16MB area, [bit 27:24][0 : 8/16 bit, 1 : 32 bit].
+    //a 32 bit access to a 16 bit bus is a non sequential and a sequential halfword
+    U8 wait_states[16][2];
+
+    //I/O registers dispatch per halfword. a NULL handler reads or writes
+    //the value stored in raw_data, so registers without side effects need no
+    //entry. offset is the halfword's offset from IO_REGISTER_BASE_LOG, a write
+    //handler gets the bytes written in mask (0x00FF, 0xFF00 or 0xFFFF)
+    typedef U16  (*IO_READ_HANDLER)(void *context, MEMORY *memory, U32 offset);
+    typedef void (*IO_WRITE_HANDLER)(void *context, MEMORY *memory, U32 offset, U16 value, U16 mask);
+    typedef struct io_register
+    {
+        IO_READ_HANDLER  read;
+        IO_WRITE_HANDLER write;
+        void            *context;
+#if GBA_IO_COUNTERS
+        U32              reads;
+        U32              writes;
+#endif
+    }IO_REGISTER;
+    IO_REGISTER io[IO_HALFWORDS];
+
+    //accesses to a NULL page outside of the I/O registers
+    typedef U8   (*READ_HANDLER)(void *context, U32 idx);
+    typedef void (*WRITE_HANDLER)(void *context, U32 idx, U8 value);
+    READ_HANDLER  read_handler;
+    WRITE_HANDLER write_handler;
+    void         *handler_context;
+
+    //bus accesses of sizeof(T) bytes, the address is aligned down to the
+    //access size like the ARM7TDMI does. the host is little endian like the
+    //GBA, so 16 and 32 bit accesses to a mapped page are one host load/store.
+    //REGION is the *_BASE_LOG of the region when the caller knows it at
+    //compile time, the access then skips the page table
+    template<typename T, U32 REGION = REGION_ANY>
+    T read(U32 idx)
+    {
+        idx &= ~(U32)(sizeof(T) - 1);
+
+        if constexpr (REGION == REGION_ANY)
+        {
+#if GBA_FASTMEM
+            //volatile keeps it a plain load the fault handler can decode
+            if (this->fastmem)
+            {
+                return *(volatile T*)&this->fastmem[idx];
+            }
+#endif
+            return read_paged<T>(idx);
+        }
+        else if constexpr (region_mapped(REGION))
+        {
+            return *(T*)region_host(REGION, idx);
+        }
+        else
+        {
+            return read_slow<T>(idx);
+        }
+    }
+
+    template<typename T, U32 REGION = REGION_ANY>
+    void write(U32 idx, T value)
+    {
+        idx &= ~(U32)(sizeof(T) - 1);
+
+        if constexpr (REGION == REGION_ANY)
+        {
+            write_paged<T>(idx, value);
+        }
+        else if constexpr (region_writable(REGION))
+        {
+            U8 *host = region_host(REGION, idx);
+
+            *(T*)host = value;
+            written(host, idx, sizeof(T));
+        }
+        else
+        {
+            write_slow<T>(idx, value);
+        }
+    }
+
+    //the page table side of read() and write() for an aligned idx, also what
+    //a faulting fastmem access is emulated with
+    template<typename T>
+    T read_paged(U32 idx)
+    {
+        U8 *page = this->read_page[(idx >> MEMORY_PAGE_SHIFT) & (MEMORY_PAGE_COUNT - 1)];
+
+        if (page)
+        {
+            return *(T*)&page[idx & (MEMORY_PAGE_SIZE - 1)];
+        }
+        return read_slow<T>(idx);
+    }
+
+    template<typename T>
+    void write_paged(U32 idx, T value)
+    {
+        U8 *page = this->write_page[(idx >> MEMORY_PAGE_SHIFT) & (MEMORY_PAGE_COUNT - 1)];
+
+        if (page == NULL)
+        {
+            write_slow<T>(idx, value);
+            return;
+        }
+        *(T*)&page[idx & (MEMORY_PAGE_SIZE - 1)] = value;
+        written(&page[idx & (MEMORY_PAGE_SIZE - 1)], idx, sizeof(T));
+    }
+
     U8 operator[](U32 idx) 
     {
-        //translate index
+        return read<U8>(idx);
+    }
+
+    //host is inside the tracked part of raw_data. an aligned access of up to
+    //4 bytes never crosses a 256 byte granule
+    void mark_dirty(const U8 *host)
+    {
+        U32 granule = (U32)(host - this->raw_data) >> DIRTY_SHIFT;
+        U32 bit = 1u << (granule & 31);
+
+        this->dirty[granule >> 5] |= bit;
+        this->watched[granule >> 5] &= ~bit | this->code[granule >> 5];
+    }
+
+    //after a store of size bytes to idx at host : one load and one branch,
+    //only the first store to a clean granule and stores to cached code go on
+    void written(const U8 *host, U32 idx, U32 size)
+    {
+        U32 granule = (U32)(host - this->raw_data) >> DIRTY_SHIFT;
+
+        if (this->watched[granule >> 5] & (1u << (granule & 31)))
+        {
+            written_watched(granule, idx, size);
+        }
+    }
+
+    //the dirty bit, and the write hook when the granule holds cached code.
+    //a granule without code stops being watched until its bit is cleared
+    void written_watched(U32 granule, U32 idx, U32 size)
+    {
+        U32 bit = 1u << (granule & 31);
+
+        this->dirty[granule >> 5] |= bit;
+        if (this->code[granule >> 5] & bit)
+        {
+            if (this->write_hook)
+            {
+                this->write_hook(this->write_hook_context, idx, size);
+            }
+        }
+        else
+        {
+            this->watched[granule >> 5] &= ~bit;
+        }
+    }
+
+    //granule is a raw_data offset >> DIRTY_SHIFT
+    void mark_code(U32 granule)
+    {
+        this->code[granule >> 5] |= 1u << (granule & 31);
+        this->watched[granule >> 5] |= 1u << (granule & 31);
+    }
+
+    void unmark_code(U32 granule)
+    {
+        U32 bit = 1u << (granule & 31);
+
+        this->code[granule >> 5] &= ~bit;
+        this->watched[granule >> 5] &= ~bit | ~this->dirty[granule >> 5];
+    }
+
+    //raw_data offset of a guest address in WRAM, VRAM, palette or OAM, -1 for
+    //the untracked regions
+    S32 dirty_offset(U32 idx)
+    {
         switch (idx & 0x0F000000)
         {
-            case BIOS_BASE_LOG:
-                return raw_data[idx & 0x00FFFFFF + BIOS_BASE_PHY];
-                break;
             case ON_BOARD_WRAM_BASE_LOG:
-                return raw_data[idx & 0x00FFFFFF + ON_BOARD_WRAM_BASE_PHY];
-                break;
             case ON_CHIP_WRAM_BASE_LOG:
-                return raw_data[idx & 0x00FFFFFF + ON_CHIP_WRAM_BASE_PHY];
-                break;
-            case IO_REGISTER_BASE_LOG:
-                return raw_data[idx & 0x00FFFFFF + IO_REGISTER_BASE_PHY];
-                break;
+            case VIDEO_RAM_BASE_LOG:
+                return (S32)(this->write_page[(idx >> MEMORY_PAGE_SHIFT) & (MEMORY_PAGE_COUNT - 1)] + (idx & (MEMORY_PAGE_SIZE - 1)) - this->raw_data);
             case PALETTE_RAM_BASE_LOG:
-                return raw_data[idx & 0x00FFFFFF + PALETTE_RAM_BASE_PHY];
-                break;
+                return PALETTE_RAM_BASE_PHY + (idx & (PALETTE_RAM_SIZE - 1));
+            case OBJ_ATTR_RAM_BASE_LOG:
+                return OBJ_ATTR_RAM_BASE_PHY + (idx & (OBJ_ATTR_RAM_SIZE - 1));
+            default:
+                return -1;
+        }
+    }
+
+    //any granule of size bytes at idx written since it was last cleared. the
+    //range stays inside one region
+    bool is_dirty(U32 idx, U32 size = 1)
+    {
+        S32 offset = dirty_offset(idx);
+
+        if (offset < 0 || size == 0)
+        {
+            return false;
+        }
+        for (U32 granule = (U32)offset >> DIRTY_SHIFT; granule <= ((U32)offset + size - 1) >> DIRTY_SHIFT; granule++)
+        {
+            if (this->dirty[granule >> 5] & (1u << (granule & 31)))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void clear_dirty(U32 idx, U32 size = 1)
+    {
+        S32 offset = dirty_offset(idx);
+
+        if (offset < 0 || size == 0)
+        {
+            return;
+        }
+        for (U32 granule = (U32)offset >> DIRTY_SHIFT; granule <= ((U32)offset + size - 1) >> DIRTY_SHIFT; granule++)
+        {
+            this->dirty[granule >> 5] &= ~(1u << (granule & 31));
+            this->watched[granule >> 5] |= 1u << (granule & 31);
+        }
+    }
+
+    void clear_all_dirty()
+    {
+        for (U32 i = 0; i < DIRTY_WORDS; i++)
+        {
+            this->dirty[i] = 0;
+            this->watched[i] = 0xFFFFFFFF;
+        }
+    }
+
+    //regions whose pages are all backed by host memory : raw_data, and the ROM
+    //or empty_cartridge for the game pak windows
+    static constexpr bool region_mapped(U32 region)
+    {
+        return region == BIOS_BASE_LOG || region_writable(region) || region == CARTRIDGE_ROM_WAIT_STATE_0_BASE_LOG ||
+               region == CARTRIDGE_ROM_WAIT_STATE_1_BASE_LOG || region == CARTRIDGE_ROM_WAIT_STATE_2_BASE_LOG;
+    }
+
+    static constexpr bool region_writable(U32 region)
+    {
+        return region == ON_BOARD_WRAM_BASE_LOG || region == ON_CHIP_WRAM_BASE_LOG || region == VIDEO_RAM_BASE_LOG;
+    }
+
+    //host address of idx inside a mapped region, with the mirrors map() sets up
+    U8 *region_host(U32 region, U32 idx)
+    {
+        switch (region)
+        {
+            case BIOS_BASE_LOG:
+                return &this->raw_data[BIOS_BASE_PHY + (idx & (BIOS_SIZE - 1))];
+            case ON_BOARD_WRAM_BASE_LOG:
+                return &this->raw_data[ON_BOARD_WRAM_BASE_PHY + (idx & (ON_BOARD_WRAM_SIZE - 1))];
+            case ON_CHIP_WRAM_BASE_LOG:
+                return &this->raw_data[ON_CHIP_WRAM_BASE_PHY + (idx & (ON_CHIP_WRAM_SIZE - 1))];
             case VIDEO_RAM_BASE_LOG:
-                return raw_data[idx & 0x00FFFFFF + VIDEO_RAM_BASE_PHY];
-                break;
+                idx &= 0x0001FFFF;
+                return &this->raw_data[VIDEO_RAM_BASE_PHY + ((idx < VIDEO_RAM_SIZE) ? idx : idx - 0x8000)];
+            default:
+                return &this->rom[idx & (CARTRIDGE_ROM_WAIT_STATE_0_SIZE - 1)];
+        }
+    }
+
+    //handler accesses, one byte at a time, low byte first. I/O registers go
+    //through the dispatch table one halfword at a time
+    template<typename T>
+    T read_slow(U32 idx)
+    {
+        T value = 0;
+
+        if ((idx & 0x0F000000) == IO_REGISTER_BASE_LOG)
+        {
+            return io_read<T>(idx & (IO_REGISTER_SIZE - 1));
+        }
+        for (U32 i = 0; i < sizeof(T); i++)
+        {
+            value |= (T)this->read_handler(this->handler_context, idx + i) << (i * 8);
+        }
+        return value;
+    }
+
+    template<typename T>
+    void write_slow(U32 idx, T value)
+    {
+        if ((idx & 0x0F000000) == IO_REGISTER_BASE_LOG)
+        {
+            io_write<T>(idx & (IO_REGISTER_SIZE - 1), value);
+            return;
+        }
+        for (U32 i = 0; i < sizeof(T); i++)
+        {
+            this->write_handler(this->handler_context, idx + i, (U8)(value >> (i * 8)));
+        }
+    }
+
+    //I/O access of sizeof(T) bytes at an aligned offset
+    template<typename T>
+    T io_read(U32 offset)
+    {
+        if constexpr (sizeof(T) == 4)
+        {
+            return io_read16(offset) | ((U32)io_read16(offset + 2) << 16);
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            return io_read16(offset);
+        }
+        else
+        {
+            return (T)(io_read16(offset & ~1) >> ((offset & 1) * 8));
+        }
+    }
+
+    template<typename T>
+    void io_write(U32 offset, T value)
+    {
+        if constexpr (sizeof(T) == 4)
+        {
+            io_write16(offset, (U16)value, 0xFFFF);
+            io_write16(offset + 2, (U16)(value >> 16), 0xFFFF);
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            io_write16(offset, value, 0xFFFF);
+        }
+        else
+        {
+            io_write16(offset & ~1, (U16)(value << ((offset & 1) * 8)), (U16)(0xFF << ((offset & 1) * 8)));
+        }
+    }
+
+    U16 io_read16(U32 offset)
+    {
+        IO_REGISTER *reg = &this->io[offset >> 1];
+
+#if GBA_IO_COUNTERS
+        reg->reads++;
+#endif
+        if (reg->read)
+        {
+            return reg->read(reg->context, this, offset);
+        }
+        return io_value(offset);
+    }
+
+    void io_write16(U32 offset, U16 value, U16 mask)
+    {
+        IO_REGISTER *reg = &this->io[offset >> 1];
+
+#if GBA_IO_COUNTERS
+        reg->writes++;
+#endif
+        if (reg->write)
+        {
+            reg->write(reg->context, this, offset, value, mask);
+            return;
+        }
+        io_value(offset) = (io_value(offset) & ~mask) | (value & mask);
+    }
+
+    //the stored halfword, what the hardware side updates (VCOUNT, KEYINPUT)
+    //and handlers keep their state in
+    U16 &io_value(U32 offset)
+    {
+        return *(U16*)&this->raw_data[IO_REGISTER_BASE_PHY + (offset & (IO_REGISTER_SIZE - 2))];
+    }
+
+    //install the handlers of the halfword at offset, NULL for the stored value
+    void set_io_handler(U32 offset, IO_READ_HANDLER read, IO_WRITE_HANDLER write, void *context)
+    {
+        IO_REGISTER *reg = &this->io[(offset & (IO_REGISTER_SIZE - 1)) >> 1];
+
+        reg->read = read;
+        reg->write = write;
+        reg->context = context;
+    }
+
+    //read only registers, and the read only bits of the others
+    static void io_write_ignored(void *, MEMORY *, U32, U16, U16)
+    {
+    }
+
+    static void io_write_dispstat(void *, MEMORY *memory, U32 offset, U16 value, U16 mask)
+    {
+        mask &= ~0x0007;
+        memory->io_value(offset) = (memory->io_value(offset) & ~mask) | (value & mask);
+    }
+
+    static void io_write_if(void *, MEMORY *memory, U32 offset, U16 value, U16 mask)
+    {
+        memory->io_value(offset) &= ~(value & mask);
+    }
+
+    //called after a write into a granule whose code bit is set, so the CPU
+    //can drop what it cached from there
+    typedef void (*WRITE_HOOK)(void *context, U32 idx, U32 size);
+    WRITE_HOOK write_hook;
+    void      *write_hook_context;
+
+    //the page tables start out all NULL, allocate() fills with zeros
+    MEMORY()
+    {
+        this->raw_data = allocate(ALLOCATED_MEMORY_SIZE);
+        this->read_page = (U8**)allocate(2 * MEMORY_PAGE_COUNT * sizeof(U8*));
+        this->write_page = this->read_page + MEMORY_PAGE_COUNT;
+        this->rom_file = -1;
+#if GBA_FASTMEM
+        this->fastmem = NULL;
+        this->fastmem_file = -1;
+        this->fastmem_rom_file = -1;
+        this->fastmem_rom = NULL;
+        this->fastmem_faulting = false;
+        this->fastmem_unknown = 0;
+        this->fastmem_unknown_idx = 0;
+#endif
+
+        //WRAM is mirrored over its whole 16MB area
+        map(BIOS_BASE_LOG,          &this->raw_data[BIOS_BASE_PHY],          BIOS_SIZE,          BIOS_SIZE,  false);
+        map(ON_BOARD_WRAM_BASE_LOG, &this->raw_data[ON_BOARD_WRAM_BASE_PHY], ON_BOARD_WRAM_SIZE, 0x01000000, true);
+        map(ON_CHIP_WRAM_BASE_LOG,  &this->raw_data[ON_CHIP_WRAM_BASE_PHY],  ON_CHIP_WRAM_SIZE,  0x01000000, true);
+        map_rom(empty_cartridge);
+
+        //128KB VRAM windows, 0x18000-0x1FFFF mirrors 0x10000-0x17FFF
+        for (U32 window = VIDEO_RAM_BASE_LOG; window < OBJ_ATTR_RAM_BASE_LOG; window += 0x00020000)
+        {
+            map(window,           &this->raw_data[VIDEO_RAM_BASE_PHY],           VIDEO_RAM_SIZE, VIDEO_RAM_SIZE, true);
+            map(window + 0x18000, &this->raw_data[VIDEO_RAM_BASE_PHY + 0x10000], 0x8000,         0x8000,         true);
+        }
+
+        //WAITCNT at reset : game pak N 4 cycles, S 2/4/8 cycles for wait state 0/1/2, SRAM 4 cycles
+        for (U32 i = 0; i < 16; i++)
+        {
+            this->wait_states[i][0] = 0;
+            this->wait_states[i][1] = 0;
+        }
+        set_wait_states(ON_BOARD_WRAM_BASE_LOG,              0x01000000, 2, 5);
+        set_wait_states(PALETTE_RAM_BASE_LOG,                0x01000000, 0, 1);
+        set_wait_states(VIDEO_RAM_BASE_LOG,                  0x01000000, 0, 1);
+        set_wait_states(CARTRIDGE_ROM_WAIT_STATE_0_BASE_LOG, 0x02000000, 4, 4 + 1 + 2);
+        set_wait_states(CARTRIDGE_ROM_WAIT_STATE_1_BASE_LOG, 0x02000000, 4, 4 + 1 + 4);
+        set_wait_states(CARTRIDGE_ROM_WAIT_STATE_2_BASE_LOG, 0x02000000, 4, 4 + 1 + 8);
+        set_wait_states(0x0E000000,                          0x02000000, 4, 4);
+
+        for (U32 i = 0; i < IO_HALFWORDS; i++)
+        {
+            this->io[i].read = NULL;
+            this->io[i].write = NULL;
+            this->io[i].context = NULL;
+#if GBA_IO_COUNTERS
+            this->io[i].reads = 0;
+            this->io[i].writes = 0;
+#endif
+        }
+        set_io_handler(IO_DISPSTAT, NULL, io_write_dispstat, NULL);
+        set_io_handler(IO_VCOUNT,   NULL, io_write_ignored,  NULL);
+        set_io_handler(IO_KEYINPUT, NULL, io_write_ignored,  NULL);
+        set_io_handler(IO_IF,       NULL, io_write_if,       NULL);
+        io_value(IO_KEYINPUT) = 0x03FF;
+        clear_all_dirty();
+        for (U32 i = 0; i < DIRTY_WORDS; i++)
+        {
+            this->code[i] = 0;
+        }
+
+        this->read_handler = default_read;
+        this->write_handler = default_write;
+        this->handler_context = this;
+        this->write_hook = NULL;
+        this->write_hook_context = NULL;
+    }
+
+    ~MEMORY()
+    {
+        disable_fastmem();
+        release((U8*)this->read_page, 2 * MEMORY_PAGE_COUNT * sizeof(U8*));
+        release(this->raw_data, ALLOCATED_MEMORY_SIZE);
+    }
+
+    //owns its allocations
+    MEMORY(const MEMORY&) = delete;
+    MEMORY &operator=(const MEMORY&) = delete;
+
+    //size zero filled bytes on fresh pages, which only become resident when
+    //touched. NULL when the host is out of memory
+    static U8 *allocate(U32 size);
+    static void release(U8 *data, U32 size);
+
+    //map the fastmem window and route read() through it. false when
+    //the host or the build has no fastmem, or setting it up failed
+    bool enable_fastmem();
+    void disable_fastmem();
+
+    //remap the window pages of span bytes at base_log from the page tables
+    void fastmem_map(U32 base_log, U32 span);
+
+    //move a ROM copy into fastmem_rom_file, so the window can map it
+    void fastmem_share_rom();
+
+    //point the pages of span bytes at base_log to the size bytes at host,
+    //repeated. size and span are multiples of MEMORY_PAGE_SIZE
+    void map(U32 base_log, U8 *host, U32 size, U32 span, bool writable)
+    {
+        for (U32 offset = 0; offset < span; offset += MEMORY_PAGE_SIZE)
+        {
+            this->read_page[(base_log + offset) >> MEMORY_PAGE_SHIFT] = host + offset % size;
+            this->write_page[(base_log + offset) >> MEMORY_PAGE_SHIFT] = writable ? host + offset % size : NULL;
+        }
+#if GBA_FASTMEM
+        if (this->fastmem)
+        {
+            fastmem_map(base_log, span);
+        }
+#endif
+    }
+
+    //hand span bytes at base_log to the handlers, span is a multiple of MEMORY_PAGE_SIZE
+    void unmap(U32 base_log, U32 span)
+    {
+        for (U32 offset = 0; offset < span; offset += MEMORY_PAGE_SIZE)
+        {
+            this->read_page[(base_log + offset) >> MEMORY_PAGE_SHIFT] = NULL;
+            this->write_page[(base_log + offset) >> MEMORY_PAGE_SHIFT] = NULL;
+        }
+#if GBA_FASTMEM
+        if (this->fastmem)
+        {
+            fastmem_map(base_log, span);
+        }
+#endif
+    }
+
+    //the game pak ROM, CARTRIDGE_ROM_WAIT_STATE_0_SIZE readable bytes at rom,
+    //behind all three wait state windows. file is the descriptor rom maps,
+    //left open by the caller while the ROM is mapped. without a file, rom is
+    //empty_cartridge or comes from allocate(), fastmem maps a memfd over it
+    void map_rom(U8 *rom, int file = -1)
+    {
+        this->rom = rom;
+        this->rom_file = file;
+#if GBA_FASTMEM
+        if (this->fastmem)
+        {
+            fastmem_share_rom();
+        }
+#endif
+        map(CARTRIDGE_ROM_WAIT_STATE_0_BASE_LOG, rom, CARTRIDGE_ROM_WAIT_STATE_0_SIZE, CARTRIDGE_ROM_WAIT_STATE_0_SIZE, false);
+        map(CARTRIDGE_ROM_WAIT_STATE_1_BASE_LOG, rom, CARTRIDGE_ROM_WAIT_STATE_0_SIZE, CARTRIDGE_ROM_WAIT_STATE_0_SIZE, false);
+        map(CARTRIDGE_ROM_WAIT_STATE_2_BASE_LOG, rom, CARTRIDGE_ROM_WAIT_STATE_0_SIZE, CARTRIDGE_ROM_WAIT_STATE_0_SIZE, false);
+    }
+
+    //span covers whole 16MB areas
+    void set_wait_states(U32 base_log, U32 span, U8 halfword, U8 word)
+    {
+        for (U32 area = base_log >> 24; area < (base_log + span) >> 24; area++)
+        {
+            this->wait_states[area][0] = halfword;
+            this->wait_states[area][1] = word;
+        }
+    }
+
+    //wait states of a data access to idx, the game pak windows differ only here
+    template<typename T>
+    U32 waits(U32 idx)
+    {
+        return this->wait_states[(idx >> 24) & 0xF][sizeof(T) == 4];
+    }
+
+    //palette and OAM, which mirror every 1KB, and the unmapped areas
+    static U8 default_read(void *context, U32 idx)
+    {
+        MEMORY *memory = (MEMORY*)context;
+
+        switch (idx & 0x0F000000)
+        {
+            case PALETTE_RAM_BASE_LOG:
+                return memory->raw_data[(idx & (PALETTE_RAM_SIZE - 1)) + PALETTE_RAM_BASE_PHY];
             case OBJ_ATTR_RAM_BASE_LOG:
-                return raw_data[idx & 0x00FFFFFF + OBJ_ATTR_RAM_BASE_PHY];
-                break;
-            case CARTRIDGE_ROM_WAIT_STATE_0_BASE_LOG:
-                return raw_data[idx & 0x00FFFFFF + CARTRIDGE_ROM_WAIT_STATE_0_BASE_PHY];
-                break;
+                return memory->raw_data[(idx & (OBJ_ATTR_RAM_SIZE - 1)) + OBJ_ATTR_RAM_BASE_PHY];
             default:
+#if GBA_FASTMEM
+                if (memory->fastmem_faulting)
+                {
+                    memory->fastmem_unknown_idx = idx;
+                    memory->fastmem_unknown = memory->fastmem_unknown + 1;
+                    return 0x00;
+                }
+#endif
                 printf("unknown idx : %08X\n", idx);
                 return 0x00;
+        }
+    }
+
+    //what default_read recorded during fastmem faults, called after each run()
+    void report_unknown()
+    {
+#if GBA_FASTMEM
+        if (this->fastmem_unknown)
+        {
+            printf("unknown idx : %08X (%u reads in fastmem faults)\n", this->fastmem_unknown_idx, this->fastmem_unknown);
+            this->fastmem_unknown = 0;
+        }
+#endif
+    }
+
+    //BIOS and game pak ROM are read only
+    static void default_write(void *context, U32 idx, U8 value)
+    {
+        MEMORY *memory = (MEMORY*)context;
+
+        switch (idx & 0x0F000000)
+        {
+            case PALETTE_RAM_BASE_LOG:
+                memory->raw_data[(idx & (PALETTE_RAM_SIZE - 1)) + PALETTE_RAM_BASE_PHY] = value;
+                memory->mark_dirty(&memory->raw_data[(idx & (PALETTE_RAM_SIZE - 1)) + PALETTE_RAM_BASE_PHY]);
+                break;
+            case OBJ_ATTR_RAM_BASE_LOG:
+                memory->raw_data[(idx & (OBJ_ATTR_RAM_SIZE - 1)) + OBJ_ATTR_RAM_BASE_PHY] = value;
+                memory->mark_dirty(&memory->raw_data[(idx & (OBJ_ATTR_RAM_SIZE - 1)) + OBJ_ATTR_RAM_BASE_PHY]);
+                break;
+            default:
                 break;
         }
     }
@@ -461,42 +1339,219 @@ public:
 class GBA_EMUALTOR_ARM7TDMI
 {
 public:
+    //one handler per bit[27:20] and bit[7:4] combination
+    typedef void (GBA_EMUALTOR_ARM7TDMI::*ARM_HANDLER)(INSTRUCTION_FORMAT*);
+    typedef struct arm_handler_table
+    {
+        ARM_HANDLER handler[4096];
+    }ARM_HANDLER_TABLE;
+
+    //one handler per bit[15:6] of a THUMB halfword, which holds the format and
+    //its opcode bits. the halfword is passed by value, THUMB code is not cached
+    typedef void (GBA_EMUALTOR_ARM7TDMI::*THUMB_HANDLER)(U32);
+    typedef struct thumb_handler_table
+    {
+        THUMB_HANDLER handler[1024];
+    }THUMB_HANDLER_TABLE;
+
+    //an instruction decoded once and executed from the block cache, the
+    //handler still extracts its operands from the instruction word
+    typedef struct block_instruction
+    {
+        ARM_HANDLER        handler;
+        INSTRUCTION_FORMAT instruction;
+        U32                cycles;
+        U32                dispatch;    //DISPATCH_*
+        void              *label;       //run_threaded() label for dispatch
+    }BLOCK_INSTRUCTION;
+
+    //straight line run of instructions ending at the first branch, followed
+    //by a DISPATCH_END entry
+    typedef struct block
+    {
+        U32 pc;             //guest address of the first instruction, BLOCK_INVALID when empty
+        U32 length;
+        U32 threaded;       //labels filled in by run_threaded()
+        void *code;         //compiled by GBA_EMUALTOR_ARM7TDMI_JIT, NULL until then
+        U32 hotness;        //interpreted executions since the block was decoded
+        U32 generation;     //bumped by every decode, tells a stale compile apart
+        U32 code_offset;    //raw_data offset of a WRAM block, BLOCK_UNTRACKED for the others
+        BLOCK_INSTRUCTION instructions[BLOCK_MAX_INSTRUCTIONS + 1];
+    }BLOCK;
+
+    //blocks is one MEMORY::allocate() block, all zero is an empty block
+    //everywhere but in slot 0, where it would be a block at PC 0. slots stay
+    //unallocated until a PC maps to them
+    typedef struct block_cache
+    {
+        BLOCK *blocks;
+        U32 hits;
+        U32 misses;
+        U32 invalidations;  //blocks dropped by a write to their code
+        U32 code_writes;    //writes into a granule holding cached code
+    }BLOCK_CACHE;
+
     //CPU part
+    //hot : everything the dispatch loops and compiled blocks touch per
+    //instruction, in the first two cache lines of the object, so the JIT
+    //reaches all of it with an 8 bit displacement
     //ARM state general register and program counter
     //R13 : SP
     //R14 : LR
     //R15 : PC
-    //system and user mode
-    U32 R[NUM_OF_REGISTER];
-    U32 R08_fiq, R09_fiq, R10_fiq, R11_fiq, R12_fiq, R13_fiq, R14_fiq;
-    U32 R13_svc, R14_svc;
-    U32 R13_abt, R14_abt;
-    U32 R13_irq, R14_irq;
-    U32 R13_und, R14_und;
-
-    //ARM state program status registers
-    CPSR CPSR_usr;
-    SPSR SPSR_fiq;
-    SPSR SPSR_svc;
-    SPSR SPSR_abt;
-    SPSR SPSR_irq;
-    SPSR SPSR_und;
+    //the registers of the current mode
+    alignas(64) U32 R[NUM_OF_REGISTER];
+
+    //NZCV of the CPSR
+    LAZY_FLAGS flags;
 
+    //elapsed cpu cycles
+    U32 cycles;
+
+    //the rest of the CPSR, one byte per field. get_CPSR() packs the whole
+    //register for MRS and exception entry, set_CPSR() unpacks one
     U8 mode;
+    U8 bank;            //BANK_* of mode
+    U8 thumb;           //T
+    U8 irq_disable;     //I
+    U8 fiq_disable;     //F
+
+    BLOCK_CACHE block_cache;
+
+    //starts a cache line, the page tables are the first thing in it
+    alignas(64) MEMORY memory;
+
+    //cold : banked state only mode switches and exceptions touch.
+    //R13/R14 of every bank, the current bank's entry is stale while they are
+    //in R. R8-R12 of FIQ mode while another mode runs, of the others while
+    //FIQ mode runs. see switch_mode()
+    U32 banked_R13_R14[BANK_COUNT][2];
+    U32 banked_R8_R12[5];
+
+    //ARM state saved program status registers, packed, one per bank. user and
+    //system mode have none, their entry only takes MSR/MRS of an SPSR there
+    SPSR SPSR_bank[BANK_COUNT];
+
+    //the game pak area readROM() mapped or allocated, NULL while no ROM is loaded
+    U8 *rom_mapping;
+    int rom_file;           //the file behind rom_mapping, kept open for fastmem
+
+    //WRAM blocks per granule of MEMORY::code, the bit is set while nonzero
+    U16 granule_blocks[DIRTY_WORDS * 32];
+
+    //called before a block with compiled code is invalidated or decoded over,
+    //so the JIT can unlink it
+    typedef void (*BLOCK_DROP_HOOK)(void *context, BLOCK *block);
+    BLOCK_DROP_HOOK block_drop_hook;
+    void           *block_drop_context;
+
+    GBA_EMUALTOR_ARM7TDMI();
+
+    ~GBA_EMUALTOR_ARM7TDMI();
+
+    GBA_EMUALTOR_ARM7TDMI(const GBA_EMUALTOR_ARM7TDMI&) = delete;
+    GBA_EMUALTOR_ARM7TDMI &operator=(const GBA_EMUALTOR_ARM7TDMI&) = delete;
+
+    //map the ROM file read only over the game pak area, or copy it into an
+    //allocated one where mmap is not available. false when it can not be loaded
+    bool readROM(std::string filename);
+
+    //execute instructions until cycle_budget cycles have elapsed. each loop
+    //runs one state and returns when a branch leaves it, so the T bit is only
+    //looked at after a block (ARM) or a branch (THUMB)
+    void run(U32 cycle_budget)
+    {
+        U32 target_cycles = this->cycles + cycle_budget;
+
+        while ((S32)(target_cycles - this->cycles) > 0)
+        {
+            if (this->thumb)
+            {
+                run_thumb(target_cycles - this->cycles);
+            }
+            else
+            {
+#if GBA_THREADED_DISPATCH
+                run_threaded(target_cycles - this->cycles);
+#else
+                run_loop(target_cycles - this->cycles);
+#endif
+            }
+        }
+        this->memory.report_unknown();
+    }
 
-    MEMORY   memory;
-    void readROM(std::string filename) 
+    void run_loop(U32 cycle_budget);
+    void execute_block(BLOCK *block);
+#if GBA_THREADED_DISPATCH
+    void run_threaded(U32 cycle_budget);
+#endif
+    void run_thumb(U32 cycle_budget);
+
+    //--------------------//
+    //-- decode/execute --//
+    //--------------------//
+    static const ARM_HANDLER_TABLE arm_handler_table;
+    static const THUMB_HANDLER_TABLE thumb_handler_table;
+    bool check_condition(U32 cond);
+
+    //-----------------//
+    //-- block cache --//
+    //-----------------//
+    BLOCK *get_block(U32 pc);
+    void decode_block(BLOCK *block, U32 pc);
+    void invalidate_blocks(U32 address, U32 size);
+    void flush_block_cache();
+    void drop_block_code(BLOCK *block);
+    void track_block(BLOCK *block);
+    void untrack_block(BLOCK *block);
+    static void memory_write_hook(void *context, U32 address, U32 size);
+
+    //----------------//
+    //-- lazy flags --//
+    //----------------//
+    U32 flag_N() { return this->flags.result >> 31; }
+    U32 flag_Z() { return this->flags.zero == 0; }
+    U32 flag_C() { return this->flags.carry; }
+    U32 flag_V() { return this->flags.overflow >> 31; }
+
+    //NZCV as bit[3:0], the same order as CPSR bit[31:28]
+    U32 flag_NZCV()
     {
-        std::ifstream fin;
-        fin.open(filename.c_str(), std::ios::binary | std::ios::in);
-        fin.read((char*)&memory.raw_data[CARTRIDGE_ROM_WAIT_STATE_0_BASE_PHY], CARTRIDGE_ROM_WAIT_STATE_0_SIZE);
-        fin.close();
+        return ((this->flags.result >> 31) << 3) | ((this->flags.zero == 0) << 2) | (this->flags.carry << 1) | (this->flags.overflow >> 31);
     }
-    void run() 
+
+    //N Z from result, V unchanged
+    void set_flags_logic(U32 result, U32 carry)
     {
-		U32 pc = R[15];
-        U8  bit_27_20 = memory[pc] & 0x0FF00000;
+        this->flags.result = result;
+        this->flags.zero   = result;
+        this->flags.carry  = carry;
     }
+
+    //result = operand1 + operand2 + carry
+    void set_flags_add(U32 operand1, U32 operand2, U32 carry, U32 result)
+    {
+        this->flags.result   = result;
+        this->flags.zero     = result;
+        this->flags.carry    = carry ? (result <= operand1) : (result < operand1);
+        this->flags.overflow = ~(operand1 ^ operand2) & (operand1 ^ result);
+    }
+
+    //result = operand1 - operand2 - !carry
+    void set_flags_sub(U32 operand1, U32 operand2, U32 carry, U32 result)
+    {
+        this->flags.result   = result;
+        this->flags.zero     = result;
+        this->flags.carry    = carry ? (operand1 >= operand2) : (operand1 > operand2);
+        this->flags.overflow = (operand1 ^ operand2) & (operand1 ^ result);
+    }
+
+    //the whole CPSR, packed from flags and the unpacked fields
+    U32 get_CPSR();
+    //unpack a whole CPSR, switches the register bank when the mode changes.
+    //the reserved bits are not kept
+    void set_CPSR(U32 value);
 	
 	
 
@@ -504,550 +1559,52 @@ public:
     //----------------------//
     //-- opcode functions --//
     //----------------------//	
-    U32 get_shifted_operand2(INSTRUCTION_FORMAT *);
-    U32 get_rotated_operand2(INSTRUCTION_FORMAT *);
-    void update_CPSR_flags(INSTRUCTION_FORMAT *, U32);
-    void AND(INSTRUCTION_FORMAT*);
-    void EOR(INSTRUCTION_FORMAT*);
-    void SUB(INSTRUCTION_FORMAT*);
-    void RSB(INSTRUCTION_FORMAT*);
-    void ADD(INSTRUCTION_FORMAT*);
-    void ADC(INSTRUCTION_FORMAT*);
-    void SBC(INSTRUCTION_FORMAT*);
-    void RSC(INSTRUCTION_FORMAT*);
-    void TST(INSTRUCTION_FORMAT*);
-    void TEQ(INSTRUCTION_FORMAT*);
-    void CMP(INSTRUCTION_FORMAT*);
-    void CMN(INSTRUCTION_FORMAT*);
-    void ORR(INSTRUCTION_FORMAT*);
-    void MOV(INSTRUCTION_FORMAT*);
-    void BIC(INSTRUCTION_FORMAT*);
-    void MVN(INSTRUCTION_FORMAT*);
-
     void MSR(INSTRUCTION_FORMAT *);
     void MRS(INSTRUCTION_FORMAT *);
+    void write_PSR(U32 instruction, U32 value);
+    void restore_CPSR();
+    void switch_mode(U32 new_mode);
+
+    //Ri of the user bank, where switch_mode() left it while another bank runs
+    U32 &user_register(U32 i)
+    {
+        if (i >= 13 && this->bank != BANK_USR)
+        {
+            return this->banked_R13_R14[BANK_USR][i - 13];
+        }
+        if (i >= 8 && i < 13 && this->bank == BANK_FIQ)
+        {
+            return this->banked_R8_R12[i - 8];
+        }
+        return this->R[i];
+    }
 
     void MUL(INSTRUCTION_FORMAT *);
     void MLA(INSTRUCTION_FORMAT *);
     void MULL(INSTRUCTION_FORMAT *);
     void MLAL(INSTRUCTION_FORMAT *);
+    void SWP(INSTRUCTION_FORMAT *);
+    void SWPB(INSTRUCTION_FORMAT *);
 
 
-    void LDR(INSTRUCTION_FORMAT *);
-    void STR(INSTRUCTION_FORMAT *);
 
+    //data processing, see OPERAND2_* for the operand2 forms
+    template<U32 OPCODE, U32 S, U32 OPERAND2> void data_proc(INSTRUCTION_FORMAT*);
+    //single data transfer, OFFSET is OPERAND2_IMM or the *_I form of the register offset's shift
+    template<U32 P, U32 U, U32 B, U32 W, U32 L, U32 OFFSET> void single_data_tsf(INSTRUCTION_FORMAT*);
+    //halfword and signed data transfer, SH is bit[6:5] : 1 halfword, 2 signed byte, 3 signed halfword
+    template<U32 P, U32 U, U32 I, U32 W, U32 L, U32 SH> void halfword_data_tsf(INSTRUCTION_FORMAT*);
+    //block data transfer
+    template<U32 P, U32 U, U32 S, U32 W, U32 L> void block_data_tsf(INSTRUCTION_FORMAT*);
 
-
-    void AND_lli(INSTRUCTION_FORMAT*);
-    void AND_llr(INSTRUCTION_FORMAT*);
-    void AND_lri(INSTRUCTION_FORMAT*);
-    void AND_lrr(INSTRUCTION_FORMAT*);
-    void AND_ari(INSTRUCTION_FORMAT*);
-    void AND_arr(INSTRUCTION_FORMAT*);
-    void AND_rri(INSTRUCTION_FORMAT*);
-    void AND_rrr(INSTRUCTION_FORMAT*);
-    
-    void ANDS_lli(INSTRUCTION_FORMAT*);
-    void ANDS_llr(INSTRUCTION_FORMAT*);
-    void ANDS_lri(INSTRUCTION_FORMAT*);
-    void ANDS_lrr(INSTRUCTION_FORMAT*);
-    void ANDS_ari(INSTRUCTION_FORMAT*);
-    void ANDS_arr(INSTRUCTION_FORMAT*);
-    void ANDS_rri(INSTRUCTION_FORMAT*);
-    void ANDS_rrr(INSTRUCTION_FORMAT*);
-    
-    //exclusive OR
-    void EOR_lli(INSTRUCTION_FORMAT*);
-    void EOR_llr(INSTRUCTION_FORMAT*);
-    void EOR_lri(INSTRUCTION_FORMAT*);
-    void EOR_lrr(INSTRUCTION_FORMAT*);
-    void EOR_ari(INSTRUCTION_FORMAT*);
-    void EOR_arr(INSTRUCTION_FORMAT*);
-    void EOR_rri(INSTRUCTION_FORMAT*);
-    void EOR_rrr(INSTRUCTION_FORMAT*);
-    
-    void EORS_lli(INSTRUCTION_FORMAT*);
-    void EORS_llr(INSTRUCTION_FORMAT*);
-    void EORS_lri(INSTRUCTION_FORMAT*);
-    void EORS_lrr(INSTRUCTION_FORMAT*);
-    void EORS_ari(INSTRUCTION_FORMAT*);
-    void EORS_arr(INSTRUCTION_FORMAT*);
-    void EORS_rri(INSTRUCTION_FORMAT*);
-    void EORS_rrr(INSTRUCTION_FORMAT*);
-    
-    void SUB_lli(INSTRUCTION_FORMAT*);
-    void SUB_llr(INSTRUCTION_FORMAT*);
-    void SUB_lri(INSTRUCTION_FORMAT*);
-    void SUB_lrr(INSTRUCTION_FORMAT*);
-    void SUB_ari(INSTRUCTION_FORMAT*);
-    void SUB_arr(INSTRUCTION_FORMAT*);
-    void SUB_rri(INSTRUCTION_FORMAT*);
-    void SUB_rrr(INSTRUCTION_FORMAT*);
-    
-    void SUBS_lli(INSTRUCTION_FORMAT*);
-    void SUBS_llr(INSTRUCTION_FORMAT*);
-    void SUBS_lri(INSTRUCTION_FORMAT*);
-    void SUBS_lrr(INSTRUCTION_FORMAT*);
-    void SUBS_ari(INSTRUCTION_FORMAT*);
-    void SUBS_arr(INSTRUCTION_FORMAT*);
-    void SUBS_rri(INSTRUCTION_FORMAT*);
-    void SUBS_rrr(INSTRUCTION_FORMAT*);
-    
-    void RSB_lli(INSTRUCTION_FORMAT*);
-    void RSB_llr(INSTRUCTION_FORMAT*);
-    void RSB_lri(INSTRUCTION_FORMAT*);
-    void RSB_lrr(INSTRUCTION_FORMAT*);
-    void RSB_ari(INSTRUCTION_FORMAT*);
-    void RSB_arr(INSTRUCTION_FORMAT*);
-    void RSB_rri(INSTRUCTION_FORMAT*);
-    void RSB_rrr(INSTRUCTION_FORMAT*);
-    
-    void RSBS_lli(INSTRUCTION_FORMAT*);
-    void RSBS_llr(INSTRUCTION_FORMAT*);
-    void RSBS_lri(INSTRUCTION_FORMAT*);
-    void RSBS_lrr(INSTRUCTION_FORMAT*);
-    void RSBS_ari(INSTRUCTION_FORMAT*);
-    void RSBS_arr(INSTRUCTION_FORMAT*);
-    void RSBS_rri(INSTRUCTION_FORMAT*);
-    void RSBS_rrr(INSTRUCTION_FORMAT*);
-    
-    void ADD_lli(INSTRUCTION_FORMAT*);
-    void ADD_llr(INSTRUCTION_FORMAT*);
-    void ADD_lri(INSTRUCTION_FORMAT*);
-    void ADD_lrr(INSTRUCTION_FORMAT*);
-    void ADD_ari(INSTRUCTION_FORMAT*);
-    void ADD_arr(INSTRUCTION_FORMAT*);
-    void ADD_rri(INSTRUCTION_FORMAT*);
-    void ADD_rrr(INSTRUCTION_FORMAT*);
-    
-    void ADDS_lli(INSTRUCTION_FORMAT*);
-    void ADDS_llr(INSTRUCTION_FORMAT*);
-    void ADDS_lri(INSTRUCTION_FORMAT*);
-    void ADDS_lrr(INSTRUCTION_FORMAT*);
-    void ADDS_ari(INSTRUCTION_FORMAT*);
-    void ADDS_arr(INSTRUCTION_FORMAT*);
-    void ADDS_rri(INSTRUCTION_FORMAT*);
-    void ADDS_rrr(INSTRUCTION_FORMAT*);
-    
-    void ADC_lli(INSTRUCTION_FORMAT*);
-    void ADC_llr(INSTRUCTION_FORMAT*);
-    void ADC_lri(INSTRUCTION_FORMAT*);
-    void ADC_lrr(INSTRUCTION_FORMAT*);
-    void ADC_ari(INSTRUCTION_FORMAT*);
-    void ADC_arr(INSTRUCTION_FORMAT*);
-    void ADC_rri(INSTRUCTION_FORMAT*);
-    void ADC_rrr(INSTRUCTION_FORMAT*);
-    
-    void ADCS_lli(INSTRUCTION_FORMAT*);
-    void ADCS_llr(INSTRUCTION_FORMAT*);
-    void ADCS_lri(INSTRUCTION_FORMAT*);
-    void ADCS_lrr(INSTRUCTION_FORMAT*);
-    void ADCS_ari(INSTRUCTION_FORMAT*);
-    void ADCS_arr(INSTRUCTION_FORMAT*);
-    void ADCS_rri(INSTRUCTION_FORMAT*);
-    void ADCS_rrr(INSTRUCTION_FORMAT*);
-    
-    void SBC_lli(INSTRUCTION_FORMAT*);
-    void SBC_llr(INSTRUCTION_FORMAT*);
-    void SBC_lri(INSTRUCTION_FORMAT*);
-    void SBC_lrr(INSTRUCTION_FORMAT*);
-    void SBC_ari(INSTRUCTION_FORMAT*);
-    void SBC_arr(INSTRUCTION_FORMAT*);
-    void SBC_rri(INSTRUCTION_FORMAT*);
-    void SBC_rrr(INSTRUCTION_FORMAT*);
-    
-    void SBCS_lli(INSTRUCTION_FORMAT*);
-    void SBCS_llr(INSTRUCTION_FORMAT*);
-    void SBCS_lri(INSTRUCTION_FORMAT*);
-    void SBCS_lrr(INSTRUCTION_FORMAT*);
-    void SBCS_ari(INSTRUCTION_FORMAT*);
-    void SBCS_arr(INSTRUCTION_FORMAT*);
-    void SBCS_rri(INSTRUCTION_FORMAT*);
-    void SBCS_rrr(INSTRUCTION_FORMAT*);
-    
-    void RSC_lli(INSTRUCTION_FORMAT*);
-    void RSC_llr(INSTRUCTION_FORMAT*);
-    void RSC_lri(INSTRUCTION_FORMAT*);
-    void RSC_lrr(INSTRUCTION_FORMAT*);
-    void RSC_ari(INSTRUCTION_FORMAT*);
-    void RSC_arr(INSTRUCTION_FORMAT*);
-    void RSC_rri(INSTRUCTION_FORMAT*);
-    void RSC_rrr(INSTRUCTION_FORMAT*);
-    
-    void RSCS_lli(INSTRUCTION_FORMAT*);
-    void RSCS_llr(INSTRUCTION_FORMAT*);
-    void RSCS_lri(INSTRUCTION_FORMAT*);
-    void RSCS_lrr(INSTRUCTION_FORMAT*);
-    void RSCS_ari(INSTRUCTION_FORMAT*);
-    void RSCS_arr(INSTRUCTION_FORMAT*);
-    void RSCS_rri(INSTRUCTION_FORMAT*);
-    void RSCS_rrr(INSTRUCTION_FORMAT*);
-    
-    void TSTS_lli(INSTRUCTION_FORMAT*);
-    void TSTS_llr(INSTRUCTION_FORMAT*);
-    void TSTS_lri(INSTRUCTION_FORMAT*);
-    void TSTS_lrr(INSTRUCTION_FORMAT*);
-    void TSTS_ari(INSTRUCTION_FORMAT*);
-    void TSTS_arr(INSTRUCTION_FORMAT*);
-    void TSTS_rri(INSTRUCTION_FORMAT*);
-    void TSTS_rrr(INSTRUCTION_FORMAT*);
-    
-    void TEQS_lli(INSTRUCTION_FORMAT*);
-    void TEQS_llr(INSTRUCTION_FORMAT*);
-    void TEQS_lri(INSTRUCTION_FORMAT*);
-    void TEQS_lrr(INSTRUCTION_FORMAT*);
-    void TEQS_ari(INSTRUCTION_FORMAT*);
-    void TEQS_arr(INSTRUCTION_FORMAT*);
-    void TEQS_rri(INSTRUCTION_FORMAT*);
-    void TEQS_rrr(INSTRUCTION_FORMAT*);
-    
-    void CMPS_lli(INSTRUCTION_FORMAT*);
-    void CMPS_llr(INSTRUCTION_FORMAT*);
-    void CMPS_lri(INSTRUCTION_FORMAT*);
-    void CMPS_lrr(INSTRUCTION_FORMAT*);
-    void CMPS_ari(INSTRUCTION_FORMAT*);
-    void CMPS_arr(INSTRUCTION_FORMAT*);
-    void CMPS_rri(INSTRUCTION_FORMAT*);
-    void CMPS_rrr(INSTRUCTION_FORMAT*);
-    
-    void CMNS_lli(INSTRUCTION_FORMAT*);
-    void CMNS_llr(INSTRUCTION_FORMAT*);
-    void CMNS_lri(INSTRUCTION_FORMAT*);
-    void CMNS_lrr(INSTRUCTION_FORMAT*);
-    void CMNS_ari(INSTRUCTION_FORMAT*);
-    void CMNS_arr(INSTRUCTION_FORMAT*);
-    void CMNS_rri(INSTRUCTION_FORMAT*);
-    void CMNS_rrr(INSTRUCTION_FORMAT*);
-    
-    void ORR_lli(INSTRUCTION_FORMAT*);
-    void ORR_llr(INSTRUCTION_FORMAT*);
-    void ORR_lri(INSTRUCTION_FORMAT*);
-    void ORR_lrr(INSTRUCTION_FORMAT*);
-    void ORR_ari(INSTRUCTION_FORMAT*);
-    void ORR_arr(INSTRUCTION_FORMAT*);
-    void ORR_rri(INSTRUCTION_FORMAT*);
-    void ORR_rrr(INSTRUCTION_FORMAT*);
-    
-    void ORRS_lli(INSTRUCTION_FORMAT*);
-    void ORRS_llr(INSTRUCTION_FORMAT*);
-    void ORRS_lri(INSTRUCTION_FORMAT*);
-    void ORRS_lrr(INSTRUCTION_FORMAT*);
-    void ORRS_ari(INSTRUCTION_FORMAT*);
-    void ORRS_arr(INSTRUCTION_FORMAT*);
-    void ORRS_rri(INSTRUCTION_FORMAT*);
-    void ORRS_rrr(INSTRUCTION_FORMAT*);
-    
-    void MOV_lli(INSTRUCTION_FORMAT*);
-    void MOV_llr(INSTRUCTION_FORMAT*);
-    void MOV_lri(INSTRUCTION_FORMAT*);
-    void MOV_lrr(INSTRUCTION_FORMAT*);
-    void MOV_ari(INSTRUCTION_FORMAT*);
-    void MOV_arr(INSTRUCTION_FORMAT*);
-    void MOV_rri(INSTRUCTION_FORMAT*);
-    void MOV_rrr(INSTRUCTION_FORMAT*);
-    
-    void MOVS_lli(INSTRUCTION_FORMAT*);
-    void MOVS_llr(INSTRUCTION_FORMAT*);
-    void MOVS_lri(INSTRUCTION_FORMAT*);
-    void MOVS_lrr(INSTRUCTION_FORMAT*);
-    void MOVS_ari(INSTRUCTION_FORMAT*);
-    void MOVS_arr(INSTRUCTION_FORMAT*);
-    void MOVS_rri(INSTRUCTION_FORMAT*);
-    void MOVS_rrr(INSTRUCTION_FORMAT*);
-    
-    void BIC_lli(INSTRUCTION_FORMAT*);
-    void BIC_llr(INSTRUCTION_FORMAT*);
-    void BIC_lri(INSTRUCTION_FORMAT*);
-    void BIC_lrr(INSTRUCTION_FORMAT*);
-    void BIC_ari(INSTRUCTION_FORMAT*);
-    void BIC_arr(INSTRUCTION_FORMAT*);
-    void BIC_rri(INSTRUCTION_FORMAT*);
-    void BIC_rrr(INSTRUCTION_FORMAT*);
-    
-    void BICS_lli(INSTRUCTION_FORMAT*);
-    void BICS_llr(INSTRUCTION_FORMAT*);
-    void BICS_lri(INSTRUCTION_FORMAT*);
-    void BICS_lrr(INSTRUCTION_FORMAT*);
-    void BICS_ari(INSTRUCTION_FORMAT*);
-    void BICS_arr(INSTRUCTION_FORMAT*);
-    void BICS_rri(INSTRUCTION_FORMAT*);
-    void BICS_rrr(INSTRUCTION_FORMAT*);
-    
-    void MVN_lli(INSTRUCTION_FORMAT*);
-    void MVN_llr(INSTRUCTION_FORMAT*);
-    void MVN_lri(INSTRUCTION_FORMAT*);
-    void MVN_lrr(INSTRUCTION_FORMAT*);
-    void MVN_ari(INSTRUCTION_FORMAT*);
-    void MVN_arr(INSTRUCTION_FORMAT*);
-    void MVN_rri(INSTRUCTION_FORMAT*);
-    void MVN_rrr(INSTRUCTION_FORMAT*);
-
-    void MVNS_lli(INSTRUCTION_FORMAT*);
-    void MVNS_llr(INSTRUCTION_FORMAT*);
-    void MVNS_lri(INSTRUCTION_FORMAT*);
-    void MVNS_lrr(INSTRUCTION_FORMAT*);
-    void MVNS_ari(INSTRUCTION_FORMAT*);
-    void MVNS_arr(INSTRUCTION_FORMAT*);
-    void MVNS_rri(INSTRUCTION_FORMAT*);
-    void MVNS_rrr(INSTRUCTION_FORMAT*);
-    
-    void AND_imm (INSTRUCTION_FORMAT*);	
-    void ANDS_imm (INSTRUCTION_FORMAT*);
-    void EOR_imm (INSTRUCTION_FORMAT*);
-    void EORS_imm (INSTRUCTION_FORMAT*);
-    void SUB_imm (INSTRUCTION_FORMAT*);
-    void SUBS_imm (INSTRUCTION_FORMAT*);
-    void RSB_imm (INSTRUCTION_FORMAT*);
-    void RSBS_imm (INSTRUCTION_FORMAT*);
-    void ADD_imm (INSTRUCTION_FORMAT*);
-    void ADDS_imm (INSTRUCTION_FORMAT*);
-    void ADC_imm (INSTRUCTION_FORMAT*);
-    void ADCS_imm (INSTRUCTION_FORMAT*);
-    void SBC_imm (INSTRUCTION_FORMAT*);
-    void SBCS_imm (INSTRUCTION_FORMAT*);
-    void RSC_imm (INSTRUCTION_FORMAT*);
-    void RSCS_imm (INSTRUCTION_FORMAT*);
-    void TSTS_imm (INSTRUCTION_FORMAT*);
     void MSR_ic (INSTRUCTION_FORMAT*);
-    void TEQS_imm (INSTRUCTION_FORMAT*);
-    void CMPS_imm (INSTRUCTION_FORMAT*);
     void MSR_is (INSTRUCTION_FORMAT*);
-    void CMNS_imm (INSTRUCTION_FORMAT*);
-    void ORR_imm (INSTRUCTION_FORMAT*);
-    void ORRS_imm (INSTRUCTION_FORMAT*);
-    void MOV_imm (INSTRUCTION_FORMAT*);
-    void MOVS_imm (INSTRUCTION_FORMAT*);
-    void BIC_imm (INSTRUCTION_FORMAT*);
-    void BICS_imm (INSTRUCTION_FORMAT*);
-    void MVN_imm (INSTRUCTION_FORMAT*);
-    void MVNS_imm (INSTRUCTION_FORMAT*);
-    void STR_ptim (INSTRUCTION_FORMAT*);
-    void LDR_ptim (INSTRUCTION_FORMAT*);
-    void STRT_ptim (INSTRUCTION_FORMAT*);
-    void LDRT_ptim (INSTRUCTION_FORMAT*);
-    void STRB_ptim (INSTRUCTION_FORMAT*);
-    void LDRB_ptim (INSTRUCTION_FORMAT*);
-    void STRBT_ptim (INSTRUCTION_FORMAT*);
-    void LDRBT_ptim (INSTRUCTION_FORMAT*);
-    void STR_ptip (INSTRUCTION_FORMAT*);
-    void LDR_ptip (INSTRUCTION_FORMAT*);
-    void STRT_ptip (INSTRUCTION_FORMAT*);
-    void LDRT_ptip (INSTRUCTION_FORMAT*);
-    void STRB_ptip (INSTRUCTION_FORMAT*);
-    void LDRB_ptip (INSTRUCTION_FORMAT*);
-    void STRBT_ptip (INSTRUCTION_FORMAT*);
-    void LDRBT_ptip (INSTRUCTION_FORMAT*);
-    void STR_ofim (INSTRUCTION_FORMAT*);
-    void LDR_ofim (INSTRUCTION_FORMAT*);
-    void STR_prim (INSTRUCTION_FORMAT*);
-    void LDR_prim (INSTRUCTION_FORMAT*);
-    void STRB_ofim (INSTRUCTION_FORMAT*);
-    void LDRB_ofim (INSTRUCTION_FORMAT*);
-    void STRB_prim (INSTRUCTION_FORMAT*);
-    void LDRB_prim (INSTRUCTION_FORMAT*);
-    void STR_ofip (INSTRUCTION_FORMAT*);
-    void LDR_ofip (INSTRUCTION_FORMAT*);
-    void STR_prip (INSTRUCTION_FORMAT*);
-    void LDR_prip (INSTRUCTION_FORMAT*);
-    void STRB_ofip (INSTRUCTION_FORMAT*);
-    void LDRB_ofip (INSTRUCTION_FORMAT*);
-    void STRB_prip (INSTRUCTION_FORMAT*);
-    void LDRB_prip (INSTRUCTION_FORMAT*);
-    
-    void STR_ptrmll (INSTRUCTION_FORMAT*); 
-    void STR_ptrmlr (INSTRUCTION_FORMAT*); 
-    void STR_ptrmar (INSTRUCTION_FORMAT*); 
-    void STR_ptrmrr (INSTRUCTION_FORMAT*); 
-    
-    void LDR_ptrmll (INSTRUCTION_FORMAT*); 
-    void LDR_ptrmlr (INSTRUCTION_FORMAT*); 
-    void LDR_ptrmar (INSTRUCTION_FORMAT*); 
-    void LDR_ptrmrr (INSTRUCTION_FORMAT*); 
-    
-    void STRT_ptrmll (INSTRUCTION_FORMAT*); 
-    void STRT_ptrmlr (INSTRUCTION_FORMAT*); 
-    void STRT_ptrmar (INSTRUCTION_FORMAT*); 
-    void STRT_ptrmrr (INSTRUCTION_FORMAT*); 
-    
-    void LDRT_ptrmll (INSTRUCTION_FORMAT*); 
-    void LDRT_ptrmlr (INSTRUCTION_FORMAT*); 
-    void LDRT_ptrmar (INSTRUCTION_FORMAT*); 
-    void LDRT_ptrmrr (INSTRUCTION_FORMAT*); 
-    
-    void STRB_ptrmll (INSTRUCTION_FORMAT*); 
-    void STRB_ptrmlr (INSTRUCTION_FORMAT*); 
-    void STRB_ptrmar (INSTRUCTION_FORMAT*); 
-    void STRB_ptrmrr (INSTRUCTION_FORMAT*); 
-    
-    void LDRB_ptrmll (INSTRUCTION_FORMAT*); 
-    void LDRB_ptrmlr (INSTRUCTION_FORMAT*); 
-    void LDRB_ptrmar (INSTRUCTION_FORMAT*); 
-    void LDRB_ptrmrr (INSTRUCTION_FORMAT*); 
-    
-    void STRBT_ptrmll (INSTRUCTION_FORMAT*); 
-    void STRBT_ptrmlr (INSTRUCTION_FORMAT*); 
-    void STRBT_ptrmar (INSTRUCTION_FORMAT*); 
-    void STRBT_ptrmrr (INSTRUCTION_FORMAT*); 
-              
-    void LDRBT_ptrmll (INSTRUCTION_FORMAT*); 
-    void LDRBT_ptrmlr (INSTRUCTION_FORMAT*); 
-    void LDRBT_ptrmar (INSTRUCTION_FORMAT*); 
-    void LDRBT_ptrmrr (INSTRUCTION_FORMAT*); 
-    
-    void STR_ptrpll (INSTRUCTION_FORMAT*); 
-    void STR_ptrplr (INSTRUCTION_FORMAT*); 
-    void STR_ptrpar (INSTRUCTION_FORMAT*); 
-    void STR_ptrprr (INSTRUCTION_FORMAT*); 
-    
-    void LDR_ptrpll (INSTRUCTION_FORMAT*); 
-    void LDR_ptrplr (INSTRUCTION_FORMAT*); 
-    void LDR_ptrpar (INSTRUCTION_FORMAT*); 
-    void LDR_ptrprr (INSTRUCTION_FORMAT*); 
-    
-    void STRT_ptrpll (INSTRUCTION_FORMAT*); 
-    void STRT_ptrplr (INSTRUCTION_FORMAT*); 
-    void STRT_ptrpar (INSTRUCTION_FORMAT*); 
-    void STRT_ptrprr (INSTRUCTION_FORMAT*); 
-             
-    void LDRT_ptrpll (INSTRUCTION_FORMAT*); 
-    void LDRT_ptrplr (INSTRUCTION_FORMAT*); 
-    void LDRT_ptrpar (INSTRUCTION_FORMAT*); 
-    void LDRT_ptrprr (INSTRUCTION_FORMAT*); 
-    
-    void STRB_ptrpll (INSTRUCTION_FORMAT*); 
-    void STRB_ptrplr (INSTRUCTION_FORMAT*); 
-    void STRB_ptrpar (INSTRUCTION_FORMAT*); 
-    void STRB_ptrprr (INSTRUCTION_FORMAT*); 
-             
-    void LDRB_ptrpll (INSTRUCTION_FORMAT*); 
-    void LDRB_ptrplr (INSTRUCTION_FORMAT*); 
-    void LDRB_ptrpar (INSTRUCTION_FORMAT*); 
-    void LDRB_ptrprr (INSTRUCTION_FORMAT*); 
-    
-    void STRBT_ptrpll (INSTRUCTION_FORMAT*); 
-    void STRBT_ptrplr (INSTRUCTION_FORMAT*); 
-    void STRBT_ptrpar (INSTRUCTION_FORMAT*); 
-    void STRBT_ptrprr (INSTRUCTION_FORMAT*); 
-              
-    void LDRBT_ptrpll (INSTRUCTION_FORMAT*); 
-    void LDRBT_ptrplr (INSTRUCTION_FORMAT*); 
-    void LDRBT_ptrpar (INSTRUCTION_FORMAT*); 
-    void LDRBT_ptrprr (INSTRUCTION_FORMAT*); 
-    
-    void STR_ofrmll (INSTRUCTION_FORMAT*); 
-    void STR_ofrmlr (INSTRUCTION_FORMAT*); 
-    void STR_ofrmar (INSTRUCTION_FORMAT*); 
-    void STR_ofrmrr (INSTRUCTION_FORMAT*); 
-    
-    void LDR_ofrmll (INSTRUCTION_FORMAT*); 
-    void LDR_ofrmlr (INSTRUCTION_FORMAT*); 
-    void LDR_ofrmar (INSTRUCTION_FORMAT*); 
-    void LDR_ofrmrr (INSTRUCTION_FORMAT*); 
-    
-    void STR_prrmll (INSTRUCTION_FORMAT*); 
-    void STR_prrmlr (INSTRUCTION_FORMAT*); 
-    void STR_prrmar (INSTRUCTION_FORMAT*); 
-    void STR_prrmrr (INSTRUCTION_FORMAT*); 
-    
-    void LDR_prrmll (INSTRUCTION_FORMAT*); 
-    void LDR_prrmlr (INSTRUCTION_FORMAT*); 
-    void LDR_prrmar (INSTRUCTION_FORMAT*); 
-    void LDR_prrmrr (INSTRUCTION_FORMAT*); 
-    
-    void STRB_ofrmll (INSTRUCTION_FORMAT*); 
-    void STRB_ofrmlr (INSTRUCTION_FORMAT*); 
-    void STRB_ofrmar (INSTRUCTION_FORMAT*); 
-    void STRB_ofrmrr (INSTRUCTION_FORMAT*); 
-             
-    void LDRB_ofrmll (INSTRUCTION_FORMAT*); 
-    void LDRB_ofrmlr (INSTRUCTION_FORMAT*); 
-    void LDRB_ofrmar (INSTRUCTION_FORMAT*); 
-    void LDRB_ofrmrr (INSTRUCTION_FORMAT*); 
-             
-    void STRB_prrmll (INSTRUCTION_FORMAT*); 
-    void STRB_prrmlr (INSTRUCTION_FORMAT*); 
-    void STRB_prrmar (INSTRUCTION_FORMAT*); 
-    void STRB_prrmrr (INSTRUCTION_FORMAT*); 
-             
-    void LDRB_prrmll (INSTRUCTION_FORMAT*); 
-    void LDRB_prrmlr (INSTRUCTION_FORMAT*); 
-    void LDRB_prrmar (INSTRUCTION_FORMAT*); 
-    void LDRB_prrmrr (INSTRUCTION_FORMAT*); 
-    
-    void STR_ofrpll (INSTRUCTION_FORMAT*); 
-    void STR_ofrplr (INSTRUCTION_FORMAT*); 
-    void STR_ofrpar (INSTRUCTION_FORMAT*); 
-    void STR_ofrprr (INSTRUCTION_FORMAT*); 
-    
-    void LDR_ofrpll (INSTRUCTION_FORMAT*); 
-    void LDR_ofrplr (INSTRUCTION_FORMAT*); 
-    void LDR_ofrpar (INSTRUCTION_FORMAT*);
-    
-    void STR_prrpll (INSTRUCTION_FORMAT*); 
-    void STR_prrplr (INSTRUCTION_FORMAT*); 
-    void STR_prrpar (INSTRUCTION_FORMAT*); 
-    void STR_prrprr (INSTRUCTION_FORMAT*); 
-    
-    void LDR_prrpll (INSTRUCTION_FORMAT*); 
-    void LDR_prrplr (INSTRUCTION_FORMAT*); 
-    void LDR_prrpar (INSTRUCTION_FORMAT*); 
-    void LDR_prrprr (INSTRUCTION_FORMAT*); 
-    
-    void STRB_ofrpll (INSTRUCTION_FORMAT*); 
-    void STRB_ofrplr (INSTRUCTION_FORMAT*); 
-    void STRB_ofrpar (INSTRUCTION_FORMAT*); 
-    void STRB_ofrprr (INSTRUCTION_FORMAT*); 
-             
-    void LDRB_ofrpll (INSTRUCTION_FORMAT*); 
-    void LDRB_ofrplr (INSTRUCTION_FORMAT*); 
-    void LDRB_ofrpar (INSTRUCTION_FORMAT*); 
-    void LDRB_ofrprr (INSTRUCTION_FORMAT*); 
-             
-    void STRB_prrpll (INSTRUCTION_FORMAT*); 
-    void STRB_prrplr (INSTRUCTION_FORMAT*); 
-    void STRB_prrpar (INSTRUCTION_FORMAT*); 
-    void STRB_prrprr (INSTRUCTION_FORMAT*); 
-             
-    void LDRB_prrpll (INSTRUCTION_FORMAT*); 
-    void LDRB_prrplr (INSTRUCTION_FORMAT*); 
-    void LDRB_prrpar (INSTRUCTION_FORMAT*); 
-    void LDRB_prrprr (INSTRUCTION_FORMAT*); 
-    
-    void STMDA(INSTRUCTION_FORMAT*);
-    void LDMDA(INSTRUCTION_FORMAT*);
-    void STMDA_w(INSTRUCTION_FORMAT*);
-    void LDMDA_w(INSTRUCTION_FORMAT*);
-    void STMDA_u(INSTRUCTION_FORMAT*);
-    void LDMDA_u(INSTRUCTION_FORMAT*);
-    void STMDA_uw(INSTRUCTION_FORMAT*);
-    void LDMDA_uw(INSTRUCTION_FORMAT*);
-    void STMIA(INSTRUCTION_FORMAT*);
-    void LDMIA(INSTRUCTION_FORMAT*);
-    void STMIA_w(INSTRUCTION_FORMAT*);
-    void LDMIA_w(INSTRUCTION_FORMAT*);
-    void STMIA_u(INSTRUCTION_FORMAT*);
-    void LDMIA_u(INSTRUCTION_FORMAT*);
-    void STMIA_uw(INSTRUCTION_FORMAT*);
-    void LDMIA_uw(INSTRUCTION_FORMAT*);
-    void STMDB(INSTRUCTION_FORMAT*);
-    void LDMDB(INSTRUCTION_FORMAT*);
-    void STMDB_w(INSTRUCTION_FORMAT*);
-    void LDMDB_w(INSTRUCTION_FORMAT*);
-    void STMDB_u(INSTRUCTION_FORMAT*);
-    void LDMDB_u(INSTRUCTION_FORMAT*);
-    void STMDB_uw(INSTRUCTION_FORMAT*);
-    void LDMDB_uw(INSTRUCTION_FORMAT*);
-    void STMIB(INSTRUCTION_FORMAT*);
-    void LDMIB(INSTRUCTION_FORMAT*);
-    void STMIB_w(INSTRUCTION_FORMAT*);
-    void LDMIB_w(INSTRUCTION_FORMAT*);
-    void STMIB_u(INSTRUCTION_FORMAT*);
-    void LDMIB_u(INSTRUCTION_FORMAT*);
-    void STMIB_uw(INSTRUCTION_FORMAT*);
-    void LDMIB_uw(INSTRUCTION_FORMAT*);
-    
+
     void B(INSTRUCTION_FORMAT*);
     void BL(INSTRUCTION_FORMAT*);
+    void BX(INSTRUCTION_FORMAT*);
+    void SWI(INSTRUCTION_FORMAT*);
+    void UND(INSTRUCTION_FORMAT*);
     
     void STC_ofm(INSTRUCTION_FORMAT*);
     void LDC_ofm(INSTRUCTION_FORMAT*);
@@ -1068,6 +1625,32 @@ public:
     void LDC_unp(INSTRUCTION_FORMAT*);
     void STC_ptp(INSTRUCTION_FORMAT*);
     void LDC_ptp(INSTRUCTION_FORMAT*);
+
+    //----------------------------//
+    //-- THUMB opcode functions --//
+    //----------------------------//
+    //one instance per format and the opcode bits in bit[15:6], see THUMB_*
+    //for the fields. named after the formats of the data sheet, chapter 5
+    template<U32 OP> void thumb_move_shifted(U32);
+    template<U32 I, U32 SUB> void thumb_add_subtract(U32);
+    template<U32 OP> void thumb_immediate(U32);
+    template<U32 OP> void thumb_alu(U32);
+    template<U32 OP, U32 H1, U32 H2> void thumb_hi_register(U32);
+    void thumb_pc_load(U32);
+    template<U32 L, U32 B> void thumb_register_offset(U32);
+    template<U32 H, U32 S> void thumb_sign_extended(U32);
+    template<U32 B, U32 L> void thumb_immediate_offset(U32);
+    template<U32 L> void thumb_halfword(U32);
+    template<U32 L> void thumb_sp_relative(U32);
+    template<U32 SP> void thumb_load_address(U32);
+    template<U32 S> void thumb_add_sp(U32);
+    template<U32 L, U32 R> void thumb_push_pop(U32);
+    template<U32 L> void thumb_multiple(U32);
+    template<U32 COND> void thumb_conditional_branch(U32);
+    void thumb_SWI(U32);
+    void thumb_B(U32);
+    template<U32 H> void thumb_BL(U32);
+    void thumb_UND(U32);
 	
 	
 
@@ -0,0 +1,720 @@
+#pragma once
+
+
+#include "arm7tdmi.hpp"
+
+
+//ARM decode table generated at compile time.
+//idx = bit[27:20] << 4 | bit[7:4], see doc/arm_opcode_map.docx
+struct ARM_DECODER
+{
+    typedef GBA_EMUALTOR_ARM7TDMI            CPU;
+    typedef GBA_EMUALTOR_ARM7TDMI::ARM_HANDLER ARM_HANDLER;
+    typedef GBA_EMUALTOR_ARM7TDMI::ARM_HANDLER_TABLE ARM_HANDLER_TABLE;
+
+    //data processing, operand2 is a shifted register, [opcode:S][bit 6:4]
+#define DATA_PROC_REG_ROW(OPC, S)                                                                       \
+        { &CPU::data_proc<OPC, S, OPERAND2_LLI>, &CPU::data_proc<OPC, S, OPERAND2_LLR>,                 \
+          &CPU::data_proc<OPC, S, OPERAND2_LRI>, &CPU::data_proc<OPC, S, OPERAND2_LRR>,                 \
+          &CPU::data_proc<OPC, S, OPERAND2_ARI>, &CPU::data_proc<OPC, S, OPERAND2_ARR>,                 \
+          &CPU::data_proc<OPC, S, OPERAND2_RRI>, &CPU::data_proc<OPC, S, OPERAND2_RRR> }
+
+    static constexpr ARM_HANDLER data_proc_reg[32][8] =
+    {
+        DATA_PROC_REG_ROW(OPC_AND, 0),
+        DATA_PROC_REG_ROW(OPC_AND, 1),
+        DATA_PROC_REG_ROW(OPC_EOR, 0),
+        DATA_PROC_REG_ROW(OPC_EOR, 1),
+        DATA_PROC_REG_ROW(OPC_SUB, 0),
+        DATA_PROC_REG_ROW(OPC_SUB, 1),
+        DATA_PROC_REG_ROW(OPC_RSB, 0),
+        DATA_PROC_REG_ROW(OPC_RSB, 1),
+        DATA_PROC_REG_ROW(OPC_ADD, 0),
+        DATA_PROC_REG_ROW(OPC_ADD, 1),
+        DATA_PROC_REG_ROW(OPC_ADC, 0),
+        DATA_PROC_REG_ROW(OPC_ADC, 1),
+        DATA_PROC_REG_ROW(OPC_SBC, 0),
+        DATA_PROC_REG_ROW(OPC_SBC, 1),
+        DATA_PROC_REG_ROW(OPC_RSC, 0),
+        DATA_PROC_REG_ROW(OPC_RSC, 1),
+        { 0 },  //TST without S : PSR transfer
+        DATA_PROC_REG_ROW(OPC_TST, 1),
+        { 0 },  //TEQ without S : PSR transfer, BX
+        DATA_PROC_REG_ROW(OPC_TEQ, 1),
+        { 0 },  //CMP without S : PSR transfer
+        DATA_PROC_REG_ROW(OPC_CMP, 1),
+        { 0 },  //CMN without S : PSR transfer
+        DATA_PROC_REG_ROW(OPC_CMN, 1),
+        DATA_PROC_REG_ROW(OPC_ORR, 0),
+        DATA_PROC_REG_ROW(OPC_ORR, 1),
+        DATA_PROC_REG_ROW(OPC_MOV, 0),
+        DATA_PROC_REG_ROW(OPC_MOV, 1),
+        DATA_PROC_REG_ROW(OPC_BIC, 0),
+        DATA_PROC_REG_ROW(OPC_BIC, 1),
+        DATA_PROC_REG_ROW(OPC_MVN, 0),
+        DATA_PROC_REG_ROW(OPC_MVN, 1),
+    };
+
+#undef DATA_PROC_REG_ROW
+
+    //data processing, operand2 is a rotated immediate, [opcode:S]
+    static constexpr ARM_HANDLER data_proc_imm[32] =
+    {
+        &CPU::data_proc<OPC_AND, 0, OPERAND2_IMM>,  &CPU::data_proc<OPC_AND, 1, OPERAND2_IMM>,
+        &CPU::data_proc<OPC_EOR, 0, OPERAND2_IMM>,  &CPU::data_proc<OPC_EOR, 1, OPERAND2_IMM>,
+        &CPU::data_proc<OPC_SUB, 0, OPERAND2_IMM>,  &CPU::data_proc<OPC_SUB, 1, OPERAND2_IMM>,
+        &CPU::data_proc<OPC_RSB, 0, OPERAND2_IMM>,  &CPU::data_proc<OPC_RSB, 1, OPERAND2_IMM>,
+        &CPU::data_proc<OPC_ADD, 0, OPERAND2_IMM>,  &CPU::data_proc<OPC_ADD, 1, OPERAND2_IMM>,
+        &CPU::data_proc<OPC_ADC, 0, OPERAND2_IMM>,  &CPU::data_proc<OPC_ADC, 1, OPERAND2_IMM>,
+        &CPU::data_proc<OPC_SBC, 0, OPERAND2_IMM>,  &CPU::data_proc<OPC_SBC, 1, OPERAND2_IMM>,
+        &CPU::data_proc<OPC_RSC, 0, OPERAND2_IMM>,  &CPU::data_proc<OPC_RSC, 1, OPERAND2_IMM>,
+        &CPU::UND,                                  &CPU::data_proc<OPC_TST, 1, OPERAND2_IMM>,
+        &CPU::MSR_ic,                               &CPU::data_proc<OPC_TEQ, 1, OPERAND2_IMM>,
+        &CPU::UND,                                  &CPU::data_proc<OPC_CMP, 1, OPERAND2_IMM>,
+        &CPU::MSR_is,                               &CPU::data_proc<OPC_CMN, 1, OPERAND2_IMM>,
+        &CPU::data_proc<OPC_ORR, 0, OPERAND2_IMM>,  &CPU::data_proc<OPC_ORR, 1, OPERAND2_IMM>,
+        &CPU::data_proc<OPC_MOV, 0, OPERAND2_IMM>,  &CPU::data_proc<OPC_MOV, 1, OPERAND2_IMM>,
+        &CPU::data_proc<OPC_BIC, 0, OPERAND2_IMM>,  &CPU::data_proc<OPC_BIC, 1, OPERAND2_IMM>,
+        &CPU::data_proc<OPC_MVN, 0, OPERAND2_IMM>,  &CPU::data_proc<OPC_MVN, 1, OPERAND2_IMM>,
+    };
+
+    //single data transfer, immediate offset, [P:U:B:W:L]
+#define SINGLE_DATA_TSF_IMM_ROW(P, U)                                                                                                   \
+        &CPU::single_data_tsf<P, U, 0, 0, 0, OPERAND2_IMM>, &CPU::single_data_tsf<P, U, 0, 0, 1, OPERAND2_IMM>,                         \
+        &CPU::single_data_tsf<P, U, 0, 1, 0, OPERAND2_IMM>, &CPU::single_data_tsf<P, U, 0, 1, 1, OPERAND2_IMM>,                         \
+        &CPU::single_data_tsf<P, U, 1, 0, 0, OPERAND2_IMM>, &CPU::single_data_tsf<P, U, 1, 0, 1, OPERAND2_IMM>,                         \
+        &CPU::single_data_tsf<P, U, 1, 1, 0, OPERAND2_IMM>, &CPU::single_data_tsf<P, U, 1, 1, 1, OPERAND2_IMM>
+
+    static constexpr ARM_HANDLER single_data_tsf_imm[32] =
+    {
+        SINGLE_DATA_TSF_IMM_ROW(0, 0),
+        SINGLE_DATA_TSF_IMM_ROW(0, 1),
+        SINGLE_DATA_TSF_IMM_ROW(1, 0),
+        SINGLE_DATA_TSF_IMM_ROW(1, 1),
+    };
+
+#undef SINGLE_DATA_TSF_IMM_ROW
+
+    //single data transfer, shifted register offset, [P:U:B:W:L][bit 6:5]
+#define SINGLE_DATA_TSF_REG_ROW(P, U, B, W, L)                                                                                          \
+        { &CPU::single_data_tsf<P, U, B, W, L, OPERAND2_LLI>, &CPU::single_data_tsf<P, U, B, W, L, OPERAND2_LRI>,                       \
+          &CPU::single_data_tsf<P, U, B, W, L, OPERAND2_ARI>, &CPU::single_data_tsf<P, U, B, W, L, OPERAND2_RRI> }
+
+#define SINGLE_DATA_TSF_REG_ROWS(P, U)                                                                                                  \
+        SINGLE_DATA_TSF_REG_ROW(P, U, 0, 0, 0), SINGLE_DATA_TSF_REG_ROW(P, U, 0, 0, 1),                                                 \
+        SINGLE_DATA_TSF_REG_ROW(P, U, 0, 1, 0), SINGLE_DATA_TSF_REG_ROW(P, U, 0, 1, 1),                                                 \
+        SINGLE_DATA_TSF_REG_ROW(P, U, 1, 0, 0), SINGLE_DATA_TSF_REG_ROW(P, U, 1, 0, 1),                                                 \
+        SINGLE_DATA_TSF_REG_ROW(P, U, 1, 1, 0), SINGLE_DATA_TSF_REG_ROW(P, U, 1, 1, 1)
+
+    static constexpr ARM_HANDLER single_data_tsf_reg[32][4] =
+    {
+        SINGLE_DATA_TSF_REG_ROWS(0, 0),
+        SINGLE_DATA_TSF_REG_ROWS(0, 1),
+        SINGLE_DATA_TSF_REG_ROWS(1, 0),
+        SINGLE_DATA_TSF_REG_ROWS(1, 1),
+    };
+
+#undef SINGLE_DATA_TSF_REG_ROWS
+#undef SINGLE_DATA_TSF_REG_ROW
+
+    //block data transfer, [P:U:S:W:L]
+#define BLK_DATA_TSF_ROW(P, U)                                                                                                          \
+        &CPU::block_data_tsf<P, U, 0, 0, 0>, &CPU::block_data_tsf<P, U, 0, 0, 1>,                                                       \
+        &CPU::block_data_tsf<P, U, 0, 1, 0>, &CPU::block_data_tsf<P, U, 0, 1, 1>,                                                       \
+        &CPU::block_data_tsf<P, U, 1, 0, 0>, &CPU::block_data_tsf<P, U, 1, 0, 1>,                                                       \
+        &CPU::block_data_tsf<P, U, 1, 1, 0>, &CPU::block_data_tsf<P, U, 1, 1, 1>
+
+    static constexpr ARM_HANDLER blk_data_tsf[32] =
+    {
+        BLK_DATA_TSF_ROW(0, 0),     //DA
+        BLK_DATA_TSF_ROW(0, 1),     //IA
+        BLK_DATA_TSF_ROW(1, 0),     //DB
+        BLK_DATA_TSF_ROW(1, 1),     //IB
+    };
+
+#undef BLK_DATA_TSF_ROW
+
+    //halfword data transfer, [P:U:I:W:L][SH - 1], stores are STRH only
+#define HALFWORD_DATA_TSF_ROW(P, U, I, W)                                                                                               \
+        { &CPU::halfword_data_tsf<P, U, I, W, 0, 1>, &CPU::UND, &CPU::UND },                                                           \
+        { &CPU::halfword_data_tsf<P, U, I, W, 1, 1>, &CPU::halfword_data_tsf<P, U, I, W, 1, 2>, &CPU::halfword_data_tsf<P, U, I, W, 1, 3> }
+
+#define HALFWORD_DATA_TSF_ROWS(P, U)                                                                                                    \
+        HALFWORD_DATA_TSF_ROW(P, U, 0, 0), HALFWORD_DATA_TSF_ROW(P, U, 0, 1),                                                           \
+        HALFWORD_DATA_TSF_ROW(P, U, 1, 0), HALFWORD_DATA_TSF_ROW(P, U, 1, 1)
+
+    static constexpr ARM_HANDLER halfword_data_tsf[32][3] =
+    {
+        HALFWORD_DATA_TSF_ROWS(0, 0),
+        HALFWORD_DATA_TSF_ROWS(0, 1),
+        HALFWORD_DATA_TSF_ROWS(1, 0),
+        HALFWORD_DATA_TSF_ROWS(1, 1),
+    };
+
+#undef HALFWORD_DATA_TSF_ROWS
+#undef HALFWORD_DATA_TSF_ROW
+
+    //coprocessor data transfer, [P:U:W:L], N is ignored
+    static constexpr ARM_HANDLER cop_data_tfr[16] =
+    {
+        &CPU::STC_unm, &CPU::LDC_unm, &CPU::STC_ptm, &CPU::LDC_ptm,
+        &CPU::STC_unp, &CPU::LDC_unp, &CPU::STC_ptp, &CPU::LDC_ptp,
+        &CPU::STC_ofm, &CPU::LDC_ofm, &CPU::STC_prm, &CPU::LDC_prm,
+        &CPU::STC_ofp, &CPU::LDC_ofp, &CPU::STC_prp, &CPU::LDC_prp,
+    };
+
+
+    static constexpr ARM_HANDLER decode(U32 idx)
+    {
+        U32 bit_27_20 = (idx >> 4) & 0xFF;
+        U32 bit_7_4   = idx & 0xF;
+
+        switch (bit_27_20 >> 5)
+        {
+            case 0x0:
+                //multiply, multiply long, single data swap
+                if (bit_7_4 == 0x9)
+                {
+                    if ((bit_27_20 & 0xFC) == 0x00)
+                    {
+                        return (bit_27_20 & BIT(1)) ? &CPU::MLA : &CPU::MUL;
+                    }
+                    if ((bit_27_20 & 0xF8) == 0x08)
+                    {
+                        return (bit_27_20 & BIT(1)) ? &CPU::MLAL : &CPU::MULL;
+                    }
+                    if ((bit_27_20 & 0xFB) == 0x10)
+                    {
+                        return (bit_27_20 & BIT(2)) ? &CPU::SWPB : &CPU::SWP;
+                    }
+                    return &CPU::UND;
+                }
+                //halfword data transfer, SH is not 0
+                if ((bit_7_4 & 0x9) == 0x9)
+                {
+                    return halfword_data_tsf[bit_27_20 & 0x1F][((bit_7_4 >> 1) & 0x3) - 1];
+                }
+                //TST/TEQ/CMP/CMN without S : PSR transfer, BX
+                if ((bit_27_20 & 0x19) == 0x10)
+                {
+                    if (bit_27_20 == 0x12 && bit_7_4 == 0x1)
+                    {
+                        return &CPU::BX;
+                    }
+                    if (bit_7_4 == 0x0)
+                    {
+                        return (bit_27_20 & BIT(1)) ? &CPU::MSR : &CPU::MRS;
+                    }
+                    return &CPU::UND;
+                }
+                return data_proc_reg[bit_27_20 & 0x1F][bit_7_4 & 0x7];
+            case 0x1:
+                return data_proc_imm[bit_27_20 & 0x1F];
+            case 0x2:
+                return single_data_tsf_imm[bit_27_20 & 0x1F];
+            case 0x3:
+                //bit 4 set is the undefined instruction space
+                if (bit_7_4 & 0x1)
+                {
+                    return &CPU::UND;
+                }
+                return single_data_tsf_reg[bit_27_20 & 0x1F][(bit_7_4 >> 1) & 0x3];
+            case 0x4:
+                return blk_data_tsf[bit_27_20 & 0x1F];
+            case 0x5:
+                return (bit_27_20 & BIT(4)) ? &CPU::BL : &CPU::B;
+            case 0x6:
+                return cop_data_tfr[((bit_27_20 >> 1) & 0xC) | (bit_27_20 & 0x3)];
+            default:
+                //coprocessor data operation and register transfer : no coprocessor on the GBA
+                return (bit_27_20 & BIT(4)) ? &CPU::SWI : &CPU::UND;
+        }
+    }
+
+    static constexpr ARM_HANDLER_TABLE build_table()
+    {
+        ARM_HANDLER_TABLE table = {};
+
+        for (U32 idx = 0; idx < 4096; idx++)
+        {
+            table.handler[idx] = decode(idx);
+        }
+        return table;
+    }
+
+
+    //-----------------//
+    //-- self check  --//
+    //-----------------//
+
+    //instruction set formats in the order of the data sheet (figure 4-1), first match wins
+    enum ARM_FORMAT
+    {
+        FMT_BRANCH_EXCHANGE,
+        FMT_MULTIPLY,
+        FMT_MULTIPLY_LONG,
+        FMT_SINGLE_DATA_SWAP,
+        FMT_HALFWORD_DATA_TSF,
+        FMT_MRS,
+        FMT_MSR_REG,
+        FMT_MSR_IMM,
+        FMT_PSR_UNDEFINED,
+        FMT_DATA_PROC_REG,
+        FMT_DATA_PROC_IMM,
+        FMT_UNDEFINED,
+        FMT_SINGLE_DATA_TSF_IMM,
+        FMT_SINGLE_DATA_TSF_REG,
+        FMT_BLK_DATA_TSF,
+        FMT_BRANCH,
+        FMT_COP_DATA_TSF,
+        FMT_COP_OPERATION,
+        FMT_SW_INT,
+    };
+
+    typedef struct arm_format_pattern
+    {
+        U32 mask;
+        U32 value;
+        ARM_FORMAT format;
+    }ARM_FORMAT_PATTERN;
+
+    static constexpr ARM_FORMAT_PATTERN format_patterns[] =
+    {
+        { 0xFFF, 0x121, FMT_BRANCH_EXCHANGE     },  //0001 0010 .... 0001
+        { 0xFCF, 0x009, FMT_MULTIPLY            },  //0000 00AS .... 1001
+        { 0xF8F, 0x089, FMT_MULTIPLY_LONG       },  //0000 1UAS .... 1001
+        { 0xFBF, 0x109, FMT_SINGLE_DATA_SWAP    },  //0001 0B00 .... 1001
+        { 0xE09, 0x009, FMT_HALFWORD_DATA_TSF   },  //000P U.WL .... 1SH1
+        { 0xFBF, 0x100, FMT_MRS                 },  //0001 0P00 .... 0000
+        { 0xFBF, 0x120, FMT_MSR_REG             },  //0001 0P10 .... 0000
+        { 0xFB0, 0x320, FMT_MSR_IMM             },  //0011 0P10 .... ....
+        { 0xF90, 0x100, FMT_PSR_UNDEFINED       },  //0001 0..0 .... .... (TST/TEQ/CMP/CMN without S)
+        { 0xFB0, 0x300, FMT_PSR_UNDEFINED       },  //0011 0.00 .... ....
+        { 0xE00, 0x000, FMT_DATA_PROC_REG       },  //000. .... .... ....
+        { 0xE00, 0x200, FMT_DATA_PROC_IMM       },  //001. .... .... ....
+        { 0xE01, 0x601, FMT_UNDEFINED           },  //011. .... .... ...1
+        { 0xE00, 0x400, FMT_SINGLE_DATA_TSF_IMM },  //010. .... .... ....
+        { 0xE00, 0x600, FMT_SINGLE_DATA_TSF_REG },  //011. .... .... ...0
+        { 0xE00, 0x800, FMT_BLK_DATA_TSF        },  //100. .... .... ....
+        { 0xE00, 0xA00, FMT_BRANCH              },  //101. .... .... ....
+        { 0xE00, 0xC00, FMT_COP_DATA_TSF        },  //110. .... .... ....
+        { 0xF00, 0xE00, FMT_COP_OPERATION       },  //1110 .... .... ....
+        { 0xF00, 0xF00, FMT_SW_INT              },  //1111 .... .... ....
+    };
+
+    static constexpr ARM_FORMAT classify(U32 idx)
+    {
+        for (const ARM_FORMAT_PATTERN &pattern : format_patterns)
+        {
+            if ((idx & pattern.mask) == pattern.value)
+            {
+                return pattern.format;
+            }
+        }
+        return FMT_UNDEFINED;
+    }
+
+    //expected handler from the format and its own fields
+    static constexpr ARM_HANDLER expected_handler(U32 idx)
+    {
+        U32 opcode_S  = (idx >> 4) & 0x1F;   //bit[24:20]
+        U32 A         = (idx >> 5) & 0x1;    //bit 21
+        U32 P         = (idx >> 6) & 0x1;    //bit 22, source/destination PSR, swap byte
+        U32 L         = (idx >> 8) & 0x1;    //bit 24, branch with link
+        U32 shift     = (idx >> 0) & 0x7;    //bit[6:4]
+        U32 shift_typ = (idx >> 1) & 0x3;    //bit[6:5], SH of a halfword transfer
+
+        switch (classify(idx))
+        {
+            case FMT_BRANCH_EXCHANGE:     return &CPU::BX;
+            case FMT_MULTIPLY:            return A ? &CPU::MLA : &CPU::MUL;
+            case FMT_MULTIPLY_LONG:       return A ? &CPU::MLAL : &CPU::MULL;
+            case FMT_SINGLE_DATA_SWAP:    return P ? &CPU::SWPB : &CPU::SWP;
+            case FMT_HALFWORD_DATA_TSF:   return shift_typ ? halfword_data_tsf[opcode_S][shift_typ - 1] : &CPU::UND;
+            case FMT_MRS:                 return &CPU::MRS;
+            case FMT_MSR_REG:             return &CPU::MSR;
+            case FMT_MSR_IMM:             return P ? &CPU::MSR_is : &CPU::MSR_ic;
+            case FMT_DATA_PROC_REG:       return data_proc_reg[opcode_S][shift];
+            case FMT_DATA_PROC_IMM:       return data_proc_imm[opcode_S];
+            case FMT_SINGLE_DATA_TSF_IMM: return single_data_tsf_imm[opcode_S];
+            case FMT_SINGLE_DATA_TSF_REG: return single_data_tsf_reg[opcode_S][shift_typ];
+            case FMT_BLK_DATA_TSF:        return blk_data_tsf[opcode_S];
+            case FMT_BRANCH:              return L ? &CPU::BL : &CPU::B;
+            case FMT_COP_DATA_TSF:        return cop_data_tfr[((opcode_S >> 1) & 0xC) | (opcode_S & 0x3)];
+            case FMT_SW_INT:              return &CPU::SWI;
+            default:                      return &CPU::UND;
+        }
+    }
+
+    static constexpr bool verify_table(const ARM_HANDLER_TABLE &table)
+    {
+        for (U32 idx = 0; idx < 4096; idx++)
+        {
+            if (table.handler[idx] == nullptr || table.handler[idx] != expected_handler(idx))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //index of an encoded instruction
+    static constexpr U32 index_of(U32 instruction)
+    {
+        return ((instruction >> 16) & 0xFF0) | ((instruction >> 4) & 0xF);
+    }
+};
+
+
+//spot checks of the family layouts against assembled instructions
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE0910312)) == &GBA_EMUALTOR_ARM7TDMI::data_proc<OPC_ADD, 1, OPERAND2_LLR>, "ADDS r0, r1, r2, LSL r3");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE1B00141)) == &GBA_EMUALTOR_ARM7TDMI::data_proc<OPC_MOV, 1, OPERAND2_ARI>, "MOVS r0, r1, ASR #2");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE1A00061)) == &GBA_EMUALTOR_ARM7TDMI::data_proc<OPC_MOV, 0, OPERAND2_RRI>, "MOV r0, r1, RRX");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE3500000)) == &GBA_EMUALTOR_ARM7TDMI::data_proc<OPC_CMP, 1, OPERAND2_IMM>, "CMP r0, #0");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE321F0D3)) == &GBA_EMUALTOR_ARM7TDMI::MSR_ic,    "MSR CPSR_c, #0xD3");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE0000291)) == &GBA_EMUALTOR_ARM7TDMI::MUL,       "MUL r0, r1, r2");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE0C10392)) == &GBA_EMUALTOR_ARM7TDMI::MULL,      "SMULL r0, r1, r2, r3");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE12FFF1E)) == &GBA_EMUALTOR_ARM7TDMI::BX,        "BX lr");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE10F0000)) == &GBA_EMUALTOR_ARM7TDMI::MRS,       "MRS r0, CPSR");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE5910004)) == &GBA_EMUALTOR_ARM7TDMI::single_data_tsf<1, 1, 0, 0, 1, OPERAND2_IMM>, "LDR r0, [r1, #4]");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE5610004)) == &GBA_EMUALTOR_ARM7TDMI::single_data_tsf<1, 0, 1, 1, 0, OPERAND2_IMM>, "STRB r0, [r1, #-4]!");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE4D10001)) == &GBA_EMUALTOR_ARM7TDMI::single_data_tsf<0, 1, 1, 0, 1, OPERAND2_IMM>, "LDRB r0, [r1], #1");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE7910102)) == &GBA_EMUALTOR_ARM7TDMI::single_data_tsf<1, 1, 0, 0, 1, OPERAND2_LLI>, "LDR r0, [r1, r2, LSL #2]");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE6A10122)) == &GBA_EMUALTOR_ARM7TDMI::single_data_tsf<0, 1, 0, 1, 0, OPERAND2_LRI>, "STRT r0, [r1], r2, LSR #2");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE1D100B2)) == &GBA_EMUALTOR_ARM7TDMI::halfword_data_tsf<1, 1, 1, 0, 1, 1>, "LDRH r0, [r1, #2]");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE16100B4)) == &GBA_EMUALTOR_ARM7TDMI::halfword_data_tsf<1, 0, 1, 1, 0, 1>, "STRH r0, [r1, #-4]!");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE01100D2)) == &GBA_EMUALTOR_ARM7TDMI::halfword_data_tsf<0, 0, 0, 0, 1, 2>, "LDRSB r0, [r1], -r2");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE19100F2)) == &GBA_EMUALTOR_ARM7TDMI::halfword_data_tsf<1, 1, 0, 0, 1, 3>, "LDRSH r0, [r1, r2]");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE1020091)) == &GBA_EMUALTOR_ARM7TDMI::SWP,       "SWP r0, r1, [r2]");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE1420091)) == &GBA_EMUALTOR_ARM7TDMI::SWPB,      "SWPB r0, r1, [r2]");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE92D4010)) == &GBA_EMUALTOR_ARM7TDMI::block_data_tsf<1, 0, 0, 1, 0>, "STMFD sp!, {r4, lr}");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE8BD8010)) == &GBA_EMUALTOR_ARM7TDMI::block_data_tsf<0, 1, 0, 1, 1>, "LDMFD sp!, {r4, pc}");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xE8D10003)) == &GBA_EMUALTOR_ARM7TDMI::block_data_tsf<0, 1, 1, 0, 1>, "LDMIA r1, {r0, r1}^");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xEB000000)) == &GBA_EMUALTOR_ARM7TDMI::BL,        "BL");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xED910100)) == &GBA_EMUALTOR_ARM7TDMI::LDC_ofp,   "LDC p1, c0, [r1]");
+static_assert(ARM_DECODER::decode(ARM_DECODER::index_of(0xEF000005)) == &GBA_EMUALTOR_ARM7TDMI::SWI,       "SWI 5");
+
+
+//THUMB decode table generated at compile time.
+//idx = bit[15:6] of the halfword, every format's opcode bits are in there
+struct THUMB_DECODER
+{
+    typedef GBA_EMUALTOR_ARM7TDMI                      CPU;
+    typedef GBA_EMUALTOR_ARM7TDMI::THUMB_HANDLER       THUMB_HANDLER;
+    typedef GBA_EMUALTOR_ARM7TDMI::THUMB_HANDLER_TABLE THUMB_HANDLER_TABLE;
+
+    //move shifted register, [op], op 3 is add/subtract
+    static constexpr THUMB_HANDLER move_shifted[3] =
+    {
+        &CPU::thumb_move_shifted<LSL>, &CPU::thumb_move_shifted<LSR>, &CPU::thumb_move_shifted<ASR>,
+    };
+
+    //add/subtract, [I:op]
+    static constexpr THUMB_HANDLER add_subtract[4] =
+    {
+        &CPU::thumb_add_subtract<0, 0>, &CPU::thumb_add_subtract<0, 1>,
+        &CPU::thumb_add_subtract<1, 0>, &CPU::thumb_add_subtract<1, 1>,
+    };
+
+    //move/compare/add/subtract immediate, [op]
+    static constexpr THUMB_HANDLER immediate[4] =
+    {
+        &CPU::thumb_immediate<THUMB_IMM_MOV>, &CPU::thumb_immediate<THUMB_IMM_CMP>,
+        &CPU::thumb_immediate<THUMB_IMM_ADD>, &CPU::thumb_immediate<THUMB_IMM_SUB>,
+    };
+
+    //ALU operations, [op]
+    static constexpr THUMB_HANDLER alu[16] =
+    {
+        &CPU::thumb_alu<THUMB_ALU_AND>, &CPU::thumb_alu<THUMB_ALU_EOR>, &CPU::thumb_alu<THUMB_ALU_LSL>, &CPU::thumb_alu<THUMB_ALU_LSR>,
+        &CPU::thumb_alu<THUMB_ALU_ASR>, &CPU::thumb_alu<THUMB_ALU_ADC>, &CPU::thumb_alu<THUMB_ALU_SBC>, &CPU::thumb_alu<THUMB_ALU_ROR>,
+        &CPU::thumb_alu<THUMB_ALU_TST>, &CPU::thumb_alu<THUMB_ALU_NEG>, &CPU::thumb_alu<THUMB_ALU_CMP>, &CPU::thumb_alu<THUMB_ALU_CMN>,
+        &CPU::thumb_alu<THUMB_ALU_ORR>, &CPU::thumb_alu<THUMB_ALU_MUL>, &CPU::thumb_alu<THUMB_ALU_BIC>, &CPU::thumb_alu<THUMB_ALU_MVN>,
+    };
+
+    //hi register operations/branch exchange, [op:H1:H2]
+#define HI_REGISTER_ROW(OP)                                                                             \
+        &CPU::thumb_hi_register<OP, 0, 0>, &CPU::thumb_hi_register<OP, 0, 1>,                           \
+        &CPU::thumb_hi_register<OP, 1, 0>, &CPU::thumb_hi_register<OP, 1, 1>
+
+    static constexpr THUMB_HANDLER hi_register[16] =
+    {
+        HI_REGISTER_ROW(THUMB_HI_ADD),
+        HI_REGISTER_ROW(THUMB_HI_CMP),
+        HI_REGISTER_ROW(THUMB_HI_MOV),
+        HI_REGISTER_ROW(THUMB_HI_BX),
+    };
+
+#undef HI_REGISTER_ROW
+
+    //load/store with register offset, [L:B]
+    static constexpr THUMB_HANDLER register_offset[4] =
+    {
+        &CPU::thumb_register_offset<0, 0>, &CPU::thumb_register_offset<0, 1>,
+        &CPU::thumb_register_offset<1, 0>, &CPU::thumb_register_offset<1, 1>,
+    };
+
+    //load/store sign-extended byte/halfword, [H:S]
+    static constexpr THUMB_HANDLER sign_extended[4] =
+    {
+        &CPU::thumb_sign_extended<0, 0>, &CPU::thumb_sign_extended<0, 1>,
+        &CPU::thumb_sign_extended<1, 0>, &CPU::thumb_sign_extended<1, 1>,
+    };
+
+    //load/store with immediate offset, [B:L]
+    static constexpr THUMB_HANDLER immediate_offset[4] =
+    {
+        &CPU::thumb_immediate_offset<0, 0>, &CPU::thumb_immediate_offset<0, 1>,
+        &CPU::thumb_immediate_offset<1, 0>, &CPU::thumb_immediate_offset<1, 1>,
+    };
+
+    //push/pop registers, [L:R]
+    static constexpr THUMB_HANDLER push_pop[4] =
+    {
+        &CPU::thumb_push_pop<0, 0>, &CPU::thumb_push_pop<0, 1>,
+        &CPU::thumb_push_pop<1, 0>, &CPU::thumb_push_pop<1, 1>,
+    };
+
+    //conditional branch, [cond], 0xE is undefined and 0xF SWI
+    static constexpr THUMB_HANDLER conditional_branch[14] =
+    {
+        &CPU::thumb_conditional_branch<COND_EQ>, &CPU::thumb_conditional_branch<COND_NE>,
+        &CPU::thumb_conditional_branch<COND_CS>, &CPU::thumb_conditional_branch<COND_CC>,
+        &CPU::thumb_conditional_branch<COND_MI>, &CPU::thumb_conditional_branch<COND_PL>,
+        &CPU::thumb_conditional_branch<COND_VS>, &CPU::thumb_conditional_branch<COND_VC>,
+        &CPU::thumb_conditional_branch<COND_HI>, &CPU::thumb_conditional_branch<COND_LS>,
+        &CPU::thumb_conditional_branch<COND_GE>, &CPU::thumb_conditional_branch<COND_LT>,
+        &CPU::thumb_conditional_branch<COND_GT>, &CPU::thumb_conditional_branch<COND_LE>,
+    };
+
+
+    static constexpr THUMB_HANDLER decode(U32 idx)
+    {
+        U32 bit_15_12 = idx >> 6;
+        U32 bit_11    = (idx >> 5) & 0x1;
+        U32 bit_10    = (idx >> 4) & 0x1;
+
+        switch (bit_15_12)
+        {
+            case 0x0:
+            case 0x1:
+                //op 3 of move shifted register is add/subtract
+                if (((idx >> 5) & 0x3) == 0x3)
+                {
+                    return add_subtract[(idx >> 3) & 0x3];
+                }
+                return move_shifted[(idx >> 5) & 0x3];
+            case 0x2:
+            case 0x3:
+                return immediate[(idx >> 5) & 0x3];
+            case 0x4:
+                if (bit_11)
+                {
+                    return &CPU::thumb_pc_load;
+                }
+                return bit_10 ? hi_register[idx & 0xF] : alu[idx & 0xF];
+            case 0x5:
+                //bit 9 splits register offset from sign-extended
+                if (idx & BIT(3))
+                {
+                    return sign_extended[(bit_11 << 1) | bit_10];
+                }
+                return register_offset[(bit_11 << 1) | bit_10];
+            case 0x6:
+            case 0x7:
+                return immediate_offset[((idx >> 5) & 0x2) | bit_11];
+            case 0x8:
+                return bit_11 ? &CPU::thumb_halfword<1> : &CPU::thumb_halfword<0>;
+            case 0x9:
+                return bit_11 ? &CPU::thumb_sp_relative<1> : &CPU::thumb_sp_relative<0>;
+            case 0xA:
+                return bit_11 ? &CPU::thumb_load_address<1> : &CPU::thumb_load_address<0>;
+            case 0xB:
+                //1011 0000 : add offset to SP, 1011 L10R : push/pop, the rest is undefined
+                if ((idx & 0x3FC) == 0x2C0)
+                {
+                    return (idx & BIT(1)) ? &CPU::thumb_add_sp<1> : &CPU::thumb_add_sp<0>;
+                }
+                if (((idx >> 3) & 0x3) == 0x2)
+                {
+                    return push_pop[(bit_11 << 1) | ((idx >> 2) & 0x1)];
+                }
+                return &CPU::thumb_UND;
+            case 0xC:
+                return bit_11 ? &CPU::thumb_multiple<1> : &CPU::thumb_multiple<0>;
+            case 0xD:
+                switch ((idx >> 2) & 0xF)
+                {
+                    case 0xE: return &CPU::thumb_UND;
+                    case 0xF: return &CPU::thumb_SWI;
+                    default:  return conditional_branch[(idx >> 2) & 0xF];
+                }
+            case 0xE:
+                return bit_11 ? &CPU::thumb_UND : &CPU::thumb_B;
+            default:
+                return bit_11 ? &CPU::thumb_BL<1> : &CPU::thumb_BL<0>;
+        }
+    }
+
+    static constexpr THUMB_HANDLER_TABLE build_table()
+    {
+        THUMB_HANDLER_TABLE table = {};
+
+        for (U32 idx = 0; idx < 1024; idx++)
+        {
+            table.handler[idx] = decode(idx);
+        }
+        return table;
+    }
+
+
+    //-----------------//
+    //-- self check  --//
+    //-----------------//
+
+    //instruction set formats in the order of the data sheet (figure 5-1)
+    enum THUMB_FORMAT
+    {
+        FMT_MOVE_SHIFTED,
+        FMT_ADD_SUBTRACT,
+        FMT_IMMEDIATE,
+        FMT_ALU,
+        FMT_HI_REGISTER,
+        FMT_PC_LOAD,
+        FMT_REGISTER_OFFSET,
+        FMT_SIGN_EXTENDED,
+        FMT_IMMEDIATE_OFFSET,
+        FMT_HALFWORD,
+        FMT_SP_RELATIVE,
+        FMT_LOAD_ADDRESS,
+        FMT_ADD_SP,
+        FMT_PUSH_POP,
+        FMT_MULTIPLE,
+        FMT_CONDITIONAL_BRANCH,
+        FMT_SW_INT,
+        FMT_BRANCH,
+        FMT_LONG_BRANCH,
+        FMT_UNDEFINED,
+    };
+
+    typedef struct thumb_format_pattern
+    {
+        U32 mask;
+        U32 value;
+        THUMB_FORMAT format;
+    }THUMB_FORMAT_PATTERN;
+
+    //on idx, the halfword's bit[15:6], first match wins
+    static constexpr THUMB_FORMAT_PATTERN format_patterns[] =
+    {
+        { 0x3E0, 0x060, FMT_ADD_SUBTRACT        },  //0001 1IOp ..
+        { 0x380, 0x000, FMT_MOVE_SHIFTED        },  //000O p... ..
+        { 0x380, 0x080, FMT_IMMEDIATE           },  //001O p... ..
+        { 0x3F0, 0x100, FMT_ALU                 },  //0100 00Op Op
+        { 0x3F0, 0x110, FMT_HI_REGISTER         },  //0100 01Op HH
+        { 0x3E0, 0x120, FMT_PC_LOAD             },  //0100 1... ..
+        { 0x3C8, 0x140, FMT_REGISTER_OFFSET     },  //0101 LB0. ..
+        { 0x3C8, 0x148, FMT_SIGN_EXTENDED       },  //0101 HS1. ..
+        { 0x380, 0x180, FMT_IMMEDIATE_OFFSET    },  //011B L... ..
+        { 0x3C0, 0x200, FMT_HALFWORD            },  //1000 L... ..
+        { 0x3C0, 0x240, FMT_SP_RELATIVE         },  //1001 L... ..
+        { 0x3C0, 0x280, FMT_LOAD_ADDRESS        },  //1010 S... ..
+        { 0x3FC, 0x2C0, FMT_ADD_SP              },  //1011 0000 S.
+        { 0x3D8, 0x2D0, FMT_PUSH_POP            },  //1011 L10R ..
+        { 0x3C0, 0x2C0, FMT_UNDEFINED           },  //1011 .... ..
+        { 0x3C0, 0x300, FMT_MULTIPLE            },  //1100 L... ..
+        { 0x3FC, 0x378, FMT_UNDEFINED           },  //1101 1110 ..
+        { 0x3FC, 0x37C, FMT_SW_INT              },  //1101 1111 ..
+        { 0x3C0, 0x340, FMT_CONDITIONAL_BRANCH  },  //1101 Cond ..
+        { 0x3E0, 0x380, FMT_BRANCH              },  //1110 0... ..
+        { 0x3C0, 0x3C0, FMT_LONG_BRANCH         },  //1111 H... ..
+    };
+
+    static constexpr THUMB_FORMAT classify(U32 idx)
+    {
+        for (const THUMB_FORMAT_PATTERN &pattern : format_patterns)
+        {
+            if ((idx & pattern.mask) == pattern.value)
+            {
+                return pattern.format;
+            }
+        }
+        return FMT_UNDEFINED;
+    }
+
+    //expected handler from the format and its own fields
+    static constexpr THUMB_HANDLER expected_handler(U32 idx)
+    {
+        U32 halfword = idx << 6;
+
+        switch (classify(idx))
+        {
+            case FMT_ADD_SUBTRACT:       return add_subtract[(THUMB_ADD_SUBTRACT::I(halfword) << 1) | THUMB_ADD_SUBTRACT::op(halfword)];
+            case FMT_MOVE_SHIFTED:       return move_shifted[THUMB_MOVE_SHIFTED::op(halfword)];
+            case FMT_IMMEDIATE:          return immediate[THUMB_IMMEDIATE::op(halfword)];
+            case FMT_ALU:                return alu[THUMB_ALU::op(halfword)];
+            case FMT_HI_REGISTER:        return hi_register[(THUMB_HI_REGISTER::op(halfword) << 2) | (THUMB_HI_REGISTER::H1(halfword) << 1) | THUMB_HI_REGISTER::H2(halfword)];
+            case FMT_PC_LOAD:            return &CPU::thumb_pc_load;
+            case FMT_REGISTER_OFFSET:    return register_offset[(halfword >> 10) & 0x3];
+            case FMT_SIGN_EXTENDED:      return sign_extended[(halfword >> 10) & 0x3];
+            case FMT_IMMEDIATE_OFFSET:   return immediate_offset[(halfword >> 11) & 0x3];
+            case FMT_HALFWORD:           return (halfword & BIT(11)) ? &CPU::thumb_halfword<1> : &CPU::thumb_halfword<0>;
+            case FMT_SP_RELATIVE:        return (halfword & BIT(11)) ? &CPU::thumb_sp_relative<1> : &CPU::thumb_sp_relative<0>;
+            case FMT_LOAD_ADDRESS:       return (halfword & BIT(11)) ? &CPU::thumb_load_address<1> : &CPU::thumb_load_address<0>;
+            case FMT_ADD_SP:             return THUMB_ADD_SP::S(halfword) ? &CPU::thumb_add_sp<1> : &CPU::thumb_add_sp<0>;
+            case FMT_PUSH_POP:           return push_pop[((halfword >> 10) & 0x2) | ((halfword >> 8) & 0x1)];
+            case FMT_MULTIPLE:           return (halfword & BIT(11)) ? &CPU::thumb_multiple<1> : &CPU::thumb_multiple<0>;
+            case FMT_SW_INT:             return &CPU::thumb_SWI;
+            case FMT_CONDITIONAL_BRANCH: return conditional_branch[THUMB_CONDITIONAL_BRANCH::cond(halfword)];
+            case FMT_BRANCH:             return &CPU::thumb_B;
+            case FMT_LONG_BRANCH:        return THUMB_LONG_BRANCH::H(halfword) ? &CPU::thumb_BL<1> : &CPU::thumb_BL<0>;
+            default:                     return &CPU::thumb_UND;
+        }
+    }
+
+    static constexpr bool verify_table(const THUMB_HANDLER_TABLE &table)
+    {
+        for (U32 idx = 0; idx < 1024; idx++)
+        {
+            if (table.handler[idx] == nullptr || table.handler[idx] != expected_handler(idx))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //index of an encoded halfword
+    static constexpr U32 index_of(U32 instruction)
+    {
+        return (instruction >> 6) & 0x3FF;
+    }
+};
+
+
+//spot checks of the format layouts against assembled halfwords
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x0088)) == &GBA_EMUALTOR_ARM7TDMI::thumb_move_shifted<LSL>,                 "LSL r0, r1, #2");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x1048)) == &GBA_EMUALTOR_ARM7TDMI::thumb_move_shifted<ASR>,                 "ASR r0, r1, #1");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x1888)) == &GBA_EMUALTOR_ARM7TDMI::thumb_add_subtract<0, 0>,                "ADD r0, r1, r2");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x1E48)) == &GBA_EMUALTOR_ARM7TDMI::thumb_add_subtract<1, 1>,                "SUB r0, r1, #1");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x2801)) == &GBA_EMUALTOR_ARM7TDMI::thumb_immediate<THUMB_IMM_CMP>,          "CMP r0, #1");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x4348)) == &GBA_EMUALTOR_ARM7TDMI::thumb_alu<THUMB_ALU_MUL>,                "MUL r0, r1");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x4770)) == &GBA_EMUALTOR_ARM7TDMI::thumb_hi_register<THUMB_HI_BX, 0, 1>,    "BX lr");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x46F7)) == &GBA_EMUALTOR_ARM7TDMI::thumb_hi_register<THUMB_HI_MOV, 1, 1>,   "MOV pc, lr");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x4801)) == &GBA_EMUALTOR_ARM7TDMI::thumb_pc_load,                           "LDR r0, [pc, #4]");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x5C88)) == &GBA_EMUALTOR_ARM7TDMI::thumb_register_offset<1, 1>,             "LDRB r0, [r1, r2]");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x5E88)) == &GBA_EMUALTOR_ARM7TDMI::thumb_sign_extended<1, 1>,               "LDSH r0, [r1, r2]");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x6048)) == &GBA_EMUALTOR_ARM7TDMI::thumb_immediate_offset<0, 0>,            "STR r0, [r1, #4]");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x7848)) == &GBA_EMUALTOR_ARM7TDMI::thumb_immediate_offset<1, 1>,            "LDRB r0, [r1, #1]");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x8848)) == &GBA_EMUALTOR_ARM7TDMI::thumb_halfword<1>,                       "LDRH r0, [r1, #2]");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0x9001)) == &GBA_EMUALTOR_ARM7TDMI::thumb_sp_relative<0>,                    "STR r0, [sp, #4]");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0xA801)) == &GBA_EMUALTOR_ARM7TDMI::thumb_load_address<1>,                   "ADD r0, sp, #4");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0xB082)) == &GBA_EMUALTOR_ARM7TDMI::thumb_add_sp<1>,                         "SUB sp, #8");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0xB510)) == &GBA_EMUALTOR_ARM7TDMI::thumb_push_pop<0, 1>,                    "PUSH {r4, lr}");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0xBD10)) == &GBA_EMUALTOR_ARM7TDMI::thumb_push_pop<1, 1>,                    "POP {r4, pc}");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0xC806)) == &GBA_EMUALTOR_ARM7TDMI::thumb_multiple<1>,                       "LDMIA r0!, {r1, r2}");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0xD1FB)) == &GBA_EMUALTOR_ARM7TDMI::thumb_conditional_branch<COND_NE>,       "BNE");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0xDF05)) == &GBA_EMUALTOR_ARM7TDMI::thumb_SWI,                               "SWI 5");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0xE7FE)) == &GBA_EMUALTOR_ARM7TDMI::thumb_B,                                 "B .");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0xF000)) == &GBA_EMUALTOR_ARM7TDMI::thumb_BL<0>,                             "BL, high half");
+static_assert(THUMB_DECODER::decode(THUMB_DECODER::index_of(0xF803)) == &GBA_EMUALTOR_ARM7TDMI::thumb_BL<1>,                             "BL, low half");
@@ -0,0 +1,1328 @@
+#include <stddef.h>
+#include "arm7tdmi_jit.hpp"
+
+#if GBA_JIT
+#include <sys/mman.h>
+#endif
+
+
+typedef GBA_EMUALTOR_ARM7TDMI_JIT JIT;
+
+
+GBA_EMUALTOR_ARM7TDMI_JIT::GBA_EMUALTOR_ARM7TDMI_JIT(CPU *cpu, bool background, U32 hot_threshold)
+{
+    this->cpu = cpu;
+    this->code_buffer = NULL;
+    this->code_used = 0;
+    this->background = background;
+    this->hot_threshold = hot_threshold;
+    this->compiled_blocks = 0;
+    this->native_instructions = 0;
+    this->fallback_instructions = 0;
+    this->flushes = 0;
+    this->queued = 0;
+    this->installed = 0;
+    this->discarded = 0;
+    this->chain_hits = 0;
+    this->lookup_hits = 0;
+    this->chains = 0;
+    this->unchains = 0;
+    this->target_cycles = 0;
+
+    for (U32 i = 0; i < JIT_LOOKUP_SIZE; i++)
+    {
+        this->lookup[i].pc = BLOCK_INVALID;
+        this->lookup[i].code = NULL;
+    }
+
+#if GBA_JIT
+    this->completed_ready = false;
+    this->compiling = false;
+    this->flush_pending = false;
+    this->stop = false;
+
+    if (std::thread::hardware_concurrency() <= 1)
+    {
+        this->background = false;
+    }
+
+    void *buffer = mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (buffer == MAP_FAILED)
+    {
+        printf("jit : mmap of %u bytes failed, running the interpreter\n", JIT_CODE_SIZE);
+        return;
+    }
+    this->code_buffer = (U8*)buffer;
+    this->cpu->block_drop_hook = block_dropped;
+    this->cpu->block_drop_context = this;
+
+    if (this->background)
+    {
+        this->worker = std::thread(&GBA_EMUALTOR_ARM7TDMI_JIT::worker_main, this);
+    }
+#endif
+}
+
+GBA_EMUALTOR_ARM7TDMI_JIT::~GBA_EMUALTOR_ARM7TDMI_JIT()
+{
+#if GBA_JIT
+    if (this->worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            this->stop = true;
+        }
+        this->wake.notify_one();
+        this->worker.join();
+    }
+
+    for (COMPILE_REQUEST *request : this->queue)
+    {
+        delete request;
+    }
+    for (COMPILE_REQUEST *request : this->completed)
+    {
+        delete request;
+    }
+
+    if (this->code_buffer)
+    {
+        //the block cache outlives the code
+        if (this->cpu->block_drop_context == this)
+        {
+            this->cpu->block_drop_hook = NULL;
+            this->cpu->block_drop_context = NULL;
+        }
+        for (U32 i = 0; i < BLOCK_CACHE_SIZE; i++)
+        {
+            this->cpu->block_cache.blocks[i].code = NULL;
+        }
+        munmap(this->code_buffer, JIT_CODE_SIZE);
+    }
+#endif
+}
+
+
+#if !GBA_JIT
+
+void GBA_EMUALTOR_ARM7TDMI_JIT::flush()
+{
+    for (U32 i = 0; i < BLOCK_CACHE_SIZE; i++)
+    {
+        this->cpu->block_cache.blocks[i].code = NULL;
+    }
+    this->code_used = 0;
+    this->flushes++;
+}
+
+void GBA_EMUALTOR_ARM7TDMI_JIT::run(U32 cycle_budget)
+{
+    this->cpu->run(cycle_budget);
+}
+
+void GBA_EMUALTOR_ARM7TDMI_JIT::block_dropped(void *context, BLOCK *block)
+{
+}
+
+#else
+
+//x86-64 registers, rbx holds the CPU pointer in generated code and r12 the
+//address of block transfers, both callee saved so they survive the helpers
+#define X86_EAX         (0)
+#define X86_ECX         (1)
+#define X86_EDX         (2)
+#define X86_EBX         (3)
+#define X86_ESI         (6)
+#define X86_EDI         (7)
+
+//condition codes, jcc rel32 is 0F 80+cc, setcc is 0F 90+cc
+#define X86_CC_O        (0x0)
+#define X86_CC_C        (0x2)
+#define X86_CC_NC       (0x3)
+#define X86_CC_Z        (0x4)
+#define X86_CC_NZ       (0x5)
+#define X86_CC_S        (0x8)
+#define X86_CC_NS       (0x9)
+#define X86_CC_LE       (0xE)
+
+//op r/m32, r32
+#define X86_ADD         (0x01)
+#define X86_OR          (0x09)
+#define X86_ADC         (0x11)
+#define X86_SBB         (0x19)
+#define X86_AND         (0x21)
+#define X86_SUB         (0x29)
+#define X86_XOR         (0x31)
+#define X86_MOV_STORE   (0x89)
+//op r32, r/m32
+#define X86_XOR_LOAD    (0x33)
+#define X86_MOV_LOAD    (0x8B)
+
+//81 /n id
+#define X86_GROUP1_ADD  (0x0)
+#define X86_GROUP1_AND  (0x4)
+#define X86_GROUP1_SUB  (0x5)
+
+//C1 /n ib, indexed by the ARM shift type LSL, LSR, ASR, ROR
+static const U32 x86_shift[4] = { 0x4, 0x5, 0x7, 0x1 };
+
+#define CPU_OFFSET(member)  ((U32)offsetof(GBA_EMUALTOR_ARM7TDMI, member))
+#define OFFSET_R(n)         (CPU_OFFSET(R) + (n) * 4)
+
+
+//called from generated code, rdi = CPU
+static void jit_interpret(JIT::CPU *cpu, JIT::BLOCK_INSTRUCTION *entry)
+{
+    (cpu->*entry->handler)(&entry->instruction);
+}
+
+//unaligned LDR rotates the addressed byte into bit[7:0]. the helpers charge
+//the wait states of the access like the interpreter handlers
+static U32 jit_load_word(JIT::CPU *cpu, U32 address)
+{
+    U32 value  = cpu->memory.read<U32>(address);
+    U32 rotate = (address & 0x3) * 8;
+
+    cpu->cycles += cpu->memory.waits<U32>(address);
+    return (value >> rotate) | (value << ((32 - rotate) & 0x1F));
+}
+
+static U32 jit_load_byte(JIT::CPU *cpu, U32 address)
+{
+    cpu->cycles += cpu->memory.waits<U8>(address);
+    return cpu->memory.read<U8>(address);
+}
+
+static void jit_store_word(JIT::CPU *cpu, U32 address, U32 value)
+{
+    cpu->memory.write<U32>(address, value);
+    cpu->cycles += cpu->memory.waits<U32>(address);
+}
+
+static void jit_store_byte(JIT::CPU *cpu, U32 address, U32 value)
+{
+    cpu->memory.write<U8>(address, (U8)value);
+    cpu->cycles += cpu->memory.waits<U8>(address);
+}
+
+
+//data processing without PSR transfers, register specified shifts or Rd = R15,
+//single data transfers without Rd = R15 loads, block data transfers without
+//the S bit or R15 loads, and branches
+static bool compiles_natively(U32 instruction)
+{
+    U32 shift_type = ARM_DATA_PROC::shift_type(instruction);
+    U32 amount     = ARM_DATA_PROC::shift_amount(instruction);
+    U32 Rd         = ARM_DATA_PROC::Rd(instruction);
+    U32 Rn         = ARM_DATA_PROC::Rn(instruction);
+
+    switch (ARM_INSTRUCTION::group(instruction))
+    {
+        case 0x0:
+            //multiply, swap, halfword transfer, shift by register, and LSR #32 / ASR #32 / RRX
+            if (((instruction & 0x90) == 0x90) || (instruction & BIT(4)) || (shift_type != 0 && amount == 0))
+            {
+                return false;
+            }
+            //fall through
+        case 0x1:
+            //opcode TST..CMN with S clear : MRS, MSR, BX, swap
+            if ((ARM_DATA_PROC::opcode(instruction) >> 2) == 0x2 && !ARM_DATA_PROC::S(instruction))
+            {
+                return false;
+            }
+            return Rd != 15;
+        case 0x2:
+        case 0x3:
+            if (ARM_SINGLE_TRANSFER::I(instruction) && ((instruction & BIT(4)) || (shift_type != 0 && amount == 0)))
+            {
+                return false;
+            }
+            if (Rn == 15 && (!ARM_SINGLE_TRANSFER::P(instruction) || ARM_SINGLE_TRANSFER::W(instruction)))
+            {
+                return false;
+            }
+            return !(ARM_SINGLE_TRANSFER::L(instruction) && Rd == 15);
+        case 0x4:
+            if (ARM_BLOCK_TRANSFER::S(instruction) || Rn == 15 || ARM_BLOCK_TRANSFER::register_list(instruction) == 0)
+            {
+                return false;
+            }
+            return !(ARM_BLOCK_TRANSFER::L(instruction) && (instruction & BIT(15)));
+        case 0x5:
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+//-------------//
+//-- emitter --//
+//-------------//
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit8(U8 value)
+{
+    *this->emit_ptr++ = value;
+}
+
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit32(U32 value)
+{
+    for (U32 i = 0; i < 4; i++)
+    {
+        emit8((U8)(value >> (i * 8)));
+    }
+}
+
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit64(unsigned long long value)
+{
+    emit32((U32)value);
+    emit32((U32)(value >> 32));
+}
+
+//opcode reg, [rbx + offset], disp8 for the hot state in the first two cache lines
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_cpu_operand(U8 opcode, U32 reg, U32 offset)
+{
+    emit8(opcode);
+    if (offset < 0x80)
+    {
+        emit8(0x40 | (reg << 3) | X86_EBX);
+        emit8((U8)offset);
+        return;
+    }
+    emit8(0x80 | (reg << 3) | X86_EBX);
+    emit32(offset);
+}
+
+//mov dword [rbx + offset], value
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_store_imm(U32 offset, U32 value)
+{
+    emit_cpu_operand(0xC7, 0, offset);
+    emit32(value);
+}
+
+//add dword [rbx + offset], value
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_add_imm(U32 offset, U32 value)
+{
+    emit_cpu_operand(0x81, X86_GROUP1_ADD, offset);
+    emit32(value);
+}
+
+//cmp dword [rbx + offset], value
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_cmp_imm(U32 offset, U8 value)
+{
+    emit_cpu_operand(0x83, 7, offset);
+    emit8(value);
+}
+
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_mov_imm(U32 reg, U32 value)
+{
+    emit8(0xB8 + reg);
+    emit32(value);
+}
+
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_alu(U8 opcode, U32 dst, U32 src)
+{
+    emit8(opcode);
+    emit8(0xC0 | (src << 3) | dst);
+}
+
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_alu_imm(U32 extension, U32 reg, U32 value)
+{
+    emit8(0x81);
+    emit8(0xC0 | (extension << 3) | reg);
+    emit32(value);
+}
+
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_shift(U32 extension, U32 reg, U32 amount)
+{
+    emit8(0xC1);
+    emit8(0xC0 | (extension << 3) | reg);
+    emit8((U8)amount);
+}
+
+//reg = 1 when cc holds, else 0
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_flag(U32 cc, U32 reg)
+{
+    emit8(0x0F);
+    emit8(0x90 + cc);
+    emit8(0xC0 | reg);
+    emit8(0x0F);
+    emit8(0xB6);
+    emit8(0xC0 | (reg << 3) | reg);
+}
+
+//reg = R[arm_reg], R15 reads as pc_value
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_load_arm_reg(U32 reg, U32 arm_reg, U32 pc_value)
+{
+    if (arm_reg == 15)
+    {
+        emit_mov_imm(reg, pc_value);
+    }
+    else
+    {
+        emit_cpu_operand(X86_MOV_LOAD, reg, OFFSET_R(arm_reg));
+    }
+}
+
+//function(rdi = CPU, rsi, rdx as set up by the caller)
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_call(const void *function)
+{
+    //mov rdi, rbx
+    emit8(0x48);
+    emit8(0x89);
+    emit8(0xDF);
+    //mov rax, function
+    emit8(0x48);
+    emit8(0xB8);
+    emit64((unsigned long long)function);
+    //call rax
+    emit8(0xFF);
+    emit8(0xD0);
+}
+
+//returns where the rel32 goes, see patch_jump()
+U8 *GBA_EMUALTOR_ARM7TDMI_JIT::emit_jcc(U32 cc)
+{
+    U8 *at;
+
+    emit8(0x0F);
+    emit8(0x80 + cc);
+    at = this->emit_ptr;
+    emit32(0);
+    return at;
+}
+
+//point the jump at the current position
+void GBA_EMUALTOR_ARM7TDMI_JIT::patch_jump(U8 *at)
+{
+    U32 rel = (U32)(this->emit_ptr - (at + 4));
+
+    at[0] = (U8)rel;
+    at[1] = (U8)(rel >> 8);
+    at[2] = (U8)(rel >> 16);
+    at[3] = (U8)(rel >> 24);
+}
+
+//leave the block : R15 = next_pc, the first executed instructions are charged 1 cycle each.
+//a chainable exit jumps to the next block once run() has patched its jmp, and
+//returns the address of the jmp's rel32 until then
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_exit(U32 next_pc, U32 executed, bool chainable)
+{
+    U8 *exhausted;
+    U8 *link;
+
+    emit_store_imm(OFFSET_R(15), next_pc);
+    emit_add_imm(CPU_OFFSET(cycles), executed);
+
+    if (!chainable)
+    {
+        //xor eax, eax
+        emit_alu(X86_XOR, X86_EAX, X86_EAX);
+        emit_return();
+        return;
+    }
+
+    emit_budget_check(&exhausted);
+    //jmp rel32, 0 falls through to the return below
+    emit8(0xE9);
+    link = this->emit_ptr;
+    emit32(0);
+    patch_jump(exhausted);
+    //mov rax, link
+    emit8(0x48);
+    emit8(0xB8);
+    emit64((unsigned long long)link);
+    emit_return();
+}
+
+//jumps to exhausted once the cycle budget of run() is used up, clobbers eax
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_budget_check(U8 **exhausted)
+{
+    //mov rax, &target_cycles ; mov eax, [rax]
+    emit8(0x48);
+    emit8(0xB8);
+    emit64((unsigned long long)&this->target_cycles);
+    emit8(0x8B);
+    emit8(0x00);
+    //sub eax, [rbx + cycles] ; test eax, eax
+    emit_cpu_operand(0x2B, X86_EAX, CPU_OFFSET(cycles));
+    emit8(0x85);
+    emit8(0xC0);
+    *exhausted = emit_jcc(X86_CC_LE);
+}
+
+//after an interpreted last instruction : jump to the code for R15 when the
+//lookup table has it, else return to run(). it may have entered THUMB state,
+//which has no compiled code
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_lookup()
+{
+    U8 *miss[3];
+
+    //cmp byte [rbx + thumb], 0
+    emit_cpu_operand(0x80, 7, CPU_OFFSET(thumb));
+    emit8(0x00);
+    miss[2] = emit_jcc(X86_CC_NZ);
+
+    //ecx = (R15 >> 2 & (JIT_LOOKUP_SIZE - 1)) * sizeof(JIT_LOOKUP)
+    emit_cpu_operand(X86_MOV_LOAD, X86_EAX, OFFSET_R(15));
+    emit_alu(X86_MOV_STORE, X86_ECX, X86_EAX);
+    emit_shift(x86_shift[1], X86_ECX, 2);
+    emit_alu_imm(X86_GROUP1_AND, X86_ECX, JIT_LOOKUP_SIZE - 1);
+    emit_shift(x86_shift[0], X86_ECX, 4);
+    //mov rdx, lookup ; cmp [rdx + rcx], eax
+    emit8(0x48);
+    emit8(0xBA);
+    emit64((unsigned long long)this->lookup);
+    emit8(0x39);
+    emit8(0x04);
+    emit8(0x0A);
+    miss[0] = emit_jcc(X86_CC_NZ);
+
+    emit_budget_check(&miss[1]);
+    //mov rax, &lookup_hits ; add dword [rax], 1
+    emit8(0x48);
+    emit8(0xB8);
+    emit64((unsigned long long)&this->lookup_hits);
+    emit8(0x83);
+    emit8(0x00);
+    emit8(0x01);
+    //mov rax, [rdx + rcx + 8] ; jmp rax
+    emit8(0x48);
+    emit8(0x8B);
+    emit8(0x44);
+    emit8(0x0A);
+    emit8(0x08);
+    emit8(0xFF);
+    emit8(0xE0);
+
+    patch_jump(miss[0]);
+    patch_jump(miss[1]);
+    patch_jump(miss[2]);
+    emit_alu(X86_XOR, X86_EAX, X86_EAX);
+    emit_return();
+}
+
+//pop r12, pop rbp, pop rbx, ret
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_return()
+{
+    emit8(0x41);
+    emit8(0x5C);
+    emit8(0x5D);
+    emit8(0x5B);
+    emit8(0xC3);
+}
+
+
+//jumps over the instruction when cond fails, returns how many jumps were
+//written to skip. same tests as condition_table, on the lazy flag words
+U32 GBA_EMUALTOR_ARM7TDMI_JIT::emit_condition(U32 cond, U8 **skip)
+{
+    const U32 result   = CPU_OFFSET(flags.result);
+    const U32 zero     = CPU_OFFSET(flags.zero);
+    const U32 carry    = CPU_OFFSET(flags.carry);
+    const U32 overflow = CPU_OFFSET(flags.overflow);
+    U8 *execute;
+
+    switch (cond)
+    {
+        case 0x0:   //EQ
+            emit_cmp_imm(zero, 0);
+            skip[0] = emit_jcc(X86_CC_NZ);
+            return 1;
+        case 0x1:   //NE
+            emit_cmp_imm(zero, 0);
+            skip[0] = emit_jcc(X86_CC_Z);
+            return 1;
+        case 0x2:   //CS
+            emit_cmp_imm(carry, 0);
+            skip[0] = emit_jcc(X86_CC_Z);
+            return 1;
+        case 0x3:   //CC
+            emit_cmp_imm(carry, 0);
+            skip[0] = emit_jcc(X86_CC_NZ);
+            return 1;
+        case 0x4:   //MI
+            emit_cmp_imm(result, 0);
+            skip[0] = emit_jcc(X86_CC_NS);
+            return 1;
+        case 0x5:   //PL
+            emit_cmp_imm(result, 0);
+            skip[0] = emit_jcc(X86_CC_S);
+            return 1;
+        case 0x6:   //VS
+            emit_cmp_imm(overflow, 0);
+            skip[0] = emit_jcc(X86_CC_NS);
+            return 1;
+        case 0x7:   //VC
+            emit_cmp_imm(overflow, 0);
+            skip[0] = emit_jcc(X86_CC_S);
+            return 1;
+        case 0x8:   //HI : C set and Z clear
+            emit_cmp_imm(carry, 0);
+            skip[0] = emit_jcc(X86_CC_Z);
+            emit_cmp_imm(zero, 0);
+            skip[1] = emit_jcc(X86_CC_Z);
+            return 2;
+        case 0x9:   //LS : C clear or Z set
+            emit_cmp_imm(carry, 0);
+            execute = emit_jcc(X86_CC_Z);
+            emit_cmp_imm(zero, 0);
+            skip[0] = emit_jcc(X86_CC_NZ);
+            patch_jump(execute);
+            return 1;
+        case 0xA:   //GE : N equals V, bit 31 of result ^ overflow clear
+        case 0xB:   //LT
+            emit_cpu_operand(X86_MOV_LOAD, X86_EAX, result);
+            emit_cpu_operand(X86_XOR_LOAD, X86_EAX, overflow);
+            skip[0] = emit_jcc((cond == 0xA) ? X86_CC_S : X86_CC_NS);
+            return 1;
+        case 0xC:   //GT : Z clear and N equals V
+            emit_cmp_imm(zero, 0);
+            skip[0] = emit_jcc(X86_CC_Z);
+            emit_cpu_operand(X86_MOV_LOAD, X86_EAX, result);
+            emit_cpu_operand(X86_XOR_LOAD, X86_EAX, overflow);
+            skip[1] = emit_jcc(X86_CC_S);
+            return 2;
+        case 0xD:   //LE : Z set or N not equal to V
+            emit_cmp_imm(zero, 0);
+            execute = emit_jcc(X86_CC_Z);
+            emit_cpu_operand(X86_MOV_LOAD, X86_EAX, result);
+            emit_cpu_operand(X86_XOR_LOAD, X86_EAX, overflow);
+            skip[0] = emit_jcc(X86_CC_NS);
+            patch_jump(execute);
+            return 1;
+        default:    //NV
+            emit8(0xE9);
+            skip[0] = this->emit_ptr;
+            emit32(0);
+            return 1;
+    }
+}
+
+//a store may have hit the block being executed, leave it when it was invalidated
+void GBA_EMUALTOR_ARM7TDMI_JIT::emit_invalidation_check(BLOCK *block, U32 pc, U32 next_pc, U32 executed)
+{
+    U8 *valid;
+
+    //mov rax, &block->pc
+    emit8(0x48);
+    emit8(0xB8);
+    emit64((unsigned long long)&block->pc);
+    //cmp dword [rax], block->pc
+    emit8(0x81);
+    emit8(0x38);
+    emit32(pc);
+    valid = emit_jcc(X86_CC_Z);
+    emit_exit(next_pc, executed, false);
+    patch_jump(valid);
+}
+
+
+//eax = operand1, ecx = operand2, edx = shifter carry out
+void GBA_EMUALTOR_ARM7TDMI_JIT::compile_data_proc(U32 instruction, U32 pc)
+{
+    U32 opcode = ARM_DATA_PROC::opcode(instruction);
+    U32 S      = ARM_DATA_PROC::S(instruction);
+    U32 Rn     = ARM_DATA_PROC::Rn(instruction);
+    U32 Rd     = ARM_DATA_PROC::Rd(instruction);
+    bool test       = (opcode >= OPC_TST) && (opcode <= OPC_CMN);
+    bool arithmetic = (opcode >= OPC_SUB && opcode <= OPC_RSC) || opcode == OPC_CMP || opcode == OPC_CMN;
+    bool reverse    = (opcode == OPC_RSB) || (opcode == OPC_RSC);
+    bool shifter_carry = false;
+    bool constant_carry = false;
+    U32 carry_value = 0;
+
+    if (ARM_DATA_PROC::I(instruction))
+    {
+        U32 value = ARM_DATA_PROC::rotated_imm(instruction);
+
+        emit_mov_imm(X86_ECX, value);
+        if (ARM_DATA_PROC::rotate(instruction) != 0)
+        {
+            constant_carry = true;
+            carry_value = value >> 31;
+        }
+    }
+    else
+    {
+        U32 shift_type = ARM_DATA_PROC::shift_type(instruction);
+        U32 amount     = ARM_DATA_PROC::shift_amount(instruction);
+
+        emit_load_arm_reg(X86_ECX, ARM_DATA_PROC::Rm(instruction), pc + 8);
+        if (amount != 0)
+        {
+            if (S && !arithmetic)
+            {
+                //carry out is bit[32 - amount] for LSL, bit[amount - 1] otherwise
+                emit_alu(X86_MOV_STORE, X86_EDX, X86_ECX);
+                emit_shift(x86_shift[1], X86_EDX, (shift_type == 0) ? 32 - amount : amount - 1);
+                emit_alu_imm(X86_GROUP1_AND, X86_EDX, 0x1);
+                shifter_carry = true;
+            }
+            emit_shift(x86_shift[shift_type], X86_ECX, amount);
+        }
+    }
+
+    if (opcode != OPC_MOV && opcode != OPC_MVN)
+    {
+        emit_load_arm_reg(X86_EAX, Rn, pc + 8);
+    }
+
+    switch (opcode)
+    {
+        case OPC_AND:
+        case OPC_TST:
+            emit_alu(X86_AND, X86_EAX, X86_ECX);
+            break;
+        case OPC_EOR:
+        case OPC_TEQ:
+            emit_alu(X86_XOR, X86_EAX, X86_ECX);
+            break;
+        case OPC_SUB:
+        case OPC_CMP:
+            emit_alu(X86_SUB, X86_EAX, X86_ECX);
+            break;
+        case OPC_RSB:
+            emit_alu(X86_SUB, X86_ECX, X86_EAX);
+            break;
+        case OPC_ADD:
+        case OPC_CMN:
+            emit_alu(X86_ADD, X86_EAX, X86_ECX);
+            break;
+        case OPC_ADC:
+            //bt dword [carry], 0 : x86 CF = C
+            emit8(0x0F);
+            emit_cpu_operand(0xBA, 4, CPU_OFFSET(flags.carry));
+            emit8(0);
+            emit_alu(X86_ADC, X86_EAX, X86_ECX);
+            break;
+        case OPC_SBC:
+        case OPC_RSC:
+            //x86 CF = borrow = !C
+            emit_cmp_imm(CPU_OFFSET(flags.carry), 1);
+            if (opcode == OPC_SBC)
+            {
+                emit_alu(X86_SBB, X86_EAX, X86_ECX);
+            }
+            else
+            {
+                emit_alu(X86_SBB, X86_ECX, X86_EAX);
+            }
+            break;
+        case OPC_ORR:
+            emit_alu(X86_OR, X86_EAX, X86_ECX);
+            break;
+        case OPC_MOV:
+            emit_alu(X86_MOV_STORE, X86_EAX, X86_ECX);
+            break;
+        case OPC_BIC:
+            //not ecx
+            emit8(0xF7);
+            emit8(0xD0 | X86_ECX);
+            emit_alu(X86_AND, X86_EAX, X86_ECX);
+            break;
+        default:    //OPC_MVN
+            emit_alu(X86_MOV_STORE, X86_EAX, X86_ECX);
+            emit8(0xF7);
+            emit8(0xD0 | X86_EAX);
+            break;
+    }
+
+    //mov does not touch the x86 flags
+    if (reverse)
+    {
+        emit_alu(X86_MOV_STORE, X86_EAX, X86_ECX);
+    }
+
+    if (S)
+    {
+        if (arithmetic)
+        {
+            //ARM C is the x86 carry for additions and its inverse for subtractions
+            bool add = (opcode == OPC_ADD) || (opcode == OPC_ADC) || (opcode == OPC_CMN);
+
+            emit_flag(add ? X86_CC_C : X86_CC_NC, X86_EDX);
+            emit_flag(X86_CC_O, X86_ECX);
+            emit_shift(x86_shift[0], X86_ECX, 31);
+            emit_cpu_operand(X86_MOV_STORE, X86_EDX, CPU_OFFSET(flags.carry));
+            emit_cpu_operand(X86_MOV_STORE, X86_ECX, CPU_OFFSET(flags.overflow));
+        }
+        else if (shifter_carry)
+        {
+            emit_cpu_operand(X86_MOV_STORE, X86_EDX, CPU_OFFSET(flags.carry));
+        }
+        else if (constant_carry)
+        {
+            emit_store_imm(CPU_OFFSET(flags.carry), carry_value);
+        }
+        emit_cpu_operand(X86_MOV_STORE, X86_EAX, CPU_OFFSET(flags.result));
+        emit_cpu_operand(X86_MOV_STORE, X86_EAX, CPU_OFFSET(flags.zero));
+    }
+
+    if (!test)
+    {
+        emit_cpu_operand(X86_MOV_STORE, X86_EAX, OFFSET_R(Rd));
+    }
+}
+
+//esi = address, edx = value stored, ecx = register offset, eax = loaded value
+void GBA_EMUALTOR_ARM7TDMI_JIT::compile_single_transfer(U32 instruction, U32 pc)
+{
+    U32 P  = ARM_SINGLE_TRANSFER::P(instruction);
+    U32 U  = ARM_SINGLE_TRANSFER::U(instruction);
+    U32 B  = ARM_SINGLE_TRANSFER::B(instruction);
+    U32 W  = ARM_SINGLE_TRANSFER::W(instruction);
+    U32 L  = ARM_SINGLE_TRANSFER::L(instruction);
+    U32 Rn = ARM_SINGLE_TRANSFER::Rn(instruction);
+    U32 Rd = ARM_SINGLE_TRANSFER::Rd(instruction);
+    U32 offset = ARM_SINGLE_TRANSFER::offset(instruction);
+    bool register_offset = ARM_SINGLE_TRANSFER::I(instruction) != 0;
+
+    //a stored R15 is the instruction + 12
+    if (!L)
+    {
+        emit_load_arm_reg(X86_EDX, Rd, pc + 12);
+    }
+
+    emit_load_arm_reg(X86_ESI, Rn, pc + 8);
+    if (register_offset)
+    {
+        U32 shift_type = ARM_SINGLE_TRANSFER::shift_type(instruction);
+        U32 amount     = ARM_SINGLE_TRANSFER::shift_amount(instruction);
+
+        emit_load_arm_reg(X86_ECX, ARM_SINGLE_TRANSFER::Rm(instruction), pc + 8);
+        if (amount != 0)
+        {
+            emit_shift(x86_shift[shift_type], X86_ECX, amount);
+        }
+    }
+
+    if (P)
+    {
+        if (register_offset)
+        {
+            emit_alu(U ? X86_ADD : X86_SUB, X86_ESI, X86_ECX);
+        }
+        else if (offset)
+        {
+            emit_alu_imm(U ? X86_GROUP1_ADD : X86_GROUP1_SUB, X86_ESI, offset);
+        }
+        if (W)
+        {
+            emit_cpu_operand(X86_MOV_STORE, X86_ESI, OFFSET_R(Rn));
+        }
+    }
+    else
+    {
+        //post-indexed always writes back, W selects the user mode (T) variants,
+        //which are the same without an MMU
+        emit_alu(X86_MOV_STORE, X86_EAX, X86_ESI);
+        if (register_offset)
+        {
+            emit_alu(U ? X86_ADD : X86_SUB, X86_EAX, X86_ECX);
+        }
+        else if (offset)
+        {
+            emit_alu_imm(U ? X86_GROUP1_ADD : X86_GROUP1_SUB, X86_EAX, offset);
+        }
+        emit_cpu_operand(X86_MOV_STORE, X86_EAX, OFFSET_R(Rn));
+    }
+
+    //a loaded Rd overrides the written back Rn
+    if (L)
+    {
+        emit_call(B ? (const void*)jit_load_byte : (const void*)jit_load_word);
+        emit_cpu_operand(X86_MOV_STORE, X86_EAX, OFFSET_R(Rd));
+
+        //1S + 1N + 1I
+        emit_add_imm(CPU_OFFSET(cycles), 2);
+    }
+    else
+    {
+        emit_call(B ? (const void*)jit_store_byte : (const void*)jit_store_word);
+
+        //2N
+        emit_add_imm(CPU_OFFSET(cycles), 1);
+    }
+}
+
+//r12 walks the addresses upwards from the lowest one, the lowest register is
+//transferred first
+void GBA_EMUALTOR_ARM7TDMI_JIT::compile_block_transfer(U32 instruction, U32 pc)
+{
+    U32 P  = ARM_BLOCK_TRANSFER::P(instruction);
+    U32 U  = ARM_BLOCK_TRANSFER::U(instruction);
+    U32 W  = ARM_BLOCK_TRANSFER::W(instruction);
+    U32 L  = ARM_BLOCK_TRANSFER::L(instruction);
+    U32 Rn = ARM_BLOCK_TRANSFER::Rn(instruction);
+    U32 list = ARM_BLOCK_TRANSFER::register_list(instruction);
+    U32 count = 0;
+    bool first = true;
+
+    for (U32 i = 0; i < 16; i++)
+    {
+        count += (list >> i) & 0x1;
+    }
+
+    emit_load_arm_reg(X86_ESI, Rn, 0);
+
+    //LDM writes back before loading, so a loaded Rn wins
+    if (W && L)
+    {
+        emit_alu(X86_MOV_STORE, X86_EAX, X86_ESI);
+        emit_alu_imm(U ? X86_GROUP1_ADD : X86_GROUP1_SUB, X86_EAX, count * 4);
+        emit_cpu_operand(X86_MOV_STORE, X86_EAX, OFFSET_R(Rn));
+    }
+
+    //lowest address : IA Rn, IB Rn + 4, DA Rn - 4n + 4, DB Rn - 4n
+    if (U)
+    {
+        if (P)
+        {
+            emit_alu_imm(X86_GROUP1_ADD, X86_ESI, 4);
+        }
+    }
+    else
+    {
+        emit_alu_imm(X86_GROUP1_SUB, X86_ESI, count * 4 - (P ? 0 : 4));
+    }
+    emit_alu_imm(X86_GROUP1_AND, X86_ESI, ~0x3);
+    //mov r12d, esi
+    emit8(0x41);
+    emit8(0x89);
+    emit8(0xF4);
+
+    for (U32 i = 0; i < 16; i++)
+    {
+        if (!((list >> i) & 0x1))
+        {
+            continue;
+        }
+
+        if (!first)
+        {
+            //add r12d, 4
+            emit8(0x41);
+            emit8(0x83);
+            emit8(0xC4);
+            emit8(0x04);
+        }
+        //mov esi, r12d
+        emit8(0x44);
+        emit8(0x89);
+        emit8(0xE6);
+
+        if (L)
+        {
+            emit_call((const void*)jit_load_word);
+            emit_cpu_operand(X86_MOV_STORE, X86_EAX, OFFSET_R(i));
+        }
+        else
+        {
+            emit_load_arm_reg(X86_EDX, i, pc + 12);
+            emit_call((const void*)jit_store_word);
+
+            //STM writes back after the first transfer, only the lowest
+            //register sees the old base
+            if (W && first)
+            {
+                emit_cpu_operand(X86_MOV_LOAD, X86_EAX, OFFSET_R(Rn));
+                emit_alu_imm(U ? X86_GROUP1_ADD : X86_GROUP1_SUB, X86_EAX, count * 4);
+                emit_cpu_operand(X86_MOV_STORE, X86_EAX, OFFSET_R(Rn));
+            }
+        }
+        first = false;
+    }
+
+    //LDM nS + 1N + 1I, STM (n - 1)S + 2N
+    emit_add_imm(CPU_OFFSET(cycles), L ? count + 1 : count);
+}
+
+//B and BL always end the block
+void GBA_EMUALTOR_ARM7TDMI_JIT::compile_branch(U32 instruction, U32 pc, U32 executed)
+{
+    S32 offset = ARM_BRANCH::offset(instruction);
+
+    if (ARM_BRANCH::L(instruction))
+    {
+        emit_store_imm(OFFSET_R(14), pc + 4);
+    }
+
+    //2S + 1N
+    emit_add_imm(CPU_OFFSET(cycles), 2);
+    emit_exit(pc + 8 + offset, executed, true);
+}
+
+
+//prologue, one translation per instruction, then the fall through exit
+void *GBA_EMUALTOR_ARM7TDMI_JIT::compile(BLOCK *block, const BLOCK *source)
+{
+    U8 *code = this->code_buffer + this->code_used;
+    bool last_native = false;
+
+    this->emit_ptr = code;
+
+    //push rbx, push rbp, push r12 (keeps rsp 16 byte aligned for the calls), mov rbx, rdi
+    emit8(0x53);
+    emit8(0x55);
+    emit8(0x41);
+    emit8(0x54);
+    emit8(0x48);
+    emit8(0x89);
+    emit8(0xFB);
+    //jmp over the chained entry (JIT_CHAIN_ENTRY), which counts the hit
+    emit8(0xEB);
+    emit8(0x0D);
+    //mov rax, &chain_hits ; add dword [rax], 1
+    emit8(0x48);
+    emit8(0xB8);
+    emit64((unsigned long long)&this->chain_hits);
+    emit8(0x83);
+    emit8(0x00);
+    emit8(0x01);
+
+    for (U32 i = 0; i < source->length; i++)
+    {
+        const BLOCK_INSTRUCTION *entry = &source->instructions[i];
+        U32 instruction = entry->instruction.val;
+        U32 pc = source->pc + i * 4;
+        U32 cond = ARM_INSTRUCTION::cond(instruction);
+        U8 *skip[2];
+        U32 skips = 0;
+
+        last_native = compiles_natively(instruction);
+
+        //handlers expect R15 = instruction + 4, and may move it
+        if (!last_native)
+        {
+            emit_store_imm(OFFSET_R(15), pc + 4);
+        }
+
+        if (cond != 0xE)    //AL
+        {
+            skips = emit_condition(cond, skip);
+        }
+
+        if (last_native)
+        {
+            switch (ARM_INSTRUCTION::group(instruction))
+            {
+                case 0x0:
+                case 0x1:
+                    compile_data_proc(instruction, pc);
+                    break;
+                case 0x2:
+                case 0x3:
+                    compile_single_transfer(instruction, pc);
+                    break;
+                case 0x4:
+                    compile_block_transfer(instruction, pc);
+                    break;
+                default:
+                    compile_branch(instruction, pc, i + 1);
+                    break;
+            }
+            this->native_instructions++;
+        }
+        else
+        {
+            //mov rsi, entry
+            emit8(0x48);
+            emit8(0xBE);
+            emit64((unsigned long long)&block->instructions[i]);
+            emit_call((const void*)jit_interpret);
+            this->fallback_instructions++;
+        }
+
+        if ((entry->dispatch & DISPATCH_ALWAYS_STORE) && i + 1 < source->length)
+        {
+            emit_invalidation_check(block, source->pc, pc + 4, i + 1);
+        }
+
+        for (U32 j = 0; j < skips; j++)
+        {
+            patch_jump(skip[j]);
+        }
+    }
+
+    //an interpreted last instruction has set R15 itself, possibly from a register
+    if (last_native)
+    {
+        emit_exit(source->pc + source->length * 4, source->length, true);
+    }
+    else
+    {
+        emit_add_imm(CPU_OFFSET(cycles), source->length);
+        emit_lookup();
+    }
+
+    this->code_used += (U32)(this->emit_ptr - code);
+    this->compiled_blocks++;
+    return code;
+}
+
+
+//--------------//
+//-- chaining --//
+//--------------//
+//point an exit's jmp at the chained entry of block
+void GBA_EMUALTOR_ARM7TDMI_JIT::chain(U8 *link, BLOCK *block)
+{
+    U32 rel = (U32)((U8*)block->code + JIT_CHAIN_ENTRY - (link + 4));
+
+    //already chained, the exit was taken because the budget ran out
+    if (link[0] | link[1] | link[2] | link[3])
+    {
+        return;
+    }
+
+    link[0] = (U8)rel;
+    link[1] = (U8)(rel >> 8);
+    link[2] = (U8)(rel >> 16);
+    link[3] = (U8)(rel >> 24);
+    this->incoming[block - this->cpu->block_cache.blocks].push_back(link);
+    this->chains++;
+}
+
+//CPU::BLOCK_DROP_HOOK : jumps into the block return to run() again
+void GBA_EMUALTOR_ARM7TDMI_JIT::block_dropped(void *context, BLOCK *block)
+{
+    JIT *jit = (JIT*)context;
+    std::vector<U8*> &links = jit->incoming[block - jit->cpu->block_cache.blocks];
+    JIT_LOOKUP *entry = &jit->lookup[(block->pc >> 2) & (JIT_LOOKUP_SIZE - 1)];
+
+    for (U8 *link : links)
+    {
+        link[0] = 0;
+        link[1] = 0;
+        link[2] = 0;
+        link[3] = 0;
+        jit->unchains++;
+    }
+    links.clear();
+
+    if (entry->pc == block->pc)
+    {
+        entry->pc = BLOCK_INVALID;
+        entry->code = NULL;
+    }
+}
+
+
+//-------------//
+//-- tiering --//
+//-------------//
+void GBA_EMUALTOR_ARM7TDMI_JIT::worker_main()
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    while (true)
+    {
+        COMPILE_REQUEST *request;
+
+        this->wake.wait(guard, [this] { return this->stop || (!this->queue.empty() && !this->flush_pending); });
+        if (this->stop)
+        {
+            return;
+        }
+
+        //the buffer can only be reset between blocks, leave it to run()
+        if (this->code_used + JIT_MAX_BLOCK_CODE > JIT_CODE_SIZE)
+        {
+            this->flush_pending = true;
+            this->completed_ready.store(true, std::memory_order_release);
+            continue;
+        }
+
+        request = this->queue.front();
+        this->queue.pop_front();
+        this->compiling = true;
+        guard.unlock();
+
+        request->code = compile(request->block, &request->source);
+
+        guard.lock();
+        this->compiling = false;
+        this->completed.push_back(request);
+        this->completed_ready.store(true, std::memory_order_release);
+        this->idle.notify_all();
+    }
+}
+
+//copy the block, the emulation thread may decode over it while it compiles
+void GBA_EMUALTOR_ARM7TDMI_JIT::queue_compile(BLOCK *block)
+{
+    COMPILE_REQUEST *request = new COMPILE_REQUEST;
+
+    request->block = block;
+    request->generation = block->generation;
+    request->source = *block;
+    request->code = NULL;
+
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->queue.push_back(request);
+        this->queued++;
+    }
+    this->wake.notify_one();
+}
+
+//between blocks : hand finished code to the block cache, or reset the buffer
+//for the worker. a block decoded again since it was queued keeps interpreting
+void GBA_EMUALTOR_ARM7TDMI_JIT::install_completed()
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+
+    if (this->flush_pending)
+    {
+        reset_code();
+        this->wake.notify_one();
+        return;
+    }
+
+    for (COMPILE_REQUEST *request : this->completed)
+    {
+        if (request->block->generation == request->generation && request->block->code == NULL)
+        {
+            request->block->code = request->code;
+            this->installed++;
+        }
+        else
+        {
+            this->discarded++;
+        }
+        delete request;
+    }
+    this->completed.clear();
+    this->completed_ready.store(false, std::memory_order_relaxed);
+}
+
+//lock held, worker not compiling
+void GBA_EMUALTOR_ARM7TDMI_JIT::reset_code()
+{
+    for (U32 i = 0; i < BLOCK_CACHE_SIZE; i++)
+    {
+        this->cpu->block_cache.blocks[i].code = NULL;
+        this->cpu->block_cache.blocks[i].hotness = 0;
+    }
+
+    for (COMPILE_REQUEST *request : this->queue)
+    {
+        delete request;
+    }
+    for (COMPILE_REQUEST *request : this->completed)
+    {
+        delete request;
+    }
+    this->queue.clear();
+    this->completed.clear();
+
+    for (U32 i = 0; i < BLOCK_CACHE_SIZE; i++)
+    {
+        this->incoming[i].clear();
+    }
+    for (U32 i = 0; i < JIT_LOOKUP_SIZE; i++)
+    {
+        this->lookup[i].pc = BLOCK_INVALID;
+        this->lookup[i].code = NULL;
+    }
+
+    this->code_used = 0;
+    this->flush_pending = false;
+    this->completed_ready.store(false, std::memory_order_relaxed);
+    this->flushes++;
+}
+
+void GBA_EMUALTOR_ARM7TDMI_JIT::flush()
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    //the worker may be writing into the buffer
+    this->idle.wait(guard, [this] { return !this->compiling; });
+    reset_code();
+    guard.unlock();
+    this->wake.notify_one();
+}
+
+
+//CPU::run() with each block executed as compiled code once it is hot
+void GBA_EMUALTOR_ARM7TDMI_JIT::run(U32 cycle_budget)
+{
+    U8 *link = NULL;
+
+    if (this->code_buffer == NULL)
+    {
+        this->cpu->run(cycle_budget);
+        return;
+    }
+
+    this->target_cycles = this->cpu->cycles + cycle_budget;
+    while ((S32)(this->target_cycles - this->cpu->cycles) > 0)
+    {
+        BLOCK *block;
+        JIT_LOOKUP *entry;
+
+        if (this->completed_ready.load(std::memory_order_acquire))
+        {
+            install_completed();
+        }
+
+        //THUMB code is interpreted until a branch leaves THUMB state
+        if (this->cpu->thumb)
+        {
+            link = NULL;
+            this->cpu->run_thumb(this->target_cycles - this->cpu->cycles);
+            continue;
+        }
+
+        block = this->cpu->get_block(this->cpu->R[15] & ~0x3);
+        if (block->code == NULL)
+        {
+            if (block->hotness < this->hot_threshold)
+            {
+                link = NULL;
+                block->hotness++;
+                this->cpu->execute_block(block);
+                continue;
+            }
+
+            if (this->background)
+            {
+                //queued once, interpreted until the code is installed
+                if (block->hotness == this->hot_threshold)
+                {
+                    block->hotness++;
+                    queue_compile(block);
+                }
+                link = NULL;
+                this->cpu->execute_block(block);
+                continue;
+            }
+
+            if (this->code_used + JIT_MAX_BLOCK_CODE > JIT_CODE_SIZE)
+            {
+                flush();
+
+                //the exit it points at went with the old code, a block
+                //compiled into the same buffer is chained on first entry
+                link = NULL;
+            }
+            block->code = compile(block, block);
+        }
+
+        if (link)
+        {
+            chain(link, block);
+        }
+
+        entry = &this->lookup[(block->pc >> 2) & (JIT_LOOKUP_SIZE - 1)];
+        entry->pc = block->pc;
+        entry->code = (U8*)block->code + JIT_CHAIN_ENTRY;
+
+        link = ((JIT_CODE)block->code)(this->cpu);
+    }
+    this->cpu->memory.report_unknown();
+}
+
+#endif
@@ -0,0 +1,174 @@
+#pragma once
+
+
+#include "arm7tdmi.hpp"
+
+
+//the recompiler emits x86-64 code into mmap'd memory, other hosts and builds
+//defining GBA_NO_JIT run the interpreter instead
+#if defined(__x86_64__) && defined(__linux__) && !defined(GBA_NO_JIT)
+#define GBA_JIT     (1)
+#else
+#define GBA_JIT     (0)
+#endif
+
+#define JIT_CODE_SIZE           (0x00400000)    //host code buffer, flushed as a whole when full
+#define JIT_MAX_BLOCK_CODE      (0x00008000)    //upper bound of the code for one block
+#define JIT_HOT_THRESHOLD       (16)            //interpreted runs before a block is queued for compilation
+#define JIT_LOOKUP_SIZE         (1024)          //indirect branch targets, direct mapped on bit[11:2] of the PC
+#define JIT_CHAIN_ENTRY         (9)             //offset of the chained entry point, past the prologue
+
+#if GBA_JIT
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+
+//translates the blocks of the interpreter's block cache into x86-64 code.
+//data processing, single data transfer, block data transfer and branch
+//instructions are compiled, everything else calls its interpreter handler
+//
+//tiered : a block runs through the interpreter handlers (tier 0) until it has
+//been executed hot_threshold times, then a copy of it is queued to the worker
+//thread. the finished code is installed by run() between blocks, so the
+//emulation thread never waits for the compiler
+//
+//chaining : an exit to a static target (branch, fall through) ends in a jump
+//that run() patches to the successor's code the first time it is taken, an
+//exit after an interpreted instruction that may have moved R15 anywhere (BX,
+//MOV PC, LDR PC, LDM with R15) looks the target up in an inline hash table.
+//both stop at the cycle budget, and a dropped block has its incoming jumps
+//reset to return to run()
+class GBA_EMUALTOR_ARM7TDMI_JIT
+{
+public:
+    typedef GBA_EMUALTOR_ARM7TDMI CPU;
+    typedef CPU::BLOCK BLOCK;
+    typedef CPU::BLOCK_INSTRUCTION BLOCK_INSTRUCTION;
+
+    //rdi = CPU, returns with R15 at the next block and the cycles added. the
+    //result is the exit's jump to patch, NULL when the exit cannot be chained
+    typedef U8 *(*JIT_CODE)(CPU *cpu);
+
+    //guest PC -> chained entry point
+    typedef struct jit_lookup
+    {
+        U32   pc;
+        U32   rsv;
+        void *code;
+    }JIT_LOOKUP;
+
+    CPU *cpu;
+
+    U8 *code_buffer;        //NULL when the mapping failed, run() interprets then
+    U32 code_used;
+
+    bool background;        //compile on the worker thread, else when the block gets hot. off
+                            //without a second core, the worker would only take turns with run()
+    U32  hot_threshold;
+
+    //statistics, the compile counts are written by the compiling thread
+    U32 compiled_blocks;
+    U32 native_instructions;
+    U32 fallback_instructions;
+    U32 flushes;
+    U32 queued;
+    U32 installed;
+    U32 discarded;          //finished after the block was decoded again
+    U32 chain_hits;         //blocks entered through a chained jump or a lookup hit, counted by generated code
+    U32 lookup_hits;        //the lookup share of chain_hits
+    U32 chains;             //jumps patched
+    U32 unchains;           //jumps reset because their target was dropped
+
+    U32 target_cycles;      //cycle budget end of the current run(), read by generated code
+
+    JIT_LOOKUP lookup[JIT_LOOKUP_SIZE];
+
+    GBA_EMUALTOR_ARM7TDMI_JIT(CPU *cpu, bool background = true, U32 hot_threshold = JIT_HOT_THRESHOLD);
+    ~GBA_EMUALTOR_ARM7TDMI_JIT();
+
+    //same contract as CPU::run()
+    void run(U32 cycle_budget);
+
+    //drop all compiled code, emulation thread only
+    void flush();
+
+    static void block_dropped(void *context, BLOCK *block);
+
+#if GBA_JIT
+    //the block as it was when queued, compiled into code
+    typedef struct compile_request
+    {
+        BLOCK *block;
+        U32    generation;
+        BLOCK  source;
+        void  *code;
+    }COMPILE_REQUEST;
+
+    //-------------------//
+    //-- worker thread --//
+    //-------------------//
+    std::thread             worker;
+    std::mutex              lock;
+    std::condition_variable wake;       //work queued, flush done or stop
+    std::condition_variable idle;       //worker left compile()
+    std::deque<COMPILE_REQUEST*>  queue;
+    std::vector<COMPILE_REQUEST*> completed;
+    std::atomic<bool>       completed_ready;    //completed or flush_pending changed, checked by run() without the lock
+    bool                    compiling;
+    bool                    flush_pending;      //the worker ran out of code buffer
+    bool                    stop;
+
+    //patched jumps into each block cache slot
+    std::vector<U8*> incoming[BLOCK_CACHE_SIZE];
+
+    void chain(U8 *link, BLOCK *block);
+
+    void worker_main();
+    void queue_compile(BLOCK *block);
+    void install_completed();
+    void reset_code();
+
+    //emit source at the end of the code buffer, pointers into generated code
+    //refer to block
+    void *compile(BLOCK *block, const BLOCK *source);
+
+    //-------------//
+    //-- emitter --//
+    //-------------//
+    U8 *emit_ptr;
+
+    void emit8(U8 value);
+    void emit32(U32 value);
+    void emit64(unsigned long long value);
+    void emit_cpu_operand(U8 opcode, U32 reg, U32 offset);
+    void emit_store_imm(U32 offset, U32 value);
+    void emit_add_imm(U32 offset, U32 value);
+    void emit_cmp_imm(U32 offset, U8 value);
+    void emit_mov_imm(U32 reg, U32 value);
+    void emit_alu(U8 opcode, U32 dst, U32 src);
+    void emit_alu_imm(U32 extension, U32 reg, U32 value);
+    void emit_shift(U32 extension, U32 reg, U32 amount);
+    void emit_flag(U32 cc, U32 reg);
+    void emit_load_arm_reg(U32 reg, U32 arm_reg, U32 pc_value);
+    void emit_call(const void *function);
+    U8  *emit_jcc(U32 cc);
+    void patch_jump(U8 *at);
+    void emit_exit(U32 next_pc, U32 executed, bool chainable);
+    void emit_budget_check(U8 **exhausted);
+    void emit_lookup();
+    void emit_return();
+
+    U32  emit_condition(U32 cond, U8 **skip);
+    void emit_invalidation_check(BLOCK *block, U32 pc, U32 next_pc, U32 executed);
+
+    void compile_data_proc(U32 instruction, U32 pc);
+    void compile_single_transfer(U32 instruction, U32 pc);
+    void compile_block_transfer(U32 instruction, U32 pc);
+    void compile_branch(U32 instruction, U32 pc, U32 executed);
+#endif
+};
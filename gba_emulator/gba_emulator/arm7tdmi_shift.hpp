@@ -0,0 +1,116 @@
+#pragma once
+
+
+#include "arm7tdmi.hpp"
+
+
+//barrel shifter : operand2 of data processing and the scaled register offset
+//of single data transfers. one instance per shift type, carry is the C flag
+//on entry and the shifter carry out on return. LSR #imm and ASR #imm work out
+//the #32 case with a 64 bit shift instead of a branch, the other forms keep a
+//branch per amount case : benchmark_shifter() measures them slower without
+//one, the branch-free forms carry a dependency through the carry flag
+
+
+//doc, p55 : The form of the shift field which might be expected to correspond to LSR #0 is used to
+//encode LSR #32, which has a zero result with bit 31 of Rm as the carry output.Logical
+//shift right zero is redundant as it is the same as logical shift left zero, so the assembler
+//will convert LSR #0 (and ASR #0 and ROR #0) into LSL #0, and allow LSR #32 to be
+//specified.
+//amount is bit[11:7], 0-31 : LSL #0 leaves the carry, LSR #0 and ASR #0 are #32,
+//ROR #0 is RRX
+template<U32 SHIFT_TYPE>
+static inline U32 shift_by_immediate(U32 value, U32 amount, U32 &carry)
+{
+    if constexpr (SHIFT_TYPE == LSL)
+    {
+        if (amount == 0)
+        {
+            return value;
+        }
+        carry = (value >> (32 - amount)) & 0x1;
+        return value << amount;
+    }
+    else if constexpr (SHIFT_TYPE == LSR || SHIFT_TYPE == ASR)
+    {
+        //value in the upper word, the last bit shifted out lands in bit 31 of the lower one
+        U32 shift = ((amount - 1) & 0x1F) + 1;
+        U64 wide;
+
+        if constexpr (SHIFT_TYPE == LSR)
+        {
+            wide = ((U64)value << 32) >> shift;
+        }
+        else
+        {
+            wide = (U64)((S64)((U64)value << 32) >> shift);
+        }
+        carry = (U32)wide >> 31;
+        return (U32)(wide >> 32);
+    }
+    else
+    {
+        if (amount == 0) //RRX, rotate right extended
+        {
+            U32 result = (carry << 31) | (value >> 1);
+            carry = value & 0x1;
+            return result;
+        }
+        carry = (value >> (amount - 1)) & 0x1;
+        return (value >> amount) | (value << (32 - amount));
+    }
+}
+
+//amount is the bottom byte of Rs, 0-255 : 0 leaves value and carry, 32 and
+//above shift everything out (LSL, LSR), fill with the sign (ASR) or rotate by
+//amount modulo 32 (ROR)
+template<U32 SHIFT_TYPE>
+static inline U32 shift_by_register(U32 value, U32 amount, U32 &carry)
+{
+    if (amount == 0)
+    {
+        return value;
+    }
+
+    if constexpr (SHIFT_TYPE == LSL)
+    {
+        if (amount < 32)
+        {
+            carry = (value >> (32 - amount)) & 0x1;
+            return value << amount;
+        }
+        carry = (amount == 32) ? (value & 0x1) : 0;
+        return 0;
+    }
+    else if constexpr (SHIFT_TYPE == LSR)
+    {
+        if (amount < 32)
+        {
+            carry = (value >> (amount - 1)) & 0x1;
+            return value >> amount;
+        }
+        carry = (amount == 32) ? (value >> 31) : 0;
+        return 0;
+    }
+    else if constexpr (SHIFT_TYPE == ASR)
+    {
+        if (amount < 32)
+        {
+            carry = (value >> (amount - 1)) & 0x1;
+            return (U32)(((S32)value) >> amount);
+        }
+        carry = value >> 31;
+        return (U32)(((S32)value) >> 31);
+    }
+    else
+    {
+        amount &= 0x1F;
+        if (amount == 0) //ROR by 32, 64, ...
+        {
+            carry = value >> 31;
+            return value;
+        }
+        carry = (value >> (amount - 1)) & 0x1;
+        return (value >> amount) | (value << (32 - amount));
+    }
+}
@@ -0,0 +1,1591 @@
+
+#include <chrono>
+#include <stddef.h>
+#include <string.h>
+#include "arm7tdmi.hpp"
+#include "arm7tdmi_jit.hpp"
+#include "arm7tdmi_shift.hpp"
+#include "benchmark.hpp"
+#include "cartridge_save.hpp"
+
+#if GBA_MMAP_ROM && defined(__linux__)
+#include <unistd.h>
+#endif
+
+
+#define BENCHMARK_ITERATIONS  (10000000)
+
+typedef GBA_EMUALTOR_ARM7TDMI CPU;
+
+static CPU bench_cpu;
+static GBA_EMUALTOR_ARM7TDMI_JIT bench_jit(&bench_cpu);
+
+//results are stored here so the timed loops are not optimized away
+static volatile U32 benchmark_sink;
+
+//times ITERATIONS calls of body(i), prints ns per call
+template<typename BODY>
+static double benchmark(const char *name, U32 iterations, BODY body)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (U32 i = 0; i < iterations; i++)
+    {
+        body(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    printf("  %-40s %8.2f ns/op\n", name, ns);
+    return ns;
+}
+
+
+//-----------------------------------------------------------------------------
+//data processing : hand-written handlers (as they were before data_proc<>) vs
+//the template generated ones, both dispatched through a function pointer
+//-----------------------------------------------------------------------------
+typedef void(*LEGACY_HANDLER)(CPU *cpu, INSTRUCTION_FORMAT *instruction_ptr);
+
+//data processing fields as INSTRUCTION_FORMAT declared them before the
+//extractors, nested unions of packed bitfields
+#pragma pack(1)
+typedef union legacy_instruction
+{
+    U32 val;
+
+    union
+    {
+        struct
+        {
+            union
+            {
+                U32 Rm : 4;
+
+                struct
+                {
+                    U32 register_or_amount : 1;
+                    U32 shift_type : 2;
+                    union
+                    {
+                        U32 shift_amount : 5;
+                        struct
+                        {
+                            U32 rsv1 : 1;
+                            U32 shift_reg : 4;
+                        };
+                    };
+                }shift;
+            };
+
+            union
+            {
+                U32 imm : 8;
+                U32 rotate : 4;
+            };
+        }operand2;
+
+        U32 Rd : 4;
+        U32 Rn : 4;
+        U32 S : 1;
+        U32 opc : 4;
+        U32 I : 1;
+        U32 rsv : 2;
+        U32 cond : 4;
+    }data_proc;
+}LEGACY_INSTRUCTION;
+#pragma pack()
+
+//the packed CPSR the CPU kept before the flags were unpacked
+static CPSR legacy_CPSR;
+
+static void legacy_ADD_lli(CPU *cpu, INSTRUCTION_FORMAT *instruction_ptr)
+{
+    LEGACY_INSTRUCTION *instruction = (LEGACY_INSTRUCTION*)instruction_ptr;
+    U32 Rn           = instruction->data_proc.Rn;
+    U32 Rd           = instruction->data_proc.Rd;
+    U32 Rm           = instruction->data_proc.operand2.Rm;
+    U8  shift_amount = instruction->data_proc.operand2.shift.shift_amount;
+
+    cpu->R[Rd] = cpu->R[Rn] + (((U32)cpu->R[Rm]) << shift_amount);
+}
+
+static void legacy_ADDS_lli(CPU *cpu, INSTRUCTION_FORMAT *instruction_ptr)
+{
+    LEGACY_INSTRUCTION *instruction = (LEGACY_INSTRUCTION*)instruction_ptr;
+    U32 Rn           = instruction->data_proc.Rn;
+    U32 Rd           = instruction->data_proc.Rd;
+    U32 Rm           = instruction->data_proc.operand2.Rm;
+    U8  shift_amount = instruction->data_proc.operand2.shift.shift_amount;
+    U32 operand2     = (((U32)cpu->R[Rm]) << shift_amount);
+    U32 Rd_prev_val  = cpu->R[Rn];
+
+    cpu->R[Rd] = cpu->R[Rn] + operand2;
+
+    if (shift_amount != 0)
+    {
+        legacy_CPSR.C = cpu->R[Rm] & BIT((31 - shift_amount + 1));
+    }
+
+    legacy_CPSR.Z = !cpu->R[Rd];
+    legacy_CPSR.N = cpu->R[Rd] >> 31;
+    legacy_CPSR.V = (Rd_prev_val < cpu->R[Rd]) ? 1 : 0;
+}
+
+static void legacy_MOV_lli(CPU *cpu, INSTRUCTION_FORMAT *instruction_ptr)
+{
+    LEGACY_INSTRUCTION *instruction = (LEGACY_INSTRUCTION*)instruction_ptr;
+    U32 Rd           = instruction->data_proc.Rd;
+    U32 Rm           = instruction->data_proc.operand2.Rm;
+    U8  shift_amount = instruction->data_proc.operand2.shift.shift_amount;
+
+    cpu->R[Rd] = (((U32)cpu->R[Rm]) << shift_amount);
+}
+
+static void legacy_CMPS_lli(CPU *cpu, INSTRUCTION_FORMAT *instruction_ptr)
+{
+    LEGACY_INSTRUCTION *instruction = (LEGACY_INSTRUCTION*)instruction_ptr;
+    U32 Rn           = instruction->data_proc.Rn;
+    U32 Rm           = instruction->data_proc.operand2.Rm;
+    U8  shift_amount = instruction->data_proc.operand2.shift.shift_amount;
+    U32 operand2     = (((U32)cpu->R[Rm]) << shift_amount);
+    U32 Rd_temp      = cpu->R[Rn] - operand2;
+
+    if (shift_amount != 0)
+    {
+        legacy_CPSR.C = cpu->R[Rm] & BIT((31 - shift_amount + 1));
+    }
+
+    legacy_CPSR.Z = !Rd_temp;
+    legacy_CPSR.N = Rd_temp >> 31;
+    legacy_CPSR.V = (cpu->R[Rn] > Rd_temp) ? 1 : 0;
+}
+
+static void benchmark_data_proc()
+{
+    //ADD r1, r2, r3, LSL #2 / ADDS r1, r2, r3, LSL #2 / MOV r1, r3, LSL #2 / CMP r2, r3, LSL #2
+    static const U32 words[4] = { 0xE0821103, 0xE0921103, 0xE1A01103, 0xE1520103 };
+    static const LEGACY_HANDLER legacy[4] = { legacy_ADD_lli, legacy_ADDS_lli, legacy_MOV_lli, legacy_CMPS_lli };
+    static const char *names[4] = { "ADD", "ADDS", "MOV", "CMP" };
+    char name[64];
+
+    printf("data processing, lli operand2\n");
+    for (U32 op = 0; op < 4; op++)
+    {
+        INSTRUCTION_FORMAT instruction;
+        instruction.val = words[op];
+
+        CPU::ARM_HANDLER handler = CPU::arm_handler_table.handler[((words[op] >> 16) & 0xFF0) | ((words[op] >> 4) & 0xF)];
+        LEGACY_HANDLER   old     = legacy[op];
+
+        bench_cpu.R[2] = 0x12345678;
+        snprintf(name, sizeof(name), "%s hand-written", names[op]);
+        double t_old = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            bench_cpu.R[3] = i;
+            old(&bench_cpu, &instruction);
+        });
+
+        bench_cpu.R[2] = 0x12345678;
+        snprintf(name, sizeof(name), "%s data_proc<>", names[op]);
+        double t_new = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            bench_cpu.R[3] = i;
+            (bench_cpu.*handler)(&instruction);
+        });
+
+        printf("  %-40s %8.2fx\n", "speedup", t_old / t_new);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+//field decoding : Rd, Rn, Rm, the shift amount and the rotated immediate of
+//random words through the old bitfields and through the extractors. the
+//bitfields decode the wrong bits, the nested unions put every field at bit 0
+//-----------------------------------------------------------------------------
+static void benchmark_fields()
+{
+    static LEGACY_INSTRUCTION words[4096];
+    U32 seed = 1;
+    U32 sum = 0;
+
+    for (U32 i = 0; i < 4096; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        words[i].val = seed;
+    }
+
+    printf("instruction fields, random words\n");
+
+    benchmark("bitfields", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        LEGACY_INSTRUCTION *word = &words[i & 4095];
+        U32 rotate = word->data_proc.operand2.rotate * 2;
+        U32 imm = word->data_proc.operand2.imm;
+
+        sum += word->data_proc.Rd + word->data_proc.Rn + word->data_proc.operand2.Rm + word->data_proc.operand2.shift.shift_amount;
+        sum += (imm >> rotate) | (imm << ((32 - rotate) & 0x1F));
+    });
+    benchmark_sink = sum;
+
+    benchmark("extractors", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        U32 word = words[i & 4095].val;
+
+        sum += ARM_DATA_PROC::Rd(word) + ARM_DATA_PROC::Rn(word) + ARM_DATA_PROC::Rm(word) + ARM_DATA_PROC::shift_amount(word);
+        sum += ARM_DATA_PROC::rotated_imm(word);
+    });
+    benchmark_sink = sum;
+}
+
+
+//-----------------------------------------------------------------------------
+//barrel shifter : the shifters with a branch per amount case against the
+//branch-free ones, random values and amounts so the cases can not be predicted.
+//the register amounts mix 0, 1-31, 32 and above like Rs does. the faster form
+//of each is the one in arm7tdmi_shift.hpp
+//-----------------------------------------------------------------------------
+template<U32 SHIFT_TYPE>
+static inline U32 switch_shift_by_immediate(U32 value, U32 amount, U32 &carry)
+{
+    switch (SHIFT_TYPE)
+    {
+        case LSL:
+            if (amount == 0)
+            {
+                return value;
+            }
+            carry = (value >> (32 - amount)) & 0x1;
+            return value << amount;
+        case LSR:
+            if (amount == 0) //LSR #32
+            {
+                carry = value >> 31;
+                return 0;
+            }
+            carry = (value >> (amount - 1)) & 0x1;
+            return value >> amount;
+        case ASR:
+            if (amount == 0) //ASR #32
+            {
+                carry = value >> 31;
+                return (U32)(((S32)value) >> 31);
+            }
+            carry = (value >> (amount - 1)) & 0x1;
+            return (U32)(((S32)value) >> amount);
+        default:
+            if (amount == 0) //RRX, rotate right extended
+            {
+                U32 result = (carry << 31) | (value >> 1);
+                carry = value & 0x1;
+                return result;
+            }
+            carry = (value >> (amount - 1)) & 0x1;
+            return (value >> amount) | (value << (32 - amount));
+    }
+}
+
+//shift by the bottom byte of Rs, amount 0 leaves value and carry unchanged
+template<U32 SHIFT_TYPE>
+static inline U32 switch_shift_by_register(U32 value, U32 amount, U32 &carry)
+{
+    if (amount == 0)
+    {
+        return value;
+    }
+
+    switch (SHIFT_TYPE)
+    {
+        case LSL:
+            if (amount < 32)
+            {
+                carry = (value >> (32 - amount)) & 0x1;
+                return value << amount;
+            }
+            carry = (amount == 32) ? (value & 0x1) : 0;
+            return 0;
+        case LSR:
+            if (amount < 32)
+            {
+                carry = (value >> (amount - 1)) & 0x1;
+                return value >> amount;
+            }
+            carry = (amount == 32) ? (value >> 31) : 0;
+            return 0;
+        case ASR:
+            if (amount < 32)
+            {
+                carry = (value >> (amount - 1)) & 0x1;
+                return (U32)(((S32)value) >> amount);
+            }
+            carry = value >> 31;
+            return (U32)(((S32)value) >> 31);
+        default:
+            amount &= 0x1F;
+            if (amount == 0) //ROR by 32, 64, ...
+            {
+                carry = value >> 31;
+                return value;
+            }
+            carry = (value >> (amount - 1)) & 0x1;
+            return (value >> amount) | (value << (32 - amount));
+    }
+}
+
+//comparison baseline only : every amount case with 64 bit shifts and masks
+//instead of branches. shift_by_immediate() takes this form for LSR and ASR,
+//nothing else calls these
+
+//mask of all ones when condition holds, zero otherwise
+static inline U32 shift_mask(bool condition)
+{
+    return 0 - (U32)condition;
+}
+
+template<U32 SHIFT_TYPE>
+static inline U32 branch_free_shift_by_immediate(U32 value, U32 amount, U32 &carry)
+{
+    if constexpr (SHIFT_TYPE == LSL)
+    {
+        //bit 32 of the 64 bit result is the last bit shifted out
+        U64 wide = (U64)value << amount;
+        U32 keep = shift_mask(amount == 0);
+
+        carry = (carry & keep) | ((U32)(wide >> 32) & 0x1 & ~keep);
+        return (U32)wide;
+    }
+    else if constexpr (SHIFT_TYPE == LSR || SHIFT_TYPE == ASR)
+    {
+        //value in the upper word, the last bit shifted out lands in bit 31 of the lower one
+        U32 shift = ((amount - 1) & 0x1F) + 1;
+        U64 wide;
+
+        if constexpr (SHIFT_TYPE == LSR)
+        {
+            wide = ((U64)value << 32) >> shift;
+        }
+        else
+        {
+            wide = (U64)((S64)((U64)value << 32) >> shift);
+        }
+        carry = (U32)wide >> 31;
+        return (U32)(wide >> 32);
+    }
+    else
+    {
+        //a 64 bit rotate right of the value with value, or the carry for RRX,
+        //above it. RRX is a 1 bit rotate of the 33 bits carry:value
+        U32 rrx   = shift_mask(amount == 0);
+        U32 shift = amount + (amount == 0);
+        U64 wide  = ((U64)((value & ~rrx) | (carry & rrx)) << 32) | value;
+
+        carry = (value >> (shift - 1)) & 0x1;
+        return (U32)(wide >> shift);
+    }
+}
+
+template<U32 SHIFT_TYPE>
+static inline U32 branch_free_shift_by_register(U32 value, U32 amount, U32 &carry)
+{
+    U32 keep = shift_mask(amount == 0);
+    U32 carry_out;
+    U32 result;
+
+    if constexpr (SHIFT_TYPE == LSL)
+    {
+        //LSL #33 and above leave zero in bit 32 as well
+        U64 wide = (U64)value << ((amount > 33) ? 33 : amount);
+
+        carry_out = (U32)(wide >> 32) & 0x1;
+        result    = (U32)wide;
+    }
+    else if constexpr (SHIFT_TYPE == LSR)
+    {
+        U64 wide = ((U64)value << 32) >> ((amount > 33) ? 33 : amount);
+
+        carry_out = (U32)wide >> 31;
+        result    = (U32)(wide >> 32);
+    }
+    else if constexpr (SHIFT_TYPE == ASR)
+    {
+        //ASR #32 already fills both words with the sign
+        U64 wide = (U64)((S64)((U64)value << 32) >> ((amount > 32) ? 32 : amount));
+
+        carry_out = (U32)wide >> 31;
+        result    = (U32)(wide >> 32);
+    }
+    else
+    {
+        //ROR by a multiple of 32 leaves value, the carry out is bit 31 of the result either way
+        U32 shift = amount & 0x1F;
+
+        result    = (value >> shift) | (value << ((32 - shift) & 0x1F));
+        carry_out = result >> 31;
+    }
+
+    carry = (carry & keep) | (carry_out & ~keep);
+    return result;
+}
+
+
+
+template<U32 SHIFT_TYPE>
+static void benchmark_shift_type(const char *type, const U32 *values, const U32 *amounts)
+{
+    U32 carry = 0;
+    U32 sum = 0;
+    char name[64];
+
+    snprintf(name, sizeof(name), "%s #imm branches", type);
+    double t_old = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        sum += switch_shift_by_immediate<SHIFT_TYPE>(values[i & 4095], amounts[i & 4095] & 0x1F, carry);
+    });
+    benchmark_sink = sum + carry;
+
+    snprintf(name, sizeof(name), "%s #imm branch-free", type);
+    double t_new = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        sum += branch_free_shift_by_immediate<SHIFT_TYPE>(values[i & 4095], amounts[i & 4095] & 0x1F, carry);
+    });
+    benchmark_sink = sum + carry;
+    printf("  %-40s %8.2fx\n", "speedup", t_old / t_new);
+
+    snprintf(name, sizeof(name), "%s Rs branches", type);
+    t_old = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        sum += switch_shift_by_register<SHIFT_TYPE>(values[i & 4095], amounts[i & 4095], carry);
+    });
+    benchmark_sink = sum + carry;
+
+    snprintf(name, sizeof(name), "%s Rs branch-free", type);
+    t_new = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        sum += branch_free_shift_by_register<SHIFT_TYPE>(values[i & 4095], amounts[i & 4095], carry);
+    });
+    benchmark_sink = sum + carry;
+    printf("  %-40s %8.2fx\n", "speedup", t_old / t_new);
+}
+
+static void benchmark_shifter()
+{
+    static U32 values[4096];
+    static U32 amounts[4096];
+    U32 seed = 1;
+
+    for (U32 i = 0; i < 4096; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        values[i] = seed ^ (seed << 13);
+        amounts[i] = (seed >> 16) % 40;
+    }
+
+    printf("barrel shifter, random values and amounts\n");
+    benchmark_shift_type<LSL>("LSL", values, amounts);
+    benchmark_shift_type<LSR>("LSR", values, amounts);
+    benchmark_shift_type<ASR>("ASR", values, amounts);
+    benchmark_shift_type<ROR>("ROR", values, amounts);
+}
+
+//-----------------------------------------------------------------------------
+//interpreter loops, r0 counts down from 0x100000 and the loop ends with
+//SUBS r0, r0, #1 / BNE, the program is placed at base, address 0 (BIOS) by default
+//-----------------------------------------------------------------------------
+#define PROGRAM_LOOP_COUNT  (0x100000)
+
+//run(cycle_budget) executes the program
+template<typename RUN>
+static void benchmark_runner(const char *name, RUN run, const U32 *program, U32 size, U32 instructions_per_loop, U32 cycles_per_loop, U32 base)
+{
+    double best = 0;
+
+    memcpy(bench_cpu.memory.region_host(base, base), program, size);
+    bench_cpu.flush_block_cache();
+    bench_cpu.block_cache.hits = 0;
+    bench_cpu.block_cache.misses = 0;
+
+    //best of 8 passes, the program starts in ARM state
+    for (U32 pass = 0; pass < 8; pass++)
+    {
+        memset(&bench_cpu.R, 0, sizeof(bench_cpu.R));
+        bench_cpu.R[15] = base;
+        bench_cpu.thumb = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        run(PROGRAM_LOOP_COUNT * cycles_per_loop);
+        auto end = std::chrono::steady_clock::now();
+
+        U32 loops = PROGRAM_LOOP_COUNT - bench_cpu.R[0];
+        double mips = (1 + (double)instructions_per_loop * loops) / std::chrono::duration<double>(end - start).count() / 1e6;
+        if (mips > best)
+        {
+            best = mips;
+        }
+    }
+    printf("  %-40s %8.2f MIPS\n", name, best);
+    printf("  %-40s %u hits, %u misses\n", "block cache", bench_cpu.block_cache.hits, bench_cpu.block_cache.misses);
+}
+
+//the program under every dispatch mode built in
+static void benchmark_program(const char *name, const U32 *program, U32 size, U32 instructions_per_loop, U32 cycles_per_loop, U32 base = BIOS_BASE_LOG)
+{
+    char label[64];
+
+    snprintf(label, sizeof(label), "%s (loop)", name);
+    benchmark_runner(label, [](U32 budget) { bench_cpu.run_loop(budget); }, program, size, instructions_per_loop, cycles_per_loop, base);
+#if GBA_THREADED_DISPATCH
+    snprintf(label, sizeof(label), "%s (threaded)", name);
+    benchmark_runner(label, [](U32 budget) { bench_cpu.run_threaded(budget); }, program, size, instructions_per_loop, cycles_per_loop, base);
+#endif
+#if GBA_JIT
+    snprintf(label, sizeof(label), "%s (jit)", name);
+    bench_jit.chain_hits = 0;
+    bench_jit.lookup_hits = 0;
+    bench_jit.chains = 0;
+    benchmark_runner(label, [](U32 budget) { bench_jit.run(budget); }, program, size, instructions_per_loop, cycles_per_loop, base);
+    printf("  %-40s %u chained entries (%u through the lookup), %u jumps patched\n", "chaining", bench_jit.chain_hits, bench_jit.lookup_hits, bench_jit.chains);
+#endif
+}
+
+//a program that enters THUMB state with BX from an ARM prologue, through run(),
+//which switches between the ARM and THUMB loops. the JIT runs THUMB code in
+//the interpreter, so there is no compiled variant
+static void benchmark_thumb_program(const char *name, const U32 *program, U32 size, U32 instructions_per_loop, U32 cycles_per_loop, U32 base = BIOS_BASE_LOG)
+{
+    char label[64];
+
+    snprintf(label, sizeof(label), "%s (thumb)", name);
+    benchmark_runner(label, [](U32 budget) { bench_cpu.run(budget); }, program, size, instructions_per_loop, cycles_per_loop, base);
+}
+
+//flag setting ALU ops followed by a conditional branch, the pattern that dominates guest code
+static void benchmark_alu_loop()
+{
+    static const U32 program[] =
+    {
+        0xE3A00601,     //      MOV   r0, #0x100000
+        0xE0911000,     //loop: ADDS  r1, r1, r0
+        0xE0322001,     //      EORS  r2, r2, r1
+        0xE2500001,     //      SUBS  r0, r0, #1
+        0x1AFFFFFB,     //      BNE   loop
+        0xEAFFFFFE,     //      B     .
+    };
+
+    //THUMB words hold two halfwords, the low one first
+    static const U32 thumb_program[] =
+    {
+        0xE3A00601,     //      MOV   r0, #0x100000
+        0xE28FC001,     //      ADD   r12, pc, #1
+        0xE12FFF1C,     //      BX    r12
+        0x404A1809,     //loop: ADDS  r1, r1, r0    / EORS  r2, r1
+        0xD1FB3801,     //      SUBS  r0, #1        / BNE   loop
+        0x0000E7FE,     //      B     .
+    };
+
+    printf("interpreter\n");
+    benchmark_program("ADDS/EORS/SUBS/BNE loop", program, sizeof(program), 4, 6);
+    benchmark_thumb_program("ADDS/EORS/SUBS/BNE loop", thumb_program, sizeof(thumb_program), 4, 6);
+}
+
+//conditionally executed ALU ops, half of them skipped
+static void benchmark_conditional_loop()
+{
+    static const U32 program[] =
+    {
+        0xE3A00601,     //      MOV   r0, #0x100000
+        0xE2001003,     //loop: AND   r1, r0, #3
+        0xE3510001,     //      CMP   r1, #1
+        0xC2822001,     //      ADDGT r2, r2, #1
+        0xD2833001,     //      ADDLE r3, r3, #1
+        0x00244000,     //      EOREQ r4, r4, r0
+        0x10455001,     //      SUBNE r5, r5, r1
+        0xE2500001,     //      SUBS  r0, r0, #1
+        0x1AFFFFF7,     //      BNE   loop
+        0xEAFFFFFE,     //      B     .
+    };
+
+    benchmark_program("CMP + GT/LE/EQ/NE loop", program, sizeof(program), 8, 10);
+}
+
+//a call and return per iteration, the return goes through the indirect branch lookup
+static void benchmark_call_loop()
+{
+    static const U32 program[] =
+    {
+        0xE3A00601,     //      MOV   r0, #0x100000
+        0xEB000002,     //loop: BL    func
+        0xE2500001,     //      SUBS  r0, r0, #1
+        0x1AFFFFFC,     //      BNE   loop
+        0xEAFFFFFE,     //      B     .
+        0xE0811000,     //func: ADD   r1, r1, r0
+        0xE1A0F00E,     //      MOV   pc, lr
+    };
+
+    //BL is two halfwords
+    static const U32 thumb_program[] =
+    {
+        0xE3A00601,     //      MOV   r0, #0x100000
+        0xE28FC001,     //      ADD   r12, pc, #1
+        0xE12FFF1C,     //      BX    r12
+        0xF803F000,     //loop: BL    func
+        0xD1FB3801,     //      SUBS  r0, #1        / BNE   loop
+        0x1809E7FE,     //      B     .             / func: ADDS  r1, r1, r0
+        0x00004770,     //      BX    lr
+    };
+
+    benchmark_program("BL / MOV pc, lr loop", program, sizeof(program), 5, 12);
+    benchmark_thumb_program("BL / BX lr loop", thumb_program, sizeof(thumb_program), 6, 12);
+}
+
+//-----------------------------------------------------------------------------
+//self modifying code detection : loops in on-chip WRAM, one storing to a 256
+//byte granule between two granules holding code, which must not drop a block,
+//and one patching an instruction of its own loop every iteration
+//-----------------------------------------------------------------------------
+static void benchmark_smc()
+{
+    static U32 data_program[0x82] =
+    {
+        0xE3A00601,     //      MOV   r0, #0x100000
+        0xE3A02403,     //      MOV   r2, #0x03000000
+        0xE2822C01,     //      ADD   r2, r2, #0x100
+        0xE5821000,     //loop: STR   r1, [r2]
+        0xEB00007A,     //      BL    func
+        0xE2500001,     //      SUBS  r0, r0, #1
+        0x1AFFFFFB,     //      BNE   loop
+        0xEAFFFFFE,     //      B     .
+    };
+    static const U32 patch_program[] =
+    {
+        0xE3A00601,     //      MOV   r0, #0x100000
+        0xE3A02403,     //      MOV   r2, #0x03000000
+        0xE2822014,     //      ADD   r2, r2, #0x14
+        0xE5923000,     //loop: LDR   r3, [r2]
+        0xE2233001,     //      EOR   r3, r3, #1
+        0xE2811001,     //      ADD   r1, r1, #1       patched between #1 and #0
+        0xE5823000,     //      STR   r3, [r2]
+        0xE2500001,     //      SUBS  r0, r0, #1
+        0x1AFFFFFA,     //      BNE   loop
+        0xEAFFFFFE,     //      B     .
+    };
+    CPU::BLOCK_CACHE &cache = bench_cpu.block_cache;
+
+    data_program[0x80] = 0xE2811001;    //func: ADD   r1, r1, #1
+    data_program[0x81] = 0xE1A0F00E;    //      MOV   pc, lr
+
+    printf("self modifying code\n");
+    cache.invalidations = 0;
+    cache.code_writes = 0;
+    benchmark_program("store next to code", data_program, sizeof(data_program), 7, 13, ON_CHIP_WRAM_BASE_LOG);
+    printf("  %-40s %u code writes, %u blocks dropped\n", "detection", cache.code_writes, cache.invalidations);
+
+    cache.invalidations = 0;
+    cache.code_writes = 0;
+    benchmark_program("store into its own loop", patch_program, sizeof(patch_program), 6, 8, ON_CHIP_WRAM_BASE_LOG);
+    printf("  %-40s %u code writes, %u blocks dropped\n", "detection", cache.code_writes, cache.invalidations);
+
+    memset(bench_cpu.memory.region_host(ON_CHIP_WRAM_BASE_LOG, ON_CHIP_WRAM_BASE_LOG), 0, sizeof(data_program));
+    bench_cpu.memory.clear_all_dirty();
+    bench_cpu.flush_block_cache();
+}
+
+
+#if GBA_JIT
+//-----------------------------------------------------------------------------
+//tiered compilation : a chain of blocks seen for the first time, like code
+//touched during a level load, and the time of every frame's run() call when
+//blocks are compiled on first use vs. on the worker thread once hot
+//-----------------------------------------------------------------------------
+#define FRAME_CYCLES        (280896)
+#define TIERING_BLOCKS      (64)        //8 words each, all map to different block cache slots
+#define TIERING_FRAMES      (60)
+
+static void benchmark_tiering_mode(const char *name, bool background, U32 hot_threshold)
+{
+    static const U32 body[7] =
+    {
+        0xE0911000,     //ADDS  r1, r1, r0
+        0xE0222001,     //EOR   r2, r2, r1
+        0xE1A03102,     //MOV   r3, r2, LSL #2
+        0xE0433001,     //SUB   r3, r3, r1
+        0x03844001,     //ORREQ r4, r4, #1
+        0xE0255003,     //EOR   r5, r5, r3
+        0xE2866001,     //ADD   r6, r6, #1
+    };
+    static U32 program[TIERING_BLOCKS * 8];
+    double first = 0;
+    double worst = 0;
+
+    //block i falls into block i + 1, the last one branches back to block 0
+    for (U32 i = 0; i < TIERING_BLOCKS; i++)
+    {
+        U32 branch = i * 8 + 7;
+        U32 target = (i + 1 < TIERING_BLOCKS) ? branch + 1 : 0;
+
+        memcpy(&program[i * 8], body, sizeof(body));
+        program[branch] = 0xEA000000 | ((target - branch - 2) & 0x00FFFFFF);
+    }
+
+    memcpy(bench_cpu.memory.raw_data, program, sizeof(program));
+    bench_cpu.flush_block_cache();
+    memset(&bench_cpu.R, 0, sizeof(bench_cpu.R));
+
+    GBA_EMUALTOR_ARM7TDMI_JIT jit(&bench_cpu, background, hot_threshold);
+
+    for (U32 frame = 0; frame < TIERING_FRAMES; frame++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        jit.run(FRAME_CYCLES);
+        auto end = std::chrono::steady_clock::now();
+
+        double us = std::chrono::duration<double, std::micro>(end - start).count();
+        if (frame == 0)
+        {
+            first = us;
+        }
+        else if (us > worst)
+        {
+            worst = us;
+        }
+    }
+    printf("  %-40s %8.1f us first frame, %8.1f us worst of the rest, %u %s\n", name, first, worst, jit.background ? jit.installed : jit.compiled_blocks, jit.background ? "installed" : "compiled on the emulation thread");
+}
+
+static void benchmark_tiering()
+{
+    printf("tiered compilation, %u hardware threads\n", std::thread::hardware_concurrency());
+    benchmark_tiering_mode("compile on first use", false, 0);
+    benchmark_tiering_mode("tiered, threshold 16", true, JIT_HOT_THRESHOLD);
+}
+#endif
+
+
+//-----------------------------------------------------------------------------
+//flags : a flag setting op followed by the condition check of the next
+//instruction, without the fetch
+//-----------------------------------------------------------------------------
+static void benchmark_flags()
+{
+    //ADDS r1, r1, r0 / SUBS r0, r0, #1 / ANDS r1, r1, r0 / CMP r1, r0 / MOV r1, r0 (no S)
+    static const U32 words[5] = { 0xE0911000, 0xE2500001, 0xE0111000, 0xE1510000, 0xE1A01000 };
+    static const U32 conds[5] = { 0x2, 0x1, 0x0, 0xC, 0x1 };     //CS, NE, EQ, GT, NE
+    static const char *names[5] = { "ADDS + BCS", "SUBS + BNE", "ANDS + BEQ", "CMP + BGT", "MOV + BNE" };
+
+    printf("flag setting op + condition check\n");
+    for (U32 op = 0; op < 5; op++)
+    {
+        INSTRUCTION_FORMAT instruction;
+        instruction.val = words[op];
+
+        CPU::ARM_HANDLER handler = CPU::arm_handler_table.handler[((words[op] >> 16) & 0xFF0) | ((words[op] >> 4) & 0xF)];
+        U32 cond = conds[op];
+        U32 taken = 0;
+
+        bench_cpu.R[1] = 0x12345678;
+        benchmark(names[op], BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            bench_cpu.R[0] = i;
+            (bench_cpu.*handler)(&instruction);
+            taken += bench_cpu.check_condition(cond);
+        });
+        benchmark_sink = taken;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+//condition check : the switch over COND_* against the condition_table lookup,
+//random conditions and flags so the switch can not be predicted
+//-----------------------------------------------------------------------------
+static bool switch_condition(CPU *cpu, U32 cond)
+{
+    switch (cond)
+    {
+        case 0x0: return cpu->flag_Z();
+        case 0x1: return !cpu->flag_Z();
+        case 0x2: return cpu->flag_C();
+        case 0x3: return !cpu->flag_C();
+        case 0x4: return cpu->flag_N();
+        case 0x5: return !cpu->flag_N();
+        case 0x6: return cpu->flag_V();
+        case 0x7: return !cpu->flag_V();
+        case 0x8: return cpu->flag_C() && !cpu->flag_Z();
+        case 0x9: return !cpu->flag_C() || cpu->flag_Z();
+        case 0xA: return cpu->flag_N() == cpu->flag_V();
+        case 0xB: return cpu->flag_N() != cpu->flag_V();
+        case 0xC: return !cpu->flag_Z() && (cpu->flag_N() == cpu->flag_V());
+        case 0xD: return cpu->flag_Z() || (cpu->flag_N() != cpu->flag_V());
+        case 0xE: return true;
+        default:  return false;
+    }
+}
+
+static void benchmark_conditions()
+{
+    static U32 conds[4096];
+    static U32 nzcv[4096];
+    U32 seed = 1;
+    U32 taken = 0;
+
+    for (U32 i = 0; i < 4096; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        conds[i] = (seed >> 16) % 15;
+        nzcv[i] = (seed >> 8) & 0xF;
+    }
+
+    printf("condition check, random cond and NZCV\n");
+
+    benchmark("switch", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        bench_cpu.set_CPSR((nzcv[i & 4095] << 28) | SVC_MODE);
+        taken += switch_condition(&bench_cpu, conds[i & 4095]);
+    });
+    benchmark_sink = taken;
+
+    benchmark("condition_table", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        bench_cpu.set_CPSR((nzcv[i & 4095] << 28) | SVC_MODE);
+        taken += bench_cpu.check_condition(conds[i & 4095]);
+    });
+    benchmark_sink = taken;
+}
+
+
+//-----------------------------------------------------------------------------
+//memory : byte reads per region through the switch on bit[27:24] that
+//MEMORY::operator[] used (with its mask precedence fixed) against the page
+//table, scattered addresses inside each region
+//-----------------------------------------------------------------------------
+static U8 switch_read(MEMORY *memory, U32 idx)
+{
+    switch (idx & 0x0F000000)
+    {
+        case BIOS_BASE_LOG:
+            return memory->raw_data[(idx & 0x00FFFFFF) + BIOS_BASE_PHY];
+        case ON_BOARD_WRAM_BASE_LOG:
+            return memory->raw_data[(idx & 0x00FFFFFF) + ON_BOARD_WRAM_BASE_PHY];
+        case ON_CHIP_WRAM_BASE_LOG:
+            return memory->raw_data[(idx & 0x00FFFFFF) + ON_CHIP_WRAM_BASE_PHY];
+        case IO_REGISTER_BASE_LOG:
+            return memory->raw_data[(idx & 0x00FFFFFF) + IO_REGISTER_BASE_PHY];
+        case PALETTE_RAM_BASE_LOG:
+            return memory->raw_data[(idx & 0x00FFFFFF) + PALETTE_RAM_BASE_PHY];
+        case VIDEO_RAM_BASE_LOG:
+            return memory->raw_data[(idx & 0x00FFFFFF) + VIDEO_RAM_BASE_PHY];
+        case OBJ_ATTR_RAM_BASE_LOG:
+            return memory->raw_data[(idx & 0x00FFFFFF) + OBJ_ATTR_RAM_BASE_PHY];
+        case CARTRIDGE_ROM_WAIT_STATE_0_BASE_LOG:
+            return memory->rom[idx & 0x00FFFFFF];
+        default:
+            return 0x00;
+    }
+}
+
+static void benchmark_memory()
+{
+    static const char *names[6] = { "BIOS", "on-board WRAM", "on-chip WRAM", "I/O (table)", "VRAM", "game pak ROM" };
+    static const U32 bases[6] = { BIOS_BASE_LOG, ON_BOARD_WRAM_BASE_LOG, ON_CHIP_WRAM_BASE_LOG, IO_REGISTER_BASE_LOG, VIDEO_RAM_BASE_LOG, CARTRIDGE_ROM_WAIT_STATE_0_BASE_LOG };
+    static const U32 sizes[6] = { BIOS_SIZE, ON_BOARD_WRAM_SIZE, ON_CHIP_WRAM_SIZE, IO_REGISTER_SIZE, 0x00010000, 0x01000000 };
+    char name[64];
+
+    printf("memory, byte reads\n");
+    for (U32 region = 0; region < 6; region++)
+    {
+        U32 base = bases[region];
+        U32 mask = sizes[region] - 1;
+        U32 sum = 0;
+
+        snprintf(name, sizeof(name), "%s switch", names[region]);
+        double t_old = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            sum += switch_read(&bench_cpu.memory, base + ((i * 0x9E3779B1) & mask));
+        });
+        benchmark_sink = sum;
+
+        snprintf(name, sizeof(name), "%s page table", names[region]);
+        double t_new = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            sum += bench_cpu.memory[base + ((i * 0x9E3779B1) & mask)];
+        });
+        benchmark_sink = sum;
+
+        printf("  %-40s %8.1f M/s switch, %8.1f M/s page table\n", "accesses", 1e3 / t_old, 1e3 / t_new);
+    }
+
+    //word reads : four byte reads as read_word() did, the page table read<U32>,
+    //and read<U32, REGION> with the region known at compile time
+    printf("memory, word reads\n");
+    for (U32 region = 1; region < 3; region++)
+    {
+        U32 base = bases[region];
+        U32 mask = (sizes[region] - 1) & ~0x3;
+        U32 sum = 0;
+
+        snprintf(name, sizeof(name), "%s 4 x byte", names[region]);
+        double t_bytes = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            U32 idx = base + ((i * 0x9E3779B1) & mask);
+            MEMORY &memory = bench_cpu.memory;
+
+            sum += (U32)memory[idx] | ((U32)memory[idx + 1] << 8) | ((U32)memory[idx + 2] << 16) | ((U32)memory[idx + 3] << 24);
+        });
+        benchmark_sink = sum;
+
+        snprintf(name, sizeof(name), "%s read<U32>", names[region]);
+        double t_word = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            sum += bench_cpu.memory.read<U32>(base + ((i * 0x9E3779B1) & mask));
+        });
+        benchmark_sink = sum;
+
+        snprintf(name, sizeof(name), "%s read<U32, REGION>", names[region]);
+        double t_region;
+        if (region == 1)
+        {
+            t_region = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+            {
+                sum += bench_cpu.memory.read<U32, ON_BOARD_WRAM_BASE_LOG>(base + ((i * 0x9E3779B1) & mask));
+            });
+        }
+        else
+        {
+            t_region = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+            {
+                sum += bench_cpu.memory.read<U32, ON_CHIP_WRAM_BASE_LOG>(base + ((i * 0x9E3779B1) & mask));
+            });
+        }
+        benchmark_sink = sum;
+
+        printf("  %-40s %8.2fx read<U32>, %8.2fx read<U32, REGION>\n", "speedup over 4 x byte", t_bytes / t_word, t_bytes / t_region);
+    }
+
+    printf("memory, byte writes\n");
+    for (U32 region = 0; region < 6; region++)
+    {
+        U32 base = bases[region];
+        U32 mask = sizes[region] - 1;
+
+        snprintf(name, sizeof(name), "%s page table", names[region]);
+        double t = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            bench_cpu.memory.write<U8>(base + ((i * 0x9E3779B1) & mask), (U8)i);
+        });
+        printf("  %-40s %8.1f M/s\n", "accesses", 1e3 / t);
+    }
+    bench_cpu.flush_block_cache();
+}
+
+
+//-----------------------------------------------------------------------------
+//dirty bitmap : word writes without the dirty bit against write<U32>(), which
+//tests the watched bitmap instead and sets the dirty bit on the first store to
+//a granule. the baselines are the store and the code bitmap check in front of
+//the write hook, on its own and behind the alignment and page checks of
+//write_paged(). the benchmark writes no code, so none of them calls the hook
+//-----------------------------------------------------------------------------
+static inline void store_without_dirty_bit(MEMORY &memory, U8 *host, U32 idx, U32 value)
+{
+    U32 granule = (U32)(host - memory.raw_data) >> DIRTY_SHIFT;
+
+    *(U32*)host = value;
+    if ((memory.code[granule >> 5] & (1u << (granule & 31))) && memory.write_hook)
+    {
+        memory.write_hook(memory.write_hook_context, idx, 4);
+    }
+}
+
+static void benchmark_dirty()
+{
+    static const char *names[3] = { "on-board WRAM", "on-chip WRAM", "VRAM" };
+    static const U32 bases[3] = { ON_BOARD_WRAM_BASE_LOG, ON_CHIP_WRAM_BASE_LOG, VIDEO_RAM_BASE_LOG };
+    static const U32 sizes[3] = { ON_BOARD_WRAM_SIZE, ON_CHIP_WRAM_SIZE, 0x00010000 };
+    MEMORY &memory = bench_cpu.memory;
+    char name[64];
+
+    printf("dirty bitmap, word writes\n");
+    for (U32 region = 0; region < 3; region++)
+    {
+        U32 base = bases[region];
+        U32 mask = (sizes[region] - 1) & ~0x3;
+
+        snprintf(name, sizeof(name), "%s store without dirty bit", names[region]);
+        double t_store = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            U32 idx = base + ((i * 0x9E3779B1) & mask);
+            U8 *page = memory.write_page[(idx >> MEMORY_PAGE_SHIFT) & (MEMORY_PAGE_COUNT - 1)];
+
+            store_without_dirty_bit(memory, &page[idx & (MEMORY_PAGE_SIZE - 1)], idx, i);
+        });
+
+        snprintf(name, sizeof(name), "%s paged without dirty bit", names[region]);
+        double t_paged = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            U32 idx = (base + ((i * 0x9E3779B1) & mask)) & ~0x3;
+            U8 *page = memory.write_page[(idx >> MEMORY_PAGE_SHIFT) & (MEMORY_PAGE_COUNT - 1)];
+
+            if (page == NULL)
+            {
+                memory.write_slow<U32>(idx, i);
+                return;
+            }
+            store_without_dirty_bit(memory, &page[idx & (MEMORY_PAGE_SIZE - 1)], idx, i);
+        });
+
+        snprintf(name, sizeof(name), "%s write<U32>", names[region]);
+        double t_new = benchmark(name, BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            memory.write<U32>(base + ((i * 0x9E3779B1) & mask), i);
+        });
+
+        printf("  %-40s %+7.1f%%\n", "overhead against the store", (t_new / t_store - 1) * 100);
+        printf("  %-40s %+7.1f%%\n", "overhead against paged", (t_new / t_paged - 1) * 100);
+    }
+    memory.clear_all_dirty();
+    bench_cpu.flush_block_cache();
+}
+
+//-----------------------------------------------------------------------------
+//I/O registers : halfword reads of the hot registers (DISPSTAT, VCOUNT,
+//KEYINPUT, IF) and IF acknowledges, through two byte handler calls switching on
+//the region as default_read()/default_write() did, against the dispatch table
+//-----------------------------------------------------------------------------
+static U8 switch_io_read(void *context, U32 idx)
+{
+    MEMORY *memory = (MEMORY*)context;
+
+    switch (idx & 0x0F000000)
+    {
+        case IO_REGISTER_BASE_LOG:
+            return memory->raw_data[(idx & (IO_REGISTER_SIZE - 1)) + IO_REGISTER_BASE_PHY];
+        case PALETTE_RAM_BASE_LOG:
+            return memory->raw_data[(idx & (PALETTE_RAM_SIZE - 1)) + PALETTE_RAM_BASE_PHY];
+        case OBJ_ATTR_RAM_BASE_LOG:
+            return memory->raw_data[(idx & (OBJ_ATTR_RAM_SIZE - 1)) + OBJ_ATTR_RAM_BASE_PHY];
+        default:
+            return 0x00;
+    }
+}
+
+static void switch_io_write(void *context, U32 idx, U8 value)
+{
+    MEMORY *memory = (MEMORY*)context;
+
+    switch (idx & 0x0F000000)
+    {
+        case IO_REGISTER_BASE_LOG:
+            memory->raw_data[(idx & (IO_REGISTER_SIZE - 1)) + IO_REGISTER_BASE_PHY] = value;
+            break;
+        case PALETTE_RAM_BASE_LOG:
+            memory->raw_data[(idx & (PALETTE_RAM_SIZE - 1)) + PALETTE_RAM_BASE_PHY] = value;
+            break;
+        case OBJ_ATTR_RAM_BASE_LOG:
+            memory->raw_data[(idx & (OBJ_ATTR_RAM_SIZE - 1)) + OBJ_ATTR_RAM_BASE_PHY] = value;
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_io()
+{
+    static const U32 hot[4] = { IO_DISPSTAT, IO_VCOUNT, IO_KEYINPUT, IO_IF };
+    MEMORY &memory = bench_cpu.memory;
+    MEMORY::READ_HANDLER read_handler = memory.read_handler;
+    MEMORY::WRITE_HANDLER write_handler = memory.write_handler;
+    U32 sum = 0;
+
+    printf("I/O registers\n");
+    memory.read_handler = switch_io_read;
+    memory.write_handler = switch_io_write;
+    double t_read_old = benchmark("hot register reads, byte handlers", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        U32 idx = IO_REGISTER_BASE_LOG + hot[i & 3];
+
+        sum += (U32)memory.read_handler(memory.handler_context, idx) | ((U32)memory.read_handler(memory.handler_context, idx + 1) << 8);
+    });
+    benchmark_sink = sum;
+    double t_write_old = benchmark("IF acknowledge, byte handlers", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        memory.write_handler(memory.handler_context, IO_REGISTER_BASE_LOG + IO_IF, (U8)i);
+        memory.write_handler(memory.handler_context, IO_REGISTER_BASE_LOG + IO_IF + 1, (U8)(i >> 8));
+    });
+    memory.read_handler = read_handler;
+    memory.write_handler = write_handler;
+
+    double t_read = benchmark("hot register reads, dispatch table", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        sum += memory.read<U16>(IO_REGISTER_BASE_LOG + hot[i & 3]);
+    });
+    benchmark_sink = sum;
+    double t_write = benchmark("IF acknowledge, dispatch table", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        memory.write<U16>(IO_REGISTER_BASE_LOG + IO_IF, (U16)i);
+    });
+
+    printf("  %-40s %8.2fx reads, %8.2fx writes\n", "speedup", t_read_old / t_read, t_write_old / t_write);
+#if GBA_IO_COUNTERS
+    printf("  %-40s %u reads, %u writes\n", "IF counters", memory.io[IO_IF >> 1].reads, memory.io[IO_IF >> 1].writes);
+#endif
+}
+
+
+//-----------------------------------------------------------------------------
+//save memory : SRAM byte writes and flash programming through the handlers,
+//ROM reads with an EEPROM attached, and the time the emulation thread spends
+//in sync() over frames with save bursts while the writer thread is on disk
+//-----------------------------------------------------------------------------
+#define BENCHMARK_SAVE_FILE     "benchmark_save.sav"
+#define SAVE_FRAMES             (600)
+
+static void benchmark_save()
+{
+    CPU *cpu = new CPU;
+    MEMORY &memory = cpu->memory;
+    U32 sum = 0;
+
+    printf("save memory\n");
+    {
+        CARTRIDGE_SAVE save(&memory, SAVE_SRAM, BENCHMARK_SAVE_FILE);
+
+        benchmark("SRAM write<U8>", BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            memory.write<U8>(SAVE_AREA_BASE_LOG + ((i * 0x9E3779B1) & (SAVE_SRAM_SIZE - 1)), (U8)i);
+        });
+        save.dirty = 0;
+        save.written = false;
+    }
+    {
+        CARTRIDGE_SAVE save(&memory, SAVE_FLASH_128K, BENCHMARK_SAVE_FILE);
+
+        benchmark("flash program, 4 writes", BENCHMARK_ITERATIONS / 4, [&](U32 i)
+        {
+            memory.write<U8>(SAVE_AREA_BASE_LOG + 0x5555, 0xAA);
+            memory.write<U8>(SAVE_AREA_BASE_LOG + 0x2AAA, 0x55);
+            memory.write<U8>(SAVE_AREA_BASE_LOG + 0x5555, FLASH_CMD_PROGRAM);
+            memory.write<U8>(SAVE_AREA_BASE_LOG + ((i * 0x9E3779B1) & (SAVE_FLASH_BANK_SIZE - 1)), (U8)i);
+        });
+        save.dirty = 0;
+        save.written = false;
+    }
+
+    benchmark("ROM read<U32>", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        sum += memory.read<U32>(CARTRIDGE_ROM_WAIT_STATE_0_BASE_LOG + ((i * 0x9E3779B1) & 0x00FFFFFC));
+    });
+    {
+        CARTRIDGE_SAVE save(&memory, SAVE_EEPROM, BENCHMARK_SAVE_FILE, 0x01000000);
+
+        benchmark("ROM read<U32>, EEPROM attached", BENCHMARK_ITERATIONS, [&](U32 i)
+        {
+            sum += memory.read<U32>(CARTRIDGE_ROM_WAIT_STATE_0_BASE_LOG + ((i * 0x9E3779B1) & 0x00FFFFFC));
+        });
+    }
+    benchmark_sink = sum;
+
+    //a 3 frame burst of writes to the whole SRAM every 20 frames
+    {
+        CARTRIDGE_SAVE save(&memory, SAVE_SRAM, BENCHMARK_SAVE_FILE);
+        double worst = 0;
+        double total = 0;
+
+        for (U32 frame = 0; frame < SAVE_FRAMES; frame++)
+        {
+            if (frame % 20 < 3)
+            {
+                for (U32 offset = 0; offset < SAVE_SRAM_SIZE; offset++)
+                {
+                    memory.write<U8>(SAVE_AREA_BASE_LOG + offset, (U8)(frame + offset));
+                }
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            save.sync();
+            auto end = std::chrono::steady_clock::now();
+
+            double us = std::chrono::duration<double, std::micro>(end - start).count();
+            total += us;
+            if (us > worst)
+            {
+                worst = us;
+            }
+        }
+        save.flush();
+        printf("  %-40s %8.2f us average, %8.2f us worst over %d frames\n", "sync()", total / SAVE_FRAMES, worst, SAVE_FRAMES);
+        printf("  %-40s %u bursts, %u hand offs, %u files written\n", "write-behind", SAVE_FRAMES / 20, save.handoffs, save.flushes);
+    }
+
+    remove(BENCHMARK_SAVE_FILE);
+    delete cpu;
+}
+
+
+#if GBA_MMAP_ROM && defined(__linux__)
+//-----------------------------------------------------------------------------
+//ROM loading : a 32MB ROM read into an allocated area as readROM() does
+//without mmap, against readROM() mapping it, on a fresh CPU each. resident
+//memory from /proc/self/statm, the file is in the page cache for both
+//-----------------------------------------------------------------------------
+#define BENCHMARK_ROM_FILE  "benchmark_rom.gba"
+
+//resident and shared (file backed) MB
+static void resident_mb(double &resident, double &shared)
+{
+    unsigned long pages[3] = { 0, 0, 0 };
+    FILE *statm = fopen("/proc/self/statm", "r");
+
+    if (statm)
+    {
+        if (fscanf(statm, "%lu %lu %lu", &pages[0], &pages[1], &pages[2]) != 3)
+        {
+            pages[1] = pages[2] = 0;
+        }
+        fclose(statm);
+    }
+    resident = pages[1] * (double)sysconf(_SC_PAGESIZE) / (1024 * 1024);
+    shared = pages[2] * (double)sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+template<typename LOAD>
+static void benchmark_rom_load_mode(const char *name, LOAD load)
+{
+    CPU *cpu = new CPU;
+    U32 sum = 0;
+    double resident[3];
+    double shared[3];
+
+    resident_mb(resident[0], shared[0]);
+    auto start = std::chrono::steady_clock::now();
+    load(cpu);
+    auto end = std::chrono::steady_clock::now();
+    resident_mb(resident[1], shared[1]);
+
+    //one read per 4KB, as if the game touched all of it
+    for (U32 offset = 0; offset < CARTRIDGE_ROM_WAIT_STATE_0_SIZE; offset += 0x1000)
+    {
+        sum += cpu->memory.read<U32>(CARTRIDGE_ROM_WAIT_STATE_0_BASE_LOG + offset);
+    }
+    benchmark_sink = sum;
+    resident_mb(resident[2], shared[2]);
+
+    printf("  %-40s %8.1f us\n", name, std::chrono::duration<double, std::micro>(end - start).count());
+    printf("  %-40s +%.1f MB resident (+%.1f MB shared) after the load, +%.1f MB (+%.1f MB shared) after reading every page\n", "",
+        resident[1] - resident[0], shared[1] - shared[0], resident[2] - resident[0], shared[2] - shared[0]);
+    delete cpu;
+}
+
+static void benchmark_rom_load()
+{
+    static U8 data[0x10000];
+    FILE *file = fopen(BENCHMARK_ROM_FILE, "wb");
+
+    if (file == NULL)
+    {
+        return;
+    }
+    for (U32 i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (U8)(i * 0x9E3779B1 >> 24);
+    }
+    for (U32 i = 0; i < CARTRIDGE_ROM_WAIT_STATE_0_SIZE / sizeof(data); i++)
+    {
+        fwrite(data, 1, sizeof(data), file);
+    }
+    fclose(file);
+
+    printf("ROM loading, 32MB\n");
+    benchmark_rom_load_mode("ifstream copy", [](CPU *cpu)
+    {
+        std::ifstream fin;
+        U8 *rom = MEMORY::allocate(CARTRIDGE_ROM_WAIT_STATE_0_SIZE);
+
+        fin.open(BENCHMARK_ROM_FILE, std::ios::binary | std::ios::in);
+        fin.read((char*)rom, CARTRIDGE_ROM_WAIT_STATE_0_SIZE);
+        fin.close();
+        cpu->rom_mapping = rom;
+        cpu->memory.map_rom(rom);
+    });
+    benchmark_rom_load_mode("readROM() mmap", [](CPU *cpu)
+    {
+        cpu->readROM(BENCHMARK_ROM_FILE);
+    });
+
+    remove(BENCHMARK_ROM_FILE);
+}
+
+//-----------------------------------------------------------------------------
+//instances : resident memory per CPU right after construction, and after
+//every byte of WRAM and VRAM was written and a loop ran from BIOS
+//-----------------------------------------------------------------------------
+#define BENCHMARK_INSTANCES     (32)
+
+static void benchmark_instances()
+{
+    static const U32 program[] =
+    {
+        0xE3A00601,     //      MOV   r0, #0x100000
+        0xE2500001,     //loop: SUBS  r0, r0, #1
+        0x1AFFFFFD,     //      BNE   loop
+        0xEAFFFFFE,     //      B     .
+    };
+    CPU *cpus[BENCHMARK_INSTANCES];
+    double resident[3];
+    double shared;
+
+    printf("instances, %d CPUs\n", BENCHMARK_INSTANCES);
+    resident_mb(resident[0], shared);
+    for (U32 i = 0; i < BENCHMARK_INSTANCES; i++)
+    {
+        cpus[i] = new CPU;
+    }
+    resident_mb(resident[1], shared);
+
+    for (U32 i = 0; i < BENCHMARK_INSTANCES; i++)
+    {
+        MEMORY &memory = cpus[i]->memory;
+
+        memset(memory.region_host(ON_BOARD_WRAM_BASE_LOG, ON_BOARD_WRAM_BASE_LOG), 0xFF, ON_BOARD_WRAM_SIZE);
+        memset(memory.region_host(ON_CHIP_WRAM_BASE_LOG, ON_CHIP_WRAM_BASE_LOG), 0xFF, ON_CHIP_WRAM_SIZE);
+        memset(memory.region_host(VIDEO_RAM_BASE_LOG, VIDEO_RAM_BASE_LOG), 0xFF, VIDEO_RAM_SIZE);
+        memcpy(memory.raw_data, program, sizeof(program));
+        cpus[i]->run_loop(0x00100000 * 4);
+    }
+    resident_mb(resident[2], shared);
+
+    printf("  %-40s %8.1f KB\n", "sizeof(CPU)", sizeof(CPU) / 1024.0);
+    printf("  %-40s %8.1f KB resident\n", "constructed", (resident[1] - resident[0]) * 1024 / BENCHMARK_INSTANCES);
+    printf("  %-40s %8.1f KB resident\n", "RAM written, loop run", (resident[2] - resident[0]) * 1024 / BENCHMARK_INSTANCES);
+
+    for (U32 i = 0; i < BENCHMARK_INSTANCES; i++)
+    {
+        delete cpus[i];
+    }
+}
+#endif
+
+
+//-----------------------------------------------------------------------------
+//CPU state : where the hot part of the object ends, and the whole CPSR
+//packed and unpacked through the MRS and MSR handlers
+//-----------------------------------------------------------------------------
+static void benchmark_state()
+{
+    //MRS r1, CPSR / MSR CPSR_f, r1
+    static const U32 words[2] = { 0xE10F1000, 0xE128F001 };
+    CPU::ARM_HANDLER handlers[2];
+    INSTRUCTION_FORMAT instructions[2];
+
+    for (U32 i = 0; i < 2; i++)
+    {
+        instructions[i].val = words[i];
+        handlers[i] = CPU::arm_handler_table.handler[((words[i] >> 16) & 0xFF0) | ((words[i] >> 4) & 0xF)];
+    }
+
+    printf("CPU state\n");
+    printf("  %-40s %8u bytes\n", "R to the end of block_cache", (U32)(offsetof(CPU, block_cache) + sizeof(CPU::BLOCK_CACHE) - offsetof(CPU, R)));
+    printf("  %-40s %8u\n", "offset of memory", (U32)offsetof(CPU, memory));
+
+    benchmark("MRS CPSR", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        bench_cpu.flags.result = i;
+        (bench_cpu.*handlers[0])(&instructions[0]);
+    });
+    benchmark_sink = bench_cpu.R[1];
+
+    benchmark("MSR CPSR_f", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        bench_cpu.R[1] = i << 28;
+        (bench_cpu.*handlers[1])(&instructions[1]);
+    });
+    benchmark_sink = bench_cpu.flag_NZCV();
+}
+
+
+//-----------------------------------------------------------------------------
+//mode switches : the SPSR through a switch over the mode, as MRS picked it
+//from named fields, against the banked index, then the switches themselves
+//-----------------------------------------------------------------------------
+typedef struct legacy_spsrs
+{
+    SPSR fiq, svc, abt, irq, und;
+}LEGACY_SPSRS;
+
+static U32 switch_spsr(LEGACY_SPSRS *spsrs, U32 mode)
+{
+    switch (mode)
+    {
+        case FIQ_MODE: return spsrs->fiq.val;
+        case IRQ_MODE: return spsrs->irq.val;
+        case SVC_MODE: return spsrs->svc.val;
+        case ABT_MODE: return spsrs->abt.val;
+        case UND_MODE: return spsrs->und.val;
+        default:       return 0;
+    }
+}
+
+static void benchmark_modes()
+{
+    static const U32 modes[5] = { FIQ_MODE, IRQ_MODE, SVC_MODE, ABT_MODE, UND_MODE };
+    static const U32 program[] =
+    {
+        0xE3A00601,     //      MOV   r0, #0x100000
+        0xE321F0D2,     //loop: MSR   CPSR_c, #0xD2     IRQ
+        0xE14F1000,     //      MRS   r1, SPSR
+        0xE169F001,     //      MSR   SPSR_fc, r1
+        0xE321F0DF,     //      MSR   CPSR_c, #0xDF     system
+        0xE2500001,     //      SUBS  r0, r0, #1
+        0x1AFFFFF9,     //      BNE   loop
+        0xEAFFFFFE,     //      B     .
+    };
+    static U32 picks[4096];
+    static U8 banks[4096];
+    static LEGACY_SPSRS spsrs;
+    U32 seed = 1;
+    U32 sum = 0;
+
+    for (U32 i = 0; i < 4096; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        picks[i] = modes[(seed >> 16) % 5];
+        banks[i] = (U8)((seed >> 16) % 5 + BANK_FIQ);
+    }
+    for (U32 i = 0; i < 5; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        (&spsrs.fiq)[i].val = seed;
+        bench_cpu.SPSR_bank[BANK_FIQ + i].val = seed;
+    }
+
+    printf("mode switches, random mode\n");
+
+    benchmark("SPSR switch", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        sum += switch_spsr(&spsrs, picks[i & 4095]);
+    });
+    benchmark_sink = sum;
+
+    benchmark("SPSR bank", BENCHMARK_ITERATIONS, [&](U32 i)
+    {
+        sum += bench_cpu.SPSR_bank[banks[i & 4095]].val;
+    });
+    benchmark_sink = sum;
+
+    bench_cpu.switch_mode(SYS_MODE);
+    benchmark("IRQ -> system -> IRQ", BENCHMARK_ITERATIONS, [&](U32)
+    {
+        bench_cpu.switch_mode(IRQ_MODE);
+        bench_cpu.switch_mode(SYS_MODE);
+    });
+    benchmark("FIQ -> system -> FIQ", BENCHMARK_ITERATIONS, [&](U32)
+    {
+        bench_cpu.switch_mode(FIQ_MODE);
+        bench_cpu.switch_mode(SYS_MODE);
+    });
+
+    benchmark_program("MSR/MRS mode switch", program, sizeof(program), 6, 8);
+    bench_cpu.switch_mode(SVC_MODE);
+}
+
+
+#if GBA_FASTMEM
+//-----------------------------------------------------------------------------
+//fastmem : the page table reads of read_paged() against read() through the
+//fastmem window, scattered addresses inside each region. I/O faults on every
+//access and runs fewer iterations. the game pak ROM is read as
+//empty_cartridge, then as a copy in allocate()d memory like the ifstream path
+//of readROM() loads it. neither may fault, and both reads must agree
+//-----------------------------------------------------------------------------
+#define FASTMEM_ROM_COPY_SIZE   (0x00100000)
+
+static void benchmark_fastmem()
+{
+    static const char *names[7] = { "BIOS", "on-board WRAM", "on-chip WRAM", "I/O (fault)", "VRAM", "game pak ROM", "game pak ROM copy" };
+    static const U32 bases[7] = { BIOS_BASE_LOG, ON_BOARD_WRAM_BASE_LOG, ON_CHIP_WRAM_BASE_LOG, IO_REGISTER_BASE_LOG, VIDEO_RAM_BASE_LOG, CARTRIDGE_ROM_WAIT_STATE_0_BASE_LOG, CARTRIDGE_ROM_WAIT_STATE_0_BASE_LOG };
+    static const U32 sizes[7] = { BIOS_SIZE, ON_BOARD_WRAM_SIZE, ON_CHIP_WRAM_SIZE, IO_REGISTER_SIZE, 0x00010000, CARTRIDGE_ROM_WAIT_STATE_0_SIZE, FASTMEM_ROM_COPY_SIZE };
+    CPU *cpu = new CPU;
+    char name[64];
+
+    auto start = std::chrono::steady_clock::now();
+    bool enabled = cpu->memory.enable_fastmem();
+    auto end = std::chrono::steady_clock::now();
+
+    if (!enabled)
+    {
+        delete cpu;
+        return;
+    }
+
+    printf("fastmem, word reads\n");
+    printf("  %-40s %8.1f us\n", "enable_fastmem()", std::chrono::duration<double, std::micro>(end - start).count());
+    for (U32 region = 0; region < 7; region++)
+    {
+        U32 iterations = (region == 3) ? BENCHMARK_ITERATIONS / 100 : BENCHMARK_ITERATIONS;
+        U32 base = bases[region];
+        U32 mask = (sizes[region] - 1) & ~0x3;
+        U32 sum_paged = 0;
+        U32 sum_fast = 0;
+
+        if (region == 6)
+        {
+            U8 *rom = MEMORY::allocate(CARTRIDGE_ROM_WAIT_STATE_0_SIZE);
+
+            if (rom == NULL)
+            {
+                break;
+            }
+            for (U32 i = 0; i < FASTMEM_ROM_COPY_SIZE; i++)
+            {
+                rom[i] = (U8)(i * 0x9E3779B1 >> 24);
+            }
+            cpu->rom_mapping = rom;
+            cpu->memory.map_rom(rom);
+        }
+
+        snprintf(name, sizeof(name), "%s page table", names[region]);
+        double t_paged = benchmark(name, iterations, [&](U32 i)
+        {
+            sum_paged += cpu->memory.read_paged<U32>(base + ((i * 0x9E3779B1) & mask));
+        });
+
+        snprintf(name, sizeof(name), "%s fastmem", names[region]);
+        double t_fast = benchmark(name, iterations, [&](U32 i)
+        {
+            sum_fast += cpu->memory.read<U32>(base + ((i * 0x9E3779B1) & mask));
+        });
+        benchmark_sink = sum_paged + sum_fast;
+
+        printf("  %-40s %8.2fx%s\n", "speedup", t_paged / t_fast, (sum_paged != sum_fast) ? ", reads differ" : "");
+    }
+    delete cpu;
+}
+#endif
+
+
+void run_benchmarks()
+{
+    benchmark_data_proc();
+    benchmark_fields();
+    benchmark_shifter();
+    benchmark_flags();
+    benchmark_conditions();
+    benchmark_state();
+    benchmark_modes();
+    benchmark_memory();
+    benchmark_dirty();
+    benchmark_io();
+    benchmark_save();
+#if GBA_MMAP_ROM && defined(__linux__)
+    benchmark_rom_load();
+    benchmark_instances();
+#endif
+#if GBA_FASTMEM
+    benchmark_fastmem();
+#endif
+    benchmark_alu_loop();
+    benchmark_conditional_loop();
+    benchmark_call_loop();
+    benchmark_smc();
+#if GBA_JIT
+    benchmark_tiering();
+#endif
+}
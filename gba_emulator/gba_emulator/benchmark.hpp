@@ -0,0 +1,5 @@
+#pragma once
+
+
+//micro benchmarks for the interpreter, build with GBA_BENCHMARK defined to run them from main()
+void run_benchmarks();
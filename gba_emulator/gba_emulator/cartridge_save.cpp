@@ -0,0 +1,536 @@
+#include <string.h>
+#include "cartridge_save.hpp"
+
+#if defined(_WIN32)
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+
+//the file is read when it exists, erased flash and EEPROM read as FF and so
+//does SRAM without a battery. an EEPROM file's size sets the address width
+CARTRIDGE_SAVE::CARTRIDGE_SAVE(MEMORY *memory, U32 type, const std::string &path, U32 rom_size)
+{
+    FILE *file;
+
+    this->memory = memory;
+    this->type = type;
+    this->rom_size = rom_size;
+    this->path = path;
+    this->dirty = 0;
+    this->written = false;
+    this->deferred = 0;
+    this->flash_state = FLASH_READY;
+    this->flash_erase = false;
+    this->flash_id = false;
+    this->flash_bank = 0;
+    this->eeprom_count = 0;
+    this->eeprom_address_bits = 0;
+    this->eeprom_reply = 0;
+    this->eeprom_reply_left = 0;
+    this->handoffs = 0;
+    this->flushes = 0;
+    this->failures = 0;
+    this->pending_size = 0;
+    this->pending_ready = false;
+    this->writing = false;
+    this->stop = false;
+
+    switch (type)
+    {
+        case SAVE_SRAM:
+            this->size = SAVE_SRAM_SIZE;
+            break;
+        case SAVE_FLASH_64K:
+            this->size = SAVE_FLASH_BANK_SIZE;
+            break;
+        case SAVE_FLASH_128K:
+            this->size = 2 * SAVE_FLASH_BANK_SIZE;
+            break;
+        default:
+            this->size = 0;
+            break;
+    }
+
+    this->data = MEMORY::allocate(SAVE_MAX_SIZE);
+    this->pending = MEMORY::allocate(SAVE_MAX_SIZE);
+    memset(this->data, 0xFF, SAVE_MAX_SIZE);
+
+    file = fopen(path.c_str(), "rb");
+    if (file)
+    {
+        size_t length = fread(this->data, 1, SAVE_MAX_SIZE, file);
+
+        fclose(file);
+        if (type == SAVE_EEPROM && (length == SAVE_EEPROM_SMALL_SIZE || length == SAVE_EEPROM_LARGE_SIZE))
+        {
+            this->size = (U32)length;
+            this->eeprom_address_bits = (length == SAVE_EEPROM_SMALL_SIZE) ? 6 : 14;
+        }
+    }
+    memcpy(this->pending, this->data, SAVE_MAX_SIZE);
+
+    if (type == SAVE_NONE)
+    {
+        return;
+    }
+
+    this->previous_read = memory->read_handler;
+    this->previous_write = memory->write_handler;
+    this->previous_context = memory->handler_context;
+    memory->read_handler = handler_read;
+    memory->write_handler = handler_write;
+    memory->handler_context = this;
+
+    //a ROM larger than 16MB keeps the EEPROM page's other bytes, see handler_read()
+    if (type == SAVE_EEPROM)
+    {
+        if (rom_size <= 0x01000000)
+        {
+            memory->unmap(SAVE_EEPROM_BASE_LOG, 0x01000000);
+        }
+        else
+        {
+            memory->unmap(SAVE_EEPROM_LARGE_ROM & ~(MEMORY_PAGE_SIZE - 1), MEMORY_PAGE_SIZE);
+        }
+    }
+
+    this->writer = std::thread(&CARTRIDGE_SAVE::writer_main, this);
+}
+
+CARTRIDGE_SAVE::~CARTRIDGE_SAVE()
+{
+    if (this->writer.joinable())
+    {
+        flush();
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            this->stop = true;
+        }
+        this->wake.notify_one();
+        this->writer.join();
+
+        this->memory->read_handler = this->previous_read;
+        this->memory->write_handler = this->previous_write;
+        this->memory->handler_context = this->previous_context;
+        if (this->type == SAVE_EEPROM)
+        {
+            this->memory->map_rom(this->memory->rom, this->memory->rom_file);
+        }
+    }
+    MEMORY::release(this->pending, SAVE_MAX_SIZE);
+    MEMORY::release(this->data, SAVE_MAX_SIZE);
+}
+
+
+//the IDs are word aligned in the library code, followed by a version number
+U32 CARTRIDGE_SAVE::detect(const U8 *rom, U32 size)
+{
+    static const struct
+    {
+        const char *id;
+        U32         type;
+    }ids[] =
+    {
+        { "EEPROM_V",   SAVE_EEPROM },
+        { "SRAM_V",     SAVE_SRAM },
+        { "SRAM_F_V",   SAVE_SRAM },
+        { "FLASH_V",    SAVE_FLASH_64K },
+        { "FLASH512_V", SAVE_FLASH_64K },
+        { "FLASH1M_V",  SAVE_FLASH_128K },
+    };
+
+    for (U32 offset = 0; offset + 16 <= size; offset += 4)
+    {
+        if (rom[offset] != 'E' && rom[offset] != 'S' && rom[offset] != 'F')
+        {
+            continue;
+        }
+        for (U32 i = 0; i < sizeof(ids) / sizeof(ids[0]); i++)
+        {
+            if (memcmp(&rom[offset], ids[i].id, strlen(ids[i].id)) == 0)
+            {
+                return ids[i].type;
+            }
+        }
+    }
+    return SAVE_NONE;
+}
+
+
+//a save routine spreads its writes over several frames, the hand off waits
+//for a frame without any, so the routine ends up as one file write. a title
+//that writes every frame is handed off every SAVE_MAX_DEFERRED frames
+void CARTRIDGE_SAVE::sync()
+{
+    if (this->written)
+    {
+        this->written = false;
+        if (++this->deferred < SAVE_MAX_DEFERRED)
+        {
+            return;
+        }
+    }
+    else
+    {
+        this->deferred = 0;
+    }
+    if (this->dirty == 0)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> guard(this->lock, std::try_to_lock);
+
+    if (!guard.owns_lock() || this->writing)
+    {
+        return;
+    }
+    hand_off();
+}
+
+void CARTRIDGE_SAVE::flush()
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    this->idle.wait(guard, [this] { return !this->writing && !this->pending_ready; });
+    if (this->dirty)
+    {
+        hand_off();
+        this->idle.wait(guard, [this] { return !this->writing && !this->pending_ready; });
+    }
+    this->written = false;
+}
+
+//lock held and the writer not reading pending. pending keeps the image last
+//handed off, so only the dirty sectors are copied
+void CARTRIDGE_SAVE::hand_off()
+{
+    for (U32 sector = 0; sector < (SAVE_MAX_SIZE >> SAVE_SECTOR_SHIFT); sector++)
+    {
+        if (this->dirty & (1u << sector))
+        {
+            memcpy(&this->pending[sector << SAVE_SECTOR_SHIFT], &this->data[sector << SAVE_SECTOR_SHIFT], 1 << SAVE_SECTOR_SHIFT);
+        }
+    }
+    this->dirty = 0;
+    this->deferred = 0;
+    this->pending_size = this->size;
+    this->pending_ready = true;
+    this->handoffs++;
+    this->wake.notify_one();
+}
+
+
+//---------------------------------------------------------------------------
+//save memories
+//---------------------------------------------------------------------------
+U8 CARTRIDGE_SAVE::handler_read(void *context, U32 idx)
+{
+    CARTRIDGE_SAVE *save = (CARTRIDGE_SAVE*)context;
+
+    if ((idx & 0x0F000000) >= SAVE_AREA_BASE_LOG)
+    {
+        switch (save->type)
+        {
+            case SAVE_SRAM:
+                return save->data[idx & (SAVE_SRAM_SIZE - 1)];
+            case SAVE_FLASH_64K:
+            case SAVE_FLASH_128K:
+                return save->flash_read(idx & (SAVE_FLASH_BANK_SIZE - 1));
+            default:
+                break;
+        }
+    }
+    else if (save->type == SAVE_EEPROM && (idx & 0x0F000000) == SAVE_EEPROM_BASE_LOG)
+    {
+        //one bit in bit 0 of each halfword
+        if (save->eeprom_address(idx))
+        {
+            return (idx & 1) ? 0 : save->eeprom_read();
+        }
+        return save->memory->rom[idx & (CARTRIDGE_ROM_WAIT_STATE_0_SIZE - 1)];
+    }
+    return save->previous_read(save->previous_context, idx);
+}
+
+void CARTRIDGE_SAVE::handler_write(void *context, U32 idx, U8 value)
+{
+    CARTRIDGE_SAVE *save = (CARTRIDGE_SAVE*)context;
+
+    if ((idx & 0x0F000000) >= SAVE_AREA_BASE_LOG)
+    {
+        switch (save->type)
+        {
+            case SAVE_SRAM:
+                save->data[idx & (SAVE_SRAM_SIZE - 1)] = value;
+                save->mark(idx & (SAVE_SRAM_SIZE - 1), 1);
+                return;
+            case SAVE_FLASH_64K:
+            case SAVE_FLASH_128K:
+                save->flash_write(idx & (SAVE_FLASH_BANK_SIZE - 1), value);
+                return;
+            default:
+                break;
+        }
+    }
+    else if (save->type == SAVE_EEPROM && save->eeprom_address(idx))
+    {
+        if ((idx & 1) == 0)
+        {
+            save->eeprom_write(value);
+        }
+        return;
+    }
+    save->previous_write(save->previous_context, idx, value);
+}
+
+//SST 39VF512 for 64KB, Macronix MX29L010 for 128KB
+U8 CARTRIDGE_SAVE::flash_read(U32 offset)
+{
+    static const U8 ids[2][2] = { { 0xBF, 0xD4 }, { 0xC2, 0x09 } };
+
+    if (this->flash_id && offset < 2)
+    {
+        return ids[this->type == SAVE_FLASH_128K][offset];
+    }
+    return this->data[this->flash_bank * SAVE_FLASH_BANK_SIZE + offset];
+}
+
+//every command starts with the unlock writes, a write breaking the sequence
+//starts over
+void CARTRIDGE_SAVE::flash_write(U32 offset, U8 value)
+{
+    U32 bank = this->flash_bank * SAVE_FLASH_BANK_SIZE;
+
+    switch (this->flash_state)
+    {
+        case FLASH_PROGRAM:
+            this->data[bank + offset] = value;
+            mark(bank + offset, 1);
+            this->flash_state = FLASH_READY;
+            return;
+        case FLASH_BANK:
+            if (offset == 0 && this->type == SAVE_FLASH_128K)
+            {
+                this->flash_bank = value & 1;
+            }
+            this->flash_state = FLASH_READY;
+            return;
+        case FLASH_READY:
+            if (value == FLASH_CMD_ID_EXIT)
+            {
+                this->flash_id = false;
+            }
+            this->flash_state = (offset == 0x5555 && value == 0xAA) ? FLASH_UNLOCK_1 : FLASH_READY;
+            return;
+        case FLASH_UNLOCK_1:
+            this->flash_state = (offset == 0x2AAA && value == 0x55) ? FLASH_UNLOCK_2 : FLASH_READY;
+            return;
+        default:
+            break;
+    }
+
+    this->flash_state = FLASH_READY;
+    if (this->flash_erase)
+    {
+        this->flash_erase = false;
+        if (offset == 0x5555 && value == FLASH_CMD_ERASE_CHIP)
+        {
+            memset(this->data, 0xFF, this->size);
+            mark(0, this->size);
+        }
+        else if (value == FLASH_CMD_ERASE_SECTOR)
+        {
+            memset(&this->data[bank + (offset & 0xF000)], 0xFF, 1 << SAVE_SECTOR_SHIFT);
+            mark(bank + (offset & 0xF000), 1 << SAVE_SECTOR_SHIFT);
+        }
+        return;
+    }
+    if (offset != 0x5555)
+    {
+        return;
+    }
+    switch (value)
+    {
+        case FLASH_CMD_ERASE:
+            this->flash_erase = true;
+            break;
+        case FLASH_CMD_ID_ENTER:
+            this->flash_id = true;
+            break;
+        case FLASH_CMD_ID_EXIT:
+            this->flash_id = false;
+            break;
+        case FLASH_CMD_PROGRAM:
+            this->flash_state = FLASH_PROGRAM;
+            break;
+        case FLASH_CMD_BANK:
+            this->flash_state = FLASH_BANK;
+            break;
+        default:
+            break;
+    }
+}
+
+void CARTRIDGE_SAVE::eeprom_write(U8 value)
+{
+    if (this->eeprom_count < EEPROM_MAX_BITS)
+    {
+        this->eeprom_bits[this->eeprom_count++] = value & 1;
+    }
+}
+
+//a read ends the request written before it. writes complete at once, so
+//the ready bit is always set
+U8 CARTRIDGE_SAVE::eeprom_read()
+{
+    if (this->eeprom_count)
+    {
+        eeprom_request();
+    }
+    if (this->eeprom_reply_left)
+    {
+        this->eeprom_reply_left--;
+        return (this->eeprom_reply_left < 64) ? (U8)((this->eeprom_reply >> this->eeprom_reply_left) & 1) : 0;
+    }
+    return 1;
+}
+
+//the first request tells the address width : a read is 2 + address + 1 stop
+//bits, a write 2 + address + 64 + 1. bytes hold the block MSB first
+void CARTRIDGE_SAVE::eeprom_request()
+{
+    U32 count = this->eeprom_count;
+    U32 request = (this->eeprom_bits[0] << 1) | this->eeprom_bits[1];
+    U32 address = 0;
+    U32 offset;
+
+    this->eeprom_count = 0;
+    if (count < 3 || (request != EEPROM_REQUEST_READ && request != EEPROM_REQUEST_WRITE))
+    {
+        return;
+    }
+    if (this->eeprom_address_bits == 0)
+    {
+        U32 width = (request == EEPROM_REQUEST_WRITE) ? count - 67 : count - 3;
+
+        if (width != 6 && width != 14)
+        {
+            return;
+        }
+        this->eeprom_address_bits = width;
+        this->size = (width == 6) ? SAVE_EEPROM_SMALL_SIZE : SAVE_EEPROM_LARGE_SIZE;
+    }
+    if (count != this->eeprom_address_bits + ((request == EEPROM_REQUEST_WRITE) ? 67 : 3))
+    {
+        return;
+    }
+
+    for (U32 i = 0; i < this->eeprom_address_bits; i++)
+    {
+        address = (address << 1) | this->eeprom_bits[2 + i];
+    }
+    offset = (address * 8) & (this->size - 1);
+
+    if (request == EEPROM_REQUEST_READ)
+    {
+        this->eeprom_reply = 0;
+        for (U32 i = 0; i < 8; i++)
+        {
+            this->eeprom_reply = (this->eeprom_reply << 8) | this->data[offset + i];
+        }
+        this->eeprom_reply_left = EEPROM_REPLY_BITS;
+        return;
+    }
+
+    for (U32 i = 0; i < 8; i++)
+    {
+        U8 byte = 0;
+
+        for (U32 bit = 0; bit < 8; bit++)
+        {
+            byte = (byte << 1) | this->eeprom_bits[2 + this->eeprom_address_bits + i * 8 + bit];
+        }
+        this->data[offset + i] = byte;
+    }
+    mark(offset, 8);
+    this->eeprom_reply_left = 0;
+}
+
+
+//---------------------------------------------------------------------------
+//writer thread
+//---------------------------------------------------------------------------
+void CARTRIDGE_SAVE::writer_main()
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    while (true)
+    {
+        U32 length;
+        bool ok;
+
+        this->wake.wait(guard, [this] { return this->stop || this->pending_ready; });
+        if (!this->pending_ready)
+        {
+            return;
+        }
+
+        this->pending_ready = false;
+        this->writing = true;
+        length = this->pending_size;
+        guard.unlock();
+
+        ok = write_file(this->pending, length);
+
+        guard.lock();
+        this->writing = false;
+        if (ok)
+        {
+            this->flushes++;
+        }
+        else
+        {
+            this->failures++;
+        }
+        this->idle.notify_all();
+    }
+}
+
+//written to path.tmp, flushed to the disk and renamed over path, so a crash
+//leaves either the old or the new file
+bool CARTRIDGE_SAVE::write_file(const U8 *bytes, U32 length)
+{
+    std::string temporary = this->path + ".tmp";
+    FILE *file = fopen(temporary.c_str(), "wb");
+    bool ok;
+
+    if (file == NULL)
+    {
+        printf("save : can not create %s\n", temporary.c_str());
+        return false;
+    }
+
+    ok = fwrite(bytes, 1, length, file) == length && fflush(file) == 0;
+#if defined(_WIN32)
+    ok = ok && _commit(_fileno(file)) == 0;
+#else
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    ok = (fclose(file) == 0) && ok;
+#if defined(_WIN32)
+    ok = ok && MoveFileExA(temporary.c_str(), this->path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    ok = ok && rename(temporary.c_str(), this->path.c_str()) == 0;
+#endif
+
+    if (!ok)
+    {
+        printf("save : can not write %s\n", this->path.c_str());
+        remove(temporary.c_str());
+    }
+    return ok;
+}
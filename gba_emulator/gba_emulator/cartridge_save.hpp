@@ -0,0 +1,162 @@
+#pragma once
+
+
+#include "arm7tdmi.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+//save memory types, see CARTRIDGE_SAVE::detect()
+#define SAVE_NONE               (0)
+#define SAVE_SRAM               (1)     //32KB battery backed SRAM, 8 bit bus
+#define SAVE_FLASH_64K          (2)     //one 64KB flash bank
+#define SAVE_FLASH_128K         (3)     //two 64KB banks, switched by command B0
+#define SAVE_EEPROM             (4)     //512B or 8KB serial EEPROM, one bit per halfword access
+
+#define SAVE_AREA_BASE_LOG      (0x0E000000)    //SRAM and flash, mirrored up to 0x0FFFFFFF
+#define SAVE_EEPROM_BASE_LOG    (0x0D000000)    //the whole area for ROMs up to 16MB
+#define SAVE_EEPROM_LARGE_ROM   (0x0DFFFF00)    //the last 256 bytes for larger ROMs
+
+#define SAVE_MAX_SIZE           (0x00020000)
+#define SAVE_SRAM_SIZE          (0x00008000)
+#define SAVE_FLASH_BANK_SIZE    (0x00010000)
+#define SAVE_EEPROM_SMALL_SIZE  (0x00000200)    //6 bit block address
+#define SAVE_EEPROM_LARGE_SIZE  (0x00002000)    //14 bit block address, 10 bits used
+#define SAVE_SECTOR_SHIFT       (12)            //4KB flash erase sector, also the unit of the dirty bitmap
+#define SAVE_MAX_DEFERRED       (60)            //frames in a row with writes before sync() hands off anyway
+
+//flash command sequence : AA to 5555, 55 to 2AAA, then the command to 5555
+#define FLASH_READY             (0)
+#define FLASH_UNLOCK_1          (1)     //AA written
+#define FLASH_UNLOCK_2          (2)     //55 written, the next write to 5555 is a command
+#define FLASH_PROGRAM           (3)     //the next write is the byte to program
+#define FLASH_BANK              (4)     //the next write to 0000 selects the bank
+
+#define FLASH_CMD_ERASE         (0x80)  //arms the erase commands below
+#define FLASH_CMD_ERASE_CHIP    (0x10)
+#define FLASH_CMD_ERASE_SECTOR  (0x30)  //written to the sector instead of 5555
+#define FLASH_CMD_ID_ENTER      (0x90)  //reads of 0000/0001 return the manufacturer and device
+#define FLASH_CMD_ID_EXIT       (0xF0)
+#define FLASH_CMD_PROGRAM       (0xA0)
+#define FLASH_CMD_BANK          (0xB0)
+
+//EEPROM requests, the first two bits of a transfer, followed by the block
+//address, the 64 data bits of a write and a stop bit
+#define EEPROM_REQUEST_READ     (0x3)
+#define EEPROM_REQUEST_WRITE    (0x2)
+#define EEPROM_MAX_BITS         (2 + 14 + 64 + 1)
+#define EEPROM_REPLY_BITS       (4 + 64)        //4 dummy bits, then the block MSB first
+
+
+//game pak save memory behind MEMORY's handlers. SRAM and flash sit in the
+//unmapped save area, for EEPROM the top of the wait state 2 window is
+//unmapped, so only save accesses reach the handlers and the ROM pages and
+//read path stay as they are. construct it after the ROM is loaded, map_rom()
+//maps the EEPROM window back to the ROM
+//
+//write-behind : the emulation thread only updates data and the dirty bitmap.
+//sync(), called once per frame, copies the dirty sectors to pending once the
+//writes stopped for a frame, or after SAVE_MAX_DEFERRED frames of writes in a
+//row, and wakes the writer thread, which writes pending
+//to path.tmp and renames it over path. sync() only try_locks and leaves the
+//hand off to a later frame while a file is being written, so the emulation
+//thread never waits for the disk
+class CARTRIDGE_SAVE
+{
+public:
+    MEMORY *memory;
+    U32 type;
+    U32 size;               //bytes of data in use, EEPROM : 0 until the first request tells the address width
+    U32 rom_size;
+    std::string path;
+
+    U8  *data;              //SAVE_MAX_SIZE bytes from MEMORY::allocate(), emulation thread only
+    U32  dirty;             //bit per 4KB sector written since the last hand off
+    bool written;           //a write since the previous sync()
+    U32  deferred;          //syncs in a row that found written set
+
+    //flash
+    U32  flash_state;       //FLASH_*
+    bool flash_erase;       //FLASH_CMD_ERASE seen, the next command erases
+    bool flash_id;
+    U32  flash_bank;
+
+    //EEPROM : the bits of the request being written, the reply being read
+    U8  eeprom_bits[EEPROM_MAX_BITS];
+    U32 eeprom_count;
+    U32 eeprom_address_bits;    //6 or 14, 0 until known
+    unsigned long long eeprom_reply;
+    U32 eeprom_reply_left;
+
+    //the handlers the save is installed in front of
+    MEMORY::READ_HANDLER  previous_read;
+    MEMORY::WRITE_HANDLER previous_write;
+    void                 *previous_context;
+
+    //statistics
+    U32 handoffs;           //snapshots passed to the writer
+    U32 flushes;            //files written, by the writer thread
+    U32 failures;
+
+    CARTRIDGE_SAVE(MEMORY *memory, U32 type, const std::string &path, U32 rom_size = CARTRIDGE_ROM_WAIT_STATE_0_SIZE);
+    ~CARTRIDGE_SAVE();
+
+    CARTRIDGE_SAVE(const CARTRIDGE_SAVE&) = delete;
+    CARTRIDGE_SAVE &operator=(const CARTRIDGE_SAVE&) = delete;
+
+    //the save type from the library ID string the SDK links into the ROM
+    static U32 detect(const U8 *rom, U32 size);
+
+    //emulation thread, once per frame. never waits
+    void sync();
+
+    //hand off whatever is dirty and wait until it is on disk
+    void flush();
+
+    //-------------------//
+    //-- save memories --//
+    //-------------------//
+    U8   flash_read(U32 offset);
+    void flash_write(U32 offset, U8 value);
+    U8   eeprom_read();
+    void eeprom_write(U8 value);
+    void eeprom_request();
+
+    bool eeprom_address(U32 idx)
+    {
+        return (idx & 0x0F000000) == SAVE_EEPROM_BASE_LOG && (this->rom_size <= 0x01000000 || (idx & 0x0FFFFFFF) >= SAVE_EEPROM_LARGE_ROM);
+    }
+
+    void mark(U32 offset, U32 length)
+    {
+        for (U32 sector = offset >> SAVE_SECTOR_SHIFT; sector <= (offset + length - 1) >> SAVE_SECTOR_SHIFT; sector++)
+        {
+            this->dirty |= 1u << sector;
+        }
+        this->written = true;
+    }
+
+    static U8   handler_read(void *context, U32 idx);
+    static void handler_write(void *context, U32 idx, U8 value);
+
+    //-------------------//
+    //-- writer thread --//
+    //-------------------//
+    std::thread             writer;
+    std::mutex              lock;
+    std::condition_variable wake;       //pending ready or stop
+    std::condition_variable idle;       //a file was written
+    U8                     *pending;    //the image written to disk, SAVE_MAX_SIZE bytes
+    U32                     pending_size;
+    bool                    pending_ready;
+    bool                    writing;    //the writer reads pending outside of the lock
+    bool                    stop;
+
+    //lock held
+    void hand_off();
+    void writer_main();
+    bool write_file(const U8 *bytes, U32 length);
+};